@@ -0,0 +1,315 @@
+/**
+ * @file KernelBench.cpp
+ * @brief pic_bench: micro-benchmarks of the solver's hot kernels.
+ *
+ * Every kernel runs on an n × n all-FLUID grid with a Taylor-Green
+ * velocity field, for each requested grid size and thread count, and is
+ * repeated until @c --min-time has elapsed. The median repetition is
+ * reported as ns per point (face or cell, see Kernel::points) and as the
+ * achieved bandwidth of its compulsory traffic: every array the kernel
+ * streams counted once, see Kernel::bytes.
+ *
+ * ```
+ * pic_bench [--sizes 256,1024] [--threads 1,4] [--kernels div,residual]
+ *           [--min-time 0.2] [--json results.json] [--dir /tmp/pic_bench]
+ * ```
+ * The precision is fixed at compile time; the @c pic_bench target builds
+ * @c pic_bench_double and @c pic_bench_float.
+ */
+#include "../core/OutputWriter.hpp"
+#include "../core/Helpers.hpp"
+#include "../core/Parameters.hpp"
+#include "../solvers/SemiLagrangian/SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * @brief One solver instance of a given size and the kernels run on it
+ *        (a friend of SemiLagrangian).
+ */
+class KernelBench {
+public:
+  /// @brief A timed kernel.
+  struct Kernel {
+    std::string name;
+    double points;             ///< Points processed per call.
+    double bytes;              ///< Compulsory bytes moved per call.
+    std::function<void()> run; ///< One call.
+  };
+
+  KernelBench(int n, const std::string &dir) {
+    params.nx = params.ny = n;
+    params.dx = params.dy = 1.0 / n;
+    params.dt = 0.5 * params.dx; // CFL 0.5 for |u| <= 1
+    params.nt = 1;
+    params.quiet = true;
+    params.write_u = params.write_v = params.write_p = false;
+    params.folder = dir;
+    solver = std::make_unique<SemiLagrangian>(params);
+
+    // Taylor-Green vortex: smooth, divergence free, |u| <= 1.
+    Fields2D &f = solver->GetFields();
+    const double pi = std::acos(-1.0);
+    for (int j = 0; j < f.u.ny; ++j)
+      for (int i = 0; i < f.u.nx; ++i)
+        f.u.Set(i, j,
+                static_cast<varType>(std::sin(pi * i / n) *
+                                     std::cos(pi * (j + 0.5) / n)));
+    for (int j = 0; j < f.v.ny; ++j)
+      for (int i = 0; i < f.v.nx; ++i)
+        f.v.Set(i, j,
+                static_cast<varType>(-std::cos(pi * (i + 0.5) / n) *
+                                     std::sin(pi * j / n)));
+    f.Div(*solver->tiles);
+
+    const std::size_t faces = f.u.A.size() + f.v.A.size();
+    xDep.resize(faces);
+    yDep.resize(faces);
+    interp.resize(faces);
+    pNew = Grid2D(n, n);
+    out = Grid2D(n, n);
+    writer = std::make_unique<OutputWriter>(dir, "bench_p");
+  }
+
+  /// @return The kernels, in report order.
+  std::vector<Kernel> kernels() {
+    SemiLagrangian &s = *solver;
+    Fields2D &f = *s.fields;
+    const double S = sizeof(varType);
+    const double cells = static_cast<double>(f.p.A.size());
+    const double faces = static_cast<double>(xDep.size());
+    const varType coef = s.density * s.dx * s.dx / s.dt;
+
+    return {
+        // Departure-point-like sample of u at every cell: read u, write out.
+        {"interpolate", cells, 2 * S * cells,
+         [&f, this] {
+           const varType dx = f.dx, dy = f.dy;
+#pragma omp parallel for schedule(static)
+           for (int j = 0; j < out.ny; ++j)
+             for (int i = 0; i < out.nx; ++i)
+               out.Set(i, j,
+                       f.u.Interpolate((i + REAL_LITERAL(0.37)) * dx,
+                                       (j + REAL_LITERAL(0.61)) * dy, dx, dy,
+                                       0));
+         }},
+        // RK2 trace of every u and v face: read u, v; write x, y.
+        {"advect_trace", faces, 4 * S * faces,
+         [&s, &f, this] {
+           const int nu = f.u.nx, nv = f.v.nx;
+           const std::size_t off = f.u.A.size();
+#pragma omp parallel for schedule(static)
+           for (int j = 0; j < f.u.ny; ++j)
+             for (int i = 0; i < nu; ++i) {
+               const std::size_t k = static_cast<std::size_t>(j) * nu + i;
+               s.traceParticleU(i, j, xDep[k], yDep[k]);
+             }
+#pragma omp parallel for schedule(static)
+           for (int j = 0; j < f.v.ny; ++j)
+             for (int i = 0; i < nv; ++i) {
+               const std::size_t k =
+                   off + static_cast<std::size_t>(j) * nv + i;
+               s.traceParticleV(i, j, xDep[k], yDep[k]);
+             }
+         }},
+        // Interpolation at the traced points: read x, y, u / v; write one.
+        {"advect_interpolate", faces, 4 * S * faces,
+         [&s, &f, this] {
+           const std::size_t nu = f.u.A.size();
+           const long long total = static_cast<long long>(xDep.size());
+#pragma omp parallel for schedule(static)
+           for (long long k = 0; k < total; ++k)
+             interp[k] = static_cast<std::size_t>(k) < nu
+                           ? s.interpolateU(xDep[k], yDep[k])
+                           : s.interpolateV(xDep[k], yDep[k]);
+         }},
+        // Whole Advect(): copy u, v; read them; write the copies.
+        {"advect", faces, 4 * S * faces, [&s] { s.Advect(); }},
+        // p, div, labels read; pNew written, then copied back into p.
+        {"sweep_jacobi", cells, (5 * S + 2) * cells,
+         [&s, coef, this] { s.sweepJacobi(coef, pNew); }},
+        {"sweep_gauss_seidel", cells, (3 * S + 1) * cells,
+         [&s, coef] { s.sweepGaussSeidel(coef); }},
+        // Each colour streams whole rows of p, div and labels.
+        {"sweep_red_black", cells, 2 * (3 * S + 1) * cells,
+         [&s, coef] { s.sweepRedBlack(coef); }},
+        {"residual", cells, (2 * S + 1) * cells,
+         [&s, coef, this] { sink += s.computeResidualNorm(coef); }},
+        {"div", cells, 3 * S * cells, [&s, &f] { f.Div(*s.tiles); }},
+        // Grid in; the file size is reported separately (bytes_out).
+        {"write_grid", cells, S * cells,
+         [&f, this] { writer->writeGrid2D(f.p, "p"); }},
+    };
+  }
+
+  [[nodiscard]] std::uint64_t bytesWritten() const {
+    return writer->bytesWritten();
+  }
+
+  double sink = 0.0; ///< Keeps reductions observable.
+
+private:
+  Parameters params; ///< Must outlive @c solver.
+  std::unique_ptr<SemiLagrangian> solver;
+  std::vector<varType> xDep, yDep; ///< Departure points of every face.
+  std::vector<varType> interp;     ///< Interpolated values.
+  Grid2D pNew{1, 1}, out{1, 1};
+  std::unique_ptr<OutputWriter> writer;
+};
+
+namespace {
+
+std::vector<int> splitInts(const std::string &s) {
+  std::vector<int> values;
+  for (const std::string &item : splitList(s))
+    values.push_back(std::stoi(item));
+  return values;
+}
+
+void printUsage(const char *prog) {
+  std::cout << "Usage: " << prog
+            << " [--sizes 256,1024] [--threads 1,4] [--kernels a,b]\n"
+               "       [--min-time seconds] [--json file] [--dir folder]\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::vector<int> sizes = {256, 1024};
+  std::vector<int> threads;
+  std::vector<std::string> only;
+  double minTime = 0.2;
+  std::string jsonPath;
+  std::string dir =
+      (std::filesystem::temp_directory_path() / "pic_bench").string();
+
+  for (int k = 1; k < argc; ++k) {
+    const std::string arg = argv[k];
+    const bool hasValue = k + 1 < argc;
+    if (arg == "-h" || arg == "--help") {
+      printUsage(argv[0]);
+      return 0;
+    }
+    if (!hasValue) {
+      std::cerr << "[pic_bench] Missing value for " << arg << '\n';
+      printUsage(argv[0]);
+      return 1;
+    }
+    const std::string value = argv[++k];
+    if (arg == "--sizes")
+      sizes = splitInts(value);
+    else if (arg == "--threads")
+      threads = splitInts(value);
+    else if (arg == "--kernels")
+      only = splitList(value);
+    else if (arg == "--min-time")
+      minTime = std::stod(value);
+    else if (arg == "--json")
+      jsonPath = value;
+    else if (arg == "--dir")
+      dir = value;
+    else {
+      std::cerr << "[pic_bench] Unknown option " << arg << '\n';
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (threads.empty()) {
+    int maxThreads = 1;
+#ifdef _OPENMP
+    maxThreads = omp_get_max_threads();
+#endif
+    threads = {maxThreads};
+  }
+
+#ifdef USE_FLOAT
+  const char *precision = "float";
+#else
+  const char *precision = "double";
+#endif
+  std::filesystem::create_directories(dir);
+
+  nlohmann::json results = nlohmann::json::array();
+  std::cout << "precision: " << precision << "  min-time: " << minTime
+            << " s\n"
+            << std::left << std::setw(20) << "kernel" << std::right
+            << std::setw(7) << "n" << std::setw(8) << "threads"
+            << std::setw(8) << "reps" << std::setw(12) << "ns/point"
+            << std::setw(10) << "GB/s" << '\n';
+
+  double sink = 0.0;
+  for (const int n : sizes) {
+    for (const int t : threads) {
+#ifdef _OPENMP
+      omp_set_num_threads(std::max(1, t));
+#endif
+      KernelBench bench(n, dir);
+      for (const KernelBench::Kernel &kernel : bench.kernels()) {
+        if (!only.empty() &&
+            std::find(only.begin(), only.end(), kernel.name) == only.end())
+          continue;
+
+        const std::uint64_t bytesBefore = bench.bytesWritten();
+        kernel.run(); // warm-up: page faults, first-touch, file creation
+        std::vector<double> times;
+        double total = 0.0;
+        while (times.size() < 3 || (total < minTime && times.size() < 10000)) {
+          const double start = GET_TIME();
+          kernel.run();
+          times.push_back(GET_TIME() - start);
+          total += times.back();
+        }
+        std::sort(times.begin(), times.end());
+        const double median = times[times.size() / 2];
+        const double nsPerPoint = median * 1e9 / kernel.points;
+        const double gbps = kernel.bytes / median * 1e-9;
+
+        std::cout << std::left << std::setw(20) << kernel.name << std::right
+                  << std::setw(7) << n << std::setw(8) << t << std::setw(8)
+                  << times.size() << std::setw(12) << std::setprecision(4)
+                  << nsPerPoint << std::setw(10) << gbps << '\n';
+
+        nlohmann::json r = {{"kernel", kernel.name},
+                            {"n", n},
+                            {"threads", t},
+                            {"precision", precision},
+                            {"reps", times.size()},
+                            {"median_s", median},
+                            {"min_s", times.front()},
+                            {"ns_per_point", nsPerPoint},
+                            {"GBps", gbps}};
+        if (kernel.name == "write_grid")
+          r["bytes_out"] = (bench.bytesWritten() - bytesBefore) /
+                           (times.size() + 1);
+        results.push_back(r);
+      }
+      sink += bench.sink;
+    }
+  }
+
+  if (!jsonPath.empty()) {
+    std::ofstream out(jsonPath);
+    if (!out.is_open()) {
+      std::cerr << "[pic_bench] Cannot write '" << jsonPath << "'\n";
+      return 1;
+    }
+    out << nlohmann::json{{"precision", precision},
+                          {"min_time_s", minTime},
+                          {"results", results}}
+               .dump(2)
+        << '\n';
+  }
+  return std::isnan(sink) ? 1 : 0; // a NaN residual means a broken kernel
+}
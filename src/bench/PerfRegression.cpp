@@ -0,0 +1,304 @@
+/**
+ * @file PerfRegression.cpp
+ * @brief pic_perf: run one scene briefly and compare its speed and final
+ *        fields against a checked-in baseline.
+ *
+ * ```
+ * pic_perf --scene test/test-uniform.json --baseline test/perf-baseline.json
+ *          [--steps N] [--repeats N] [--record]
+ * ```
+ * The scene runs for a reduced number of steps with every file output
+ * switched off, @c repeats times from scratch. Measured: steps/s and
+ * cell-updates/s (median Run() wall time over the repeats), pressure
+ * iterations, peak RSS of the process, and a checksum (sum, L2 norm,
+ * max |x|) of the final u, v, p and smoke. When the repeats spread
+ * (max - min over median) by more than the steps/s tolerance, the machine
+ * is too noisy for the comparison and a warning says so.
+ *
+ * ### Baseline file
+ * ```
+ * { "repeats": 5,
+ *   "tolerances": { "steps_per_s": 0.2, "cell_updates_per_s": 0.2,
+ *                   "iterations": 0.05, "peak_rss_mb": 0.25,
+ *                   "checksum": 1e-6 },
+ *   "scenes": { "<precision>": { "<scene>": {
+ *       "steps": 10, "threads": 8, "repeats": 5,
+ *       "steps_per_s": ..., "spread": ..., ...,
+ *       "checksums": { "u": [sum, l2, max], ... },
+ *       "tolerances": { ... per-scene overrides ... } } } } }
+ * ```
+ * Rates fail when they drop by more than their tolerance, iterations and
+ * RSS when they grow by more than theirs, checksums when any component
+ * differs by more than the relative tolerance. @c --record stores the
+ * measurement as the new baseline of the scene instead of comparing.
+ *
+ * Exit status: 0 pass, 1 regression or error, 77 no baseline for the scene
+ * (CTest reports it as skipped).
+ */
+#include "../core/Helpers.hpp"
+#include "../core/Parameters.hpp"
+#include "../solvers/SemiLagrangian/SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+constexpr int kSkip = 77;   ///< CTest SKIP_RETURN_CODE.
+constexpr int kRepeats = 5; ///< Timed runs when the baseline sets none.
+
+/// @return {sum, L2 norm, max |x|} of @p g, accumulated in double.
+nlohmann::json checksum(const Grid2D &g) {
+  double sum = 0.0, sq = 0.0, mx = 0.0;
+#pragma omp parallel for reduction(+ : sum, sq) reduction(max : mx)
+  for (std::size_t k = 0; k < g.A.size(); ++k) {
+    const double x = g.A[k];
+    sum += x;
+    sq += x * x;
+    mx = std::max(mx, std::abs(x));
+  }
+  return {sum, std::sqrt(sq), mx};
+}
+
+/// @return @c true if @p a and @p b agree to @p rtol relative to the larger
+///         magnitude (absolute 1e-12 near zero).
+bool close(double a, double b, double rtol) {
+  return std::abs(a - b) <= rtol * std::max(std::abs(a), std::abs(b)) + 1e-12;
+}
+
+void printUsage(const char *prog) {
+  std::cout << "Usage: " << prog
+            << " --scene <config.json> --baseline <baseline.json>\n"
+               "       [--steps N] [--repeats N] [--record]\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string scenePath, baselinePath;
+  int steps = 0, repeats = 0;
+  bool record = false;
+  for (int k = 1; k < argc; ++k) {
+    const std::string arg = argv[k];
+    if (arg == "--record") {
+      record = true;
+    } else if (arg == "-h" || arg == "--help") {
+      printUsage(argv[0]);
+      return 0;
+    } else if (k + 1 < argc && arg == "--scene") {
+      scenePath = argv[++k];
+    } else if (k + 1 < argc && arg == "--baseline") {
+      baselinePath = argv[++k];
+    } else if (k + 1 < argc && arg == "--steps") {
+      steps = std::stoi(argv[++k]);
+    } else if (k + 1 < argc && arg == "--repeats") {
+      repeats = std::stoi(argv[++k]);
+    } else {
+      std::cerr << "[pic_perf] Unknown option " << arg << '\n';
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (scenePath.empty() || baselinePath.empty()) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+#ifdef USE_FLOAT
+  const std::string precision = "float";
+#else
+  const std::string precision = "double";
+#endif
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+  const std::string scene = std::filesystem::path(scenePath).stem().string();
+
+  nlohmann::json baseline = nlohmann::json::object();
+  if (std::ifstream in(baselinePath); in.is_open()) {
+    try {
+      in >> baseline;
+    } catch (const std::exception &e) {
+      std::cerr << "[pic_perf] Cannot parse '" << baselinePath
+                << "': " << e.what() << '\n';
+      return 1;
+    }
+  }
+  const nlohmann::json ref =
+      baseline.value("scenes", nlohmann::json::object())
+          .value(precision, nlohmann::json::object())
+          .value(scene, nlohmann::json());
+  if (steps <= 0)
+    steps = ref.is_object() ? ref.value("steps", 10) : 10;
+  if (repeats <= 0)
+    repeats = std::max(1, baseline.value("repeats", kRepeats));
+
+  // The scene as configured, minus everything that writes files.
+  Parameters params;
+  if (!params.loadFromFile(scenePath))
+    return 1;
+  params.nt = steps;
+  params.quiet = true;
+  params.write_u = params.write_v = params.write_p = false;
+  params.write_div = params.write_norm_velocity = params.write_smoke = false;
+  params.folder =
+      (std::filesystem::temp_directory_path() / "pic_perf" / scene).string();
+  params.output.views.clear();
+  params.render.clear();
+  params.checkpoint.every = 0;
+  params.statistics.enabled = false;
+  params.monitors.enabled = false;
+  params.profile.enabled = false;
+  params.solver.log = false;
+
+  // Each repeat starts from a fresh solver; the fields and iteration count
+  // are the same every time, only the wall time varies.
+  nlohmann::json measured;
+  try {
+    std::vector<double> walls;
+    for (int r = 0; r < repeats; ++r) {
+      SemiLagrangian solver(params);
+      const double start = GET_TIME();
+      solver.Run();
+      walls.push_back(GET_TIME() - start);
+      if (r + 1 < repeats)
+        continue;
+
+      std::sort(walls.begin(), walls.end());
+      const std::size_t n = walls.size();
+      const double wall = 0.5 * (walls[(n - 1) / 2] + walls[n / 2]);
+      const Fields2D &f = solver.GetFields();
+      const double cells = static_cast<double>(params.nx) * params.ny;
+      measured = {
+          {"steps", steps},
+          {"threads", threads},
+          {"repeats", repeats},
+          {"steps_per_s", steps / wall},
+          {"cell_updates_per_s", cells * steps / wall},
+          {"spread", (walls.back() - walls.front()) / wall},
+          {"iterations",
+           solver.GetPressureTelemetry().summary()["iterations"]["total"]},
+          {"peak_rss_mb", peakRssMb()},
+          {"checksums",
+           {{"u", checksum(f.u)},
+            {"v", checksum(f.v)},
+            {"p", checksum(f.p)},
+            {"smoke", checksum(f.smokeMap)}}}};
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "[pic_perf] " << scene << ": " << e.what() << '\n';
+    return 1;
+  }
+
+  nlohmann::json tol = baseline.value("tolerances", nlohmann::json::object());
+  if (ref.is_object() && ref.contains("tolerances"))
+    tol.update(ref["tolerances"]);
+  const double spread = measured["spread"].get<double>();
+  if (spread > tol.value("steps_per_s", 0.2)) {
+    std::ostringstream pct;
+    pct << std::fixed << std::setprecision(1) << 100.0 * spread;
+    std::cout << "[pic_perf] Warning: " << scene << " run times spread by "
+              << pct.str() << "% over " << repeats
+              << " repeats, more than the steps/s tolerance; the machine is "
+                 "too noisy for a reliable timing\n";
+  }
+
+  if (record) {
+    if (ref.is_object() && ref.contains("tolerances"))
+      measured["tolerances"] = ref["tolerances"];
+    baseline["scenes"][precision][scene] = measured;
+    if (!baseline.contains("repeats"))
+      baseline["repeats"] = repeats;
+    if (!baseline.contains("tolerances"))
+      baseline["tolerances"] = {{"steps_per_s", 0.2},
+                                {"cell_updates_per_s", 0.2},
+                                {"iterations", 0.05},
+                                {"peak_rss_mb", 0.25},
+                                {"checksum", 1e-6}};
+    std::ofstream out(baselinePath);
+    if (!out.is_open()) {
+      std::cerr << "[pic_perf] Cannot write '" << baselinePath << "'\n";
+      return 1;
+    }
+    out << baseline.dump(2) << '\n';
+    std::cout << "[pic_perf] " << scene << " (" << precision
+              << "): baseline recorded, " << measured["steps_per_s"]
+              << " steps/s\n";
+    return 0;
+  }
+
+  if (!ref.is_object()) {
+    std::cout << "[pic_perf] " << scene << " (" << precision
+              << "): no baseline, run with --record\n";
+    return kSkip;
+  }
+
+  if (ref.value("threads", threads) != threads)
+    std::cout << "[pic_perf] Warning: baseline used " << ref["threads"]
+              << " threads, this run " << threads << '\n';
+
+  bool pass = true;
+  std::cout << scene << " (" << precision << ", " << steps
+            << " steps, median of " << repeats << " runs)\n"
+            << std::left << std::setw(22) << "metric" << std::right
+            << std::setw(14) << "baseline" << std::setw(14) << "measured"
+            << std::setw(10) << "change" << std::setw(10) << "limit"
+            << "  status\n";
+  auto row = [&](const std::string &name, double base, double value,
+                 double limit, bool ok) {
+    const double change = base != 0.0 ? (value - base) / std::abs(base) : 0.0;
+    std::ostringstream pct, lim;
+    pct << std::showpos << std::fixed << std::setprecision(1)
+        << 100.0 * change << '%';
+    lim << std::setprecision(2) << 100.0 * limit << '%';
+    std::cout << std::left << std::setw(22) << name << std::right
+              << std::setprecision(6) << std::setw(14) << base
+              << std::setw(14) << value << std::setw(10) << pct.str()
+              << std::setw(10) << lim.str() << "  " << (ok ? "ok" : "FAIL")
+              << '\n';
+    pass &= ok;
+  };
+
+  // Higher is better for rates, lower for iterations and memory.
+  for (const char *name : {"steps_per_s", "cell_updates_per_s"}) {
+    const double base = ref.value(name, 0.0);
+    const double value = measured[name].get<double>();
+    const double t = tol.value(name, 0.2);
+    row(name, base, value, t, value >= base * (1.0 - t));
+  }
+  for (const char *name : {"iterations", "peak_rss_mb"}) {
+    const double base = ref.value(name, 0.0);
+    const double value = measured[name].get<double>();
+    const double t = tol.value(name, 0.25);
+    row(name, base, value, t, value <= base * (1.0 + t) || base <= 0.0);
+  }
+
+  const double rtol = tol.value("checksum", 1e-6);
+  const nlohmann::json refSums =
+      ref.value("checksums", nlohmann::json::object());
+  for (const auto &[field, sums] : measured["checksums"].items()) {
+    if (!refSums.contains(field))
+      continue;
+    static const char *parts[] = {"sum", "l2", "max"};
+    for (std::size_t k = 0; k < 3; ++k) {
+      const double base = refSums[field][k].get<double>();
+      const double value = sums[k].get<double>();
+      row(field + "." + parts[k], base, value, rtol,
+          close(value, base, rtol));
+    }
+  }
+
+  std::cout << (pass ? "PASS" : "FAIL") << '\n';
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include "AsyncWriter.hpp"
+#include "Precision.hpp"
+#include <algorithm>
+#include <iostream>
+
+const Grid2D &AsyncWriter::Frame::stage(std::size_t k, const Grid2D &src) {
+  if (k < grids_.size())
+    grids_[k] = src; // same shape every step: reuses the allocation
+  else
+    grids_.push_back(src);
+  return grids_[k];
+}
+
+Grid2D &AsyncWriter::Frame::slot(std::size_t k, int nx, int ny) {
+  while (grids_.size() <= k)
+    grids_.emplace_back(nx, ny);
+  Grid2D &g = grids_[k];
+  if (g.nx != nx || g.ny != ny)
+    g = Grid2D(nx, ny);
+  return g;
+}
+
+AsyncWriter::AsyncWriter(int depth) {
+  const int n = std::max(1, depth);
+  for (int k = 0; k < n; ++k) {
+    pool_.push_back(std::make_unique<Frame>());
+    free_.push_back(pool_.back().get());
+  }
+  worker_ = std::thread(&AsyncWriter::run, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+  drain();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    // Nobody is left to rethrow to.
+    if (error_)
+      try {
+        std::rethrow_exception(error_);
+      } catch (const std::exception &e) {
+        std::cerr << "[AsyncWriter] Error: " << e.what() << '\n';
+      } catch (...) {
+        std::cerr << "[AsyncWriter] Error: unknown exception\n";
+      }
+  }
+  cv_.notify_all();
+  worker_.join();
+}
+
+AsyncWriter::Frame &AsyncWriter::acquire(int step) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  lastStall_ = 0.0;
+  if (free_.empty()) {
+    const double start = GET_TIME();
+    cv_.wait(lock, [this] { return !free_.empty(); });
+    lastStall_ = GET_TIME() - start;
+    totalStall_ += lastStall_;
+    ++stalledSteps_;
+  }
+  Frame *f = free_.front();
+  free_.pop_front();
+  f->step = step;
+  f->jobs.clear();
+  return *f;
+}
+
+void AsyncWriter::submit(Frame &frame) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+      free_.push_back(&frame); // hand the frame back unwritten
+      rethrowLocked();
+    }
+    queue_.push_back(&frame);
+  }
+  cv_.notify_all();
+}
+
+void AsyncWriter::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return free_.size() == pool_.size(); });
+  rethrowLocked();
+}
+
+void AsyncWriter::drain() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return free_.size() == pool_.size(); });
+}
+
+void AsyncWriter::rethrowLocked() {
+  if (!error_)
+    return;
+  std::exception_ptr e = error_;
+  error_ = nullptr;
+  std::rethrow_exception(e);
+}
+
+void AsyncWriter::run() {
+  for (;;) {
+    Frame *f = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty())
+        return; // stop_ set and nothing left to write
+      f = queue_.front();
+      queue_.pop_front();
+    }
+
+    // An exception must not leave this thread (std::terminate); keep the
+    // first one for the compute thread and skip the rest of the frame.
+    bool ok = true;
+    std::exception_ptr error;
+    try {
+      for (const auto &job : f->jobs)
+        ok &= job();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    if (!ok)
+      std::cerr << "[AsyncWriter] Warning: failed to write output at step "
+                << f->step << '\n';
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (error && !error_)
+        error_ = error;
+      free_.push_back(f);
+    }
+    cv_.notify_all();
+  }
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "Grid2D.hpp"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file AsyncWriter.hpp
+ * @brief Background output thread fed through a bounded queue of snapshots.
+ */
+
+/**
+ * @brief Runs output jobs on a dedicated thread so compression and disk I/O
+ *        overlap with the next time steps.
+ *
+ * The writer owns a fixed pool of @c depth frames. Each frame holds staging
+ * copies of the fields of one output step plus the jobs that write them:
+ * ```
+ *   compute thread                       writer thread
+ *   Frame &f = acquire(step);   ──┐
+ *   f.stage(0, fields.u) ...      │ queue (≤ depth frames)
+ *   f.jobs.push_back(...)         │
+ *   submit(f);                  ──┴──►   run f.jobs, recycle f
+ * ```
+ * Frames are recycled, so the staging grids are allocated once and memory
+ * stays bounded by @c depth snapshots. When every frame is in flight,
+ * acquire() blocks until the writer releases one; that wait is the stall
+ * time reported by lastStall().
+ *
+ * Jobs run one after another on the writer thread, so the OutputWriter
+ * instances they use must not be touched by the compute thread meanwhile.
+ * An exception thrown by a job ends that frame and is rethrown on the
+ * compute thread by the next submit() or flush().
+ */
+class AsyncWriter {
+public:
+  /// @brief Staging buffers and write jobs of one output step.
+  struct Frame {
+    int step = 0;                            ///< Time step being written.
+    std::vector<std::function<bool()>> jobs; ///< Run in order by the writer.
+
+    /**
+     * @brief Copy @p src into staging slot @p k and return the copy.
+     *
+     * Slots keep their allocation between frames; references to earlier
+     * slots stay valid while later ones are added.
+     */
+    const Grid2D &stage(std::size_t k, const Grid2D &src);
+
+    /// @brief Staging slot @p k resized to @p nx × @p ny, for data derived
+    ///        from the fields rather than copied verbatim.
+    Grid2D &slot(std::size_t k, int nx, int ny);
+
+  private:
+    std::deque<Grid2D> grids_; ///< Staging copies, reused across steps.
+  };
+
+  /// @param depth Number of frames (snapshots in flight), at least 1.
+  explicit AsyncWriter(int depth);
+
+  /// Drains the queue and joins the writer thread.
+  ~AsyncWriter();
+
+  AsyncWriter(const AsyncWriter &) = delete;
+  AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+  /**
+   * @brief Obtain a free frame for @p step, blocking while all frames are
+   *        queued or being written.
+   */
+  Frame &acquire(int step);
+
+  /**
+   * @brief Queue a frame obtained from acquire() for writing.
+   * @throws The first exception a job threw on the writer thread since the
+   *         last submit() / flush() (the frame is not queued then).
+   */
+  void submit(Frame &frame);
+
+  /**
+   * @brief Block until every submitted frame has been written.
+   * @throws The first exception a job threw on the writer thread.
+   */
+  void flush();
+
+  /// @return Seconds the last acquire() waited for a free frame.
+  [[nodiscard]] double lastStall() const { return lastStall_; }
+
+  /// @return Total seconds spent waiting in acquire().
+  [[nodiscard]] double totalStall() const { return totalStall_; }
+
+  /// @return Number of acquire() calls that had to wait.
+  [[nodiscard]] int stalledSteps() const { return stalledSteps_; }
+
+private:
+  std::vector<std::unique_ptr<Frame>> pool_;
+  std::deque<Frame *> free_;  ///< Frames ready for acquire().
+  std::deque<Frame *> queue_; ///< Frames waiting for the writer thread.
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  std::exception_ptr error_; ///< First job exception not yet rethrown.
+
+  double lastStall_ = 0.0;
+  double totalStall_ = 0.0;
+  int stalledSteps_ = 0;
+
+  std::thread worker_; ///< Declared last: starts after the state above.
+
+  /// @brief Writer-thread loop: run queued frames until stopped.
+  void run();
+
+  /// @brief Block until every frame is free again (does not throw).
+  void drain();
+
+  /// @brief Rethrow and clear error_, if set. Call with mutex_ held.
+  void rethrowLocked();
+};
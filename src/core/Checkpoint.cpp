@@ -0,0 +1,216 @@
+#include "Checkpoint.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'I', 'C', 'C', 'K', 'P', 'T', '\0'};
+constexpr std::size_t kAlign = 64;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t realBytes;
+  int32_t nx, ny;
+  int64_t step;
+  double time;
+  uint32_t numSections;
+  uint32_t byteOrder;
+};
+static_assert(sizeof(Header) == 48, "checkpoint header must stay packed");
+
+struct Section {
+  char name[16];
+  uint64_t offset;
+  uint64_t bytes;
+};
+static_assert(sizeof(Section) == 32, "checkpoint section must stay packed");
+
+std::size_t alignUp(std::size_t n) {
+  return (n + kAlign - 1) / kAlign * kAlign;
+}
+
+/// memcpy split over the OpenMP threads: each thread faults in its own
+/// share of the mapping, which is what makes multi-GB restarts fast.
+void parallelCopy(void *dst, const unsigned char *src, std::size_t bytes) {
+  constexpr std::size_t chunk = std::size_t(1) << 22;
+  const auto n = static_cast<long long>((bytes + chunk - 1) / chunk);
+  auto *out = static_cast<unsigned char *>(dst);
+#pragma omp parallel for schedule(static)
+  for (long long k = 0; k < n; ++k) {
+    const std::size_t begin = static_cast<std::size_t>(k) * chunk;
+    std::memcpy(out + begin, src + begin, std::min(chunk, bytes - begin));
+  }
+}
+
+} // namespace
+
+bool Checkpoint::save(const std::string &path, const Fields2D &fields,
+                      const Info &info) {
+  const std::string state = info.state.dump();
+  struct Payload {
+    const char *name;
+    const void *data;
+    std::size_t bytes;
+  };
+  std::vector<Payload> payloads = {
+      {"u", fields.u.A.data(), fields.u.A.size() * sizeof(varType)},
+      {"v", fields.v.A.data(), fields.v.A.size() * sizeof(varType)},
+      {"p", fields.p.A.data(), fields.p.A.size() * sizeof(varType)},
+      {"smoke", fields.smokeMap.A.data(),
+       fields.smokeMap.A.size() * sizeof(varType)},
+      {"labels", fields.Labels().data(), fields.Labels().size()},
+      {"state", state.data(), state.size()},
+  };
+  for (const auto &[name, values] : info.arrays) {
+    if (name.size() >= sizeof(Section::name)) {
+      std::cerr << "[Checkpoint] Array name '" << name << "' is too long\n";
+      return false;
+    }
+    payloads.push_back(
+        {name.c_str(), values.data(), values.size() * sizeof(double)});
+  }
+  const auto numSections = static_cast<uint32_t>(payloads.size());
+
+  Header h{};
+  std::memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kVersion;
+  h.realBytes = sizeof(varType);
+  h.nx = fields.nx;
+  h.ny = fields.ny;
+  h.step = info.step;
+  h.time = info.time;
+  h.numSections = numSections;
+  h.byteOrder = kByteOrder;
+
+  std::vector<Section> table(numSections);
+  const std::size_t tableBytes = table.size() * sizeof(Section);
+  std::size_t offset = alignUp(sizeof(Header) + tableBytes);
+  for (uint32_t k = 0; k < numSections; ++k) {
+    std::strncpy(table[k].name, payloads[k].name, sizeof(table[k].name) - 1);
+    table[k].offset = offset;
+    table[k].bytes = payloads[k].bytes;
+    offset = alignUp(offset + payloads[k].bytes);
+  }
+
+  const std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      std::cerr << "[Checkpoint] Cannot open '" << tmp << "' for writing\n";
+      return false;
+    }
+    static const char zeros[kAlign] = {};
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char *>(table.data()),
+              static_cast<std::streamsize>(tableBytes));
+    std::size_t pos = sizeof(h) + tableBytes;
+    for (uint32_t k = 0; k < numSections; ++k) {
+      out.write(zeros, static_cast<std::streamsize>(table[k].offset - pos));
+      out.write(static_cast<const char *>(payloads[k].data),
+                static_cast<std::streamsize>(payloads[k].bytes));
+      pos = table[k].offset + payloads[k].bytes;
+    }
+    if (!out) {
+      std::cerr << "[Checkpoint] Write to '" << tmp << "' failed\n";
+      return false;
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::cerr << "[Checkpoint] Cannot rename '" << tmp << "' to '" << path
+              << "'\n";
+    return false;
+  }
+  return true;
+}
+
+void Checkpoint::load(const std::string &path, Fields2D &fields, Info &info) {
+  const MappedFile file(path, MappedFile::SEQUENTIAL);
+  if (file.size() < sizeof(Header))
+    throw std::runtime_error("[Checkpoint] '" + path + "' is truncated");
+
+  Header h;
+  std::memcpy(&h, file.data(), sizeof(h));
+  if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0)
+    throw std::runtime_error("[Checkpoint] '" + path +
+                             "' is not a checkpoint");
+  // Version 1 files carry 0 here; the version check below reports them.
+  if (h.byteOrder != kByteOrder && h.byteOrder != 0)
+    throw std::runtime_error("[Checkpoint] '" + path +
+                             "' was written on a host of different byte "
+                             "order");
+  if (h.version != kVersion)
+    throw std::runtime_error("[Checkpoint] '" + path + "' has version " +
+                             std::to_string(h.version) + ", expected " +
+                             std::to_string(kVersion));
+  if (h.realBytes != sizeof(varType))
+    throw std::runtime_error("[Checkpoint] '" + path +
+                             "' was written with a different precision");
+  if (h.nx != fields.nx || h.ny != fields.ny)
+    throw std::runtime_error(
+        "[Checkpoint] '" + path + "' holds a " + std::to_string(h.nx) + " x " +
+        std::to_string(h.ny) + " grid, expected " + std::to_string(fields.nx) +
+        " x " + std::to_string(fields.ny));
+
+  const std::size_t tableEnd =
+      sizeof(Header) + std::size_t(h.numSections) * sizeof(Section);
+  if (file.size() < tableEnd)
+    throw std::runtime_error("[Checkpoint] '" + path + "' is truncated");
+  std::vector<Section> table(h.numSections);
+  std::memcpy(table.data(), file.data() + sizeof(Header),
+              table.size() * sizeof(Section));
+
+  auto find = [&](const char *name, std::size_t expected) -> const Section & {
+    for (const Section &s : table)
+      if (std::strncmp(s.name, name, sizeof(s.name)) == 0) {
+        if (s.offset + s.bytes > file.size() ||
+            (expected != 0 && s.bytes != expected))
+          throw std::runtime_error("[Checkpoint] Section '" +
+                                   std::string(name) + "' of '" + path +
+                                   "' is corrupt");
+        return s;
+      }
+    throw std::runtime_error("[Checkpoint] '" + path + "' has no section '" +
+                             std::string(name) + "'");
+  };
+  auto restore = [&](const char *name, std::vector<varType> &dst) {
+    const Section &s = find(name, dst.size() * sizeof(varType));
+    parallelCopy(dst.data(), file.data() + s.offset, s.bytes);
+  };
+
+  restore("u", fields.u.A);
+  restore("v", fields.v.A);
+  restore("p", fields.p.A);
+  restore("smoke", fields.smokeMap.A);
+  std::vector<uint8_t> &labels = fields.Labels();
+  const Section &l = find("labels", labels.size());
+  parallelCopy(labels.data(), file.data() + l.offset, l.bytes);
+
+  const Section &s = find("state", 0);
+  const auto *text = reinterpret_cast<const char *>(file.data() + s.offset);
+  info.state = s.bytes ? nlohmann::json::parse(text, text + s.bytes)
+                       : nlohmann::json::object();
+
+  static const char *builtin[] = {"u", "v", "p", "smoke", "labels", "state"};
+  info.arrays.clear();
+  for (const Section &sec : table) {
+    const std::string name(sec.name, strnlen(sec.name, sizeof(sec.name)));
+    if (std::find(std::begin(builtin), std::end(builtin), name) !=
+        std::end(builtin))
+      continue;
+    if (sec.offset + sec.bytes > file.size() || sec.bytes % sizeof(double))
+      throw std::runtime_error("[Checkpoint] Section '" + name + "' of '" +
+                               path + "' is corrupt");
+    std::vector<double> &dst = info.arrays[name];
+    dst.resize(sec.bytes / sizeof(double));
+    parallelCopy(dst.data(), file.data() + sec.offset, sec.bytes);
+  }
+  info.step = h.step;
+  info.time = h.time;
+}
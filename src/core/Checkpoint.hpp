@@ -0,0 +1,82 @@
+#pragma once
+#include "Fields.hpp"
+#include <cstdint>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @file Checkpoint.hpp
+ * @brief Versioned binary snapshot of the solver state for restarts.
+ */
+
+/**
+ * @brief Save / restore the prognostic fields of a Fields2D.
+ *
+ * ### File layout (native byte order, version 2)
+ * ```
+ *   char     magic[8]      "PICCKPT\0"
+ *   uint32_t version       kVersion
+ *   uint32_t realBytes     sizeof(varType) of the writer
+ *   int32_t  nx, ny        pressure grid (local grid under MPI)
+ *   int64_t  step          last completed time step
+ *   double   time          simulated time at that step
+ *   uint32_t numSections
+ *   uint32_t byteOrder     kByteOrder as written by the host
+ *   Section  table[numSections]   {char name[16]; uint64_t offset, bytes}
+ *   ...      section payloads, each starting on a 64-byte boundary
+ * ```
+ * Sections: @c "u", @c "v", @c "p", @c "smoke" (raw varType arrays in Grid2D
+ * storage order), @c "labels" (uint8 cell types) and @c "state" (JSON text
+ * holding caller state such as the output-writer counters). Any further
+ * section is an extra named double array from Info::arrays (name of at most
+ * 15 characters).
+ *
+ * Every number is stored in the byte order of the writing host; load()
+ * rejects a file whose @c byteOrder word reads differently, i.e. one
+ * written on a host of the other endianness.
+ *
+ * Because every payload is aligned and stored exactly as it lives in
+ * memory, load() maps the file and copies each section straight into the
+ * destination vector — one parallel memcpy per array, no parsing or
+ * conversion. @c div and @c normVelocity are diagnostics and are recomputed
+ * by the solver instead of being stored.
+ */
+class Checkpoint {
+public:
+  static constexpr uint32_t kVersion = 2; ///< Bumped on layout changes.
+  /// Byte-order marker: reads back as this value only on a host of the
+  /// writer's endianness.
+  static constexpr uint32_t kByteOrder = 0x01020304;
+
+  /// @brief Scalar state stored alongside the fields.
+  struct Info {
+    int64_t step = 0;     ///< Last completed time step.
+    double time = 0.0;    ///< Simulated time at @c step.
+    nlohmann::json state; ///< Free-form caller state (writer counters, ...).
+    /// Extra named double arrays (running statistics, ...), one section
+    /// each.
+    std::map<std::string, std::vector<double>> arrays;
+  };
+
+  /**
+   * @brief Write @p fields and @p info to @p path.
+   *
+   * The file is written to @c \<path\>.tmp and renamed into place, so a run
+   * killed mid-write leaves the previous checkpoint intact.
+   * @return @c true on success.
+   */
+  static bool save(const std::string &path, const Fields2D &fields,
+                   const Info &info);
+
+  /**
+   * @brief Restore @p fields and @p info from the checkpoint at @p path.
+   *
+   * @p fields must already have the grid size stored in the file.
+   * @throws std::runtime_error if the file cannot be mapped, is not a
+   *         checkpoint of this version / precision, or does not match
+   *         @p fields.
+   */
+  static void load(const std::string &path, Fields2D &fields, Info &info);
+};
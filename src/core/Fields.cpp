@@ -1,9 +1,16 @@
 #include "Fields.hpp"
+#include <algorithm>
 #include <cmath>
 
-void Fields2D::Div() {
-  for (int j = 0; j < ny; j++) {
-    for (int i = 0; i < nx; i++) {
+void Fields2D::Div(const TileMap &tiles) {
+#pragma omp parallel for schedule(dynamic)
+  for (int t = 0; t < tiles.numActive(); ++t)
+    Div(tiles.activeRange(t, nx, ny));
+}
+
+void Fields2D::Div(const TileMap::Range &r) {
+  for (int j = r.j0; j < r.j1; j++) {
+    for (int i = r.i0; i < r.i1; i++) {
       const varType dudx = (u.Get(i + 1, j) - u.Get(i, j)) / dx;
       const varType dvdy = (v.Get(i, j + 1) - v.Get(i, j)) / dy;
       div.Set(i, j, dudx + dvdy);
@@ -11,12 +18,16 @@ void Fields2D::Div() {
   }
 }
 
-void Fields2D::VelocityNormCenterGrid() {
-  // Interpolate u and v from their staggered positions to cell centres, then
-  // store the magnitude. The loop stops at nx-1 / ny-1 because the
-  // cell-centre sample point (i + 0.5)*dx requires one ghost layer.
-  for (int j = 0; j < ny - 1; j++) {
-    for (int i = 0; i < nx - 1; i++) {
+void Fields2D::VelocityNormCenterGrid(const TileMap &tiles) {
+#pragma omp parallel for schedule(dynamic)
+  for (int t = 0; t < tiles.numActive(); ++t)
+    VelocityNormCenterGrid(
+        tiles.activeRange(t, normVelocity.nx, normVelocity.ny));
+}
+
+void Fields2D::VelocityNormCenterGrid(const TileMap::Range &r) {
+  for (int j = r.j0; j < r.j1; j++) {
+    for (int i = r.i0; i < r.i1; i++) {
       const varType x = (static_cast<varType>(i) + REAL_LITERAL(0.5)) * dx;
       const varType y = (static_cast<varType>(j) + REAL_LITERAL(0.5)) * dy;
 
@@ -30,10 +41,13 @@ void Fields2D::VelocityNormCenterGrid() {
 
 void Fields2D::SolidCylinder(int cx, int cy, int r) {
   const int r2 = r * r;
-  for (int j = 0; j < ny; j++) {
-    for (int i = 0; i < nx; i++) {
-      const int ddx = i - cx;
-      const int ddy = j - cy;
+  // Only the bounding box of the disc, clipped to this (local) grid.
+  const int jMax = std::min(cy + r - originJ, ny - 1);
+  const int iMax = std::min(cx + r - originI, nx - 1);
+  for (int j = std::max(cy - r - originJ, 0); j <= jMax; j++) {
+    for (int i = std::max(cx - r - originI, 0); i <= iMax; i++) {
+      const int ddx = i + originI - cx;
+      const int ddy = j + originJ - cy;
       if (ddx * ddx + ddy * ddy <= r2)
         SetLabel(i, j, SOLID);
     }
@@ -1,5 +1,6 @@
 #pragma once
 #include "Grid2D.hpp"
+#include "TileMap.hpp"
 #include <cstdint>
 #include <vector>
 
@@ -30,7 +31,9 @@ public:
   /// @brief Possible states for a grid cell.
   enum CellType : uint8_t {
     FLUID = 0, ///< Active fluid cell, participates in the pressure solve.
-    SOLID = 1  ///< Solid (obstacle / wall) cell, velocity is fixed.
+    SOLID = 1, ///< Solid (obstacle / wall) cell, velocity is fixed.
+    FIXED = 2  ///< Fluid cell with prescribed pressure (AMR ghost ring): not
+               ///< solved for, but not a wall either.
   };
 
   int nx;          ///< Number of pressure cells in x.
@@ -53,6 +56,12 @@ public:
   /// boundaries in future work.
   varType usolid = REAL_LITERAL(0.0);
 
+  /// Global index of local cell (0, 0). Non-zero only when the domain is
+  /// split over MPI ranks; scene geometry is given in global indices and
+  /// shifted by this origin when applied.
+  int originI = 0;
+  int originJ = 0;
+
   /**
    * @brief Construct all fields and zero-initialise them.
    * @param nx      Number of pressure cells in x.
@@ -88,6 +97,13 @@ public:
     labels[idx(i, j)] = static_cast<uint8_t>(t);
   }
 
+  /// @brief Raw label array (same layout as @c p), for bulk I/O such as
+  ///        checkpoints.
+  [[nodiscard]] const std::vector<uint8_t> &Labels() const { return labels; }
+  [[nodiscard]] std::vector<uint8_t> &Labels() {
+    return labels;
+  } ///< Mutable raw label array.
+
   // Field update methods
   /**
    * @brief Compute the discrete divergence \f$\nabla \cdot \mathbf{u} \f$ into
@@ -98,14 +114,23 @@ public:
  *   \mathrm{div}(i,j) = \frac{u(i+1,j) - u(i,j)}{\Delta x}
  *                     + \frac{v(i,j+1) - v(i,j)}{\Delta y}
  * \f$
+   * on the ACTIVE tiles of @p tiles only (parallel over tiles).
    */
-  void Div();
+  void Div(const TileMap &tiles);
+
+  /// @brief Div() on one tile range of the nx × ny cell grid (serial).
+  void Div(const TileMap::Range &r);
 
   /**
    * @brief Interpolate the velocity magnitude |u| to cell centres and store
-   *        the result in @c normVelocity.
+   *        the result in @c normVelocity, on the ACTIVE tiles of @p tiles
+   *        only (parallel over tiles).
    */
-  void VelocityNormCenterGrid();
+  void VelocityNormCenterGrid(const TileMap &tiles);
+
+  /// @brief VelocityNormCenterGrid() on one tile range of the
+  ///        @c normVelocity grid (serial).
+  void VelocityNormCenterGrid(const TileMap::Range &r);
 
   // Geometry helpers
 
@@ -0,0 +1,44 @@
+#include "Helpers.hpp"
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+std::vector<std::string> splitList(const std::string &s) {
+  std::vector<std::string> items;
+  std::stringstream list(s);
+  for (std::string item; std::getline(list, item, ',');)
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+double peakRssMb() {
+#if defined(__unix__) || defined(__APPLE__)
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0.0;
+#ifdef __APPLE__
+  return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0); // bytes
+#else
+  return static_cast<double>(usage.ru_maxrss) / 1024.0; // KiB
+#endif
+#else
+  return 0.0;
+#endif
+}
+
+std::ofstream openCsvForRestart(const std::string &path, int firstStep) {
+  std::string kept;
+  if (std::ifstream in(path); in.is_open()) {
+    for (std::string line; std::getline(in, line);) {
+      std::istringstream row(line);
+      long long step = 0;
+      if (!(row >> step) || step < firstStep)
+        kept += line + '\n'; // header, or a row before the restart
+    }
+  }
+  std::ofstream(path, std::ios::trunc) << kept;
+  return std::ofstream(path, std::ios::app);
+}
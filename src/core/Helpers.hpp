@@ -0,0 +1,25 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @file Helpers.hpp
+ * @brief Small utilities shared by the command line, the drivers and the
+ *        benchmarks.
+ */
+
+/// @brief Split a comma-separated list, dropping empty items:
+///        "a,b,,c" -> {"a", "b", "c"}.
+[[nodiscard]] std::vector<std::string> splitList(const std::string &s);
+
+/// @return Peak resident set size of this process in MiB (0 if unknown).
+[[nodiscard]] double peakRssMb();
+
+/// @brief Reopen the CSV time series @p path for a run restarted at
+///        @p firstStep: the header and the rows of steps before
+///        @p firstStep are kept, later rows are dropped, and the file is
+///        opened for appending. A missing file gives an empty one.
+/// @return The stream; check @c is_open().
+[[nodiscard]] std::ofstream openCsvForRestart(const std::string &path,
+                                              int firstStep);
@@ -0,0 +1,176 @@
+#include "LossyCodec.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// Quantisation
+
+LossyCodec::Quantised LossyCodec::quantise(const varType *values,
+                                           std::size_t n,
+                                           const ErrorBound &bound) {
+  Quantised out;
+  if (n == 0 || !bound.enabled())
+    return out;
+
+  double lo = values[0], hi = values[0];
+  bool finite = true;
+#pragma omp parallel for reduction(min : lo) reduction(max : hi) reduction(&& : finite)
+  for (std::size_t k = 0; k < n; ++k) {
+    const double x = values[k];
+    finite = finite && std::isfinite(x);
+    lo = std::min(lo, x);
+    hi = std::max(hi, x);
+  }
+  if (!finite)
+    return out;
+
+  // Tightest of the requested bounds. For a constant field the relative
+  // bound falls back to the magnitude of the value.
+  double eps = bound.absolute > 0.0 ? bound.absolute : HUGE_VAL;
+  if (bound.relative > 0.0) {
+    const double range = hi - lo;
+    eps = std::min(eps, range > 0.0
+                            ? bound.relative * range
+                            : bound.relative * std::max(std::abs(hi), 1.0));
+  }
+  const int e = static_cast<int>(std::floor(std::log2(2.0 * eps)));
+  if (e < -1000 || e > 1000)
+    return out;
+  const double step = std::ldexp(1.0, e);
+
+  const double maxAbs = std::max(std::abs(lo), std::abs(hi));
+  if (maxAbs / step >= 9.0e18) // codes would overflow int64
+    return out;
+
+  out.step = step;
+  out.code.resize(n);
+#pragma omp parallel for schedule(static)
+  for (std::size_t k = 0; k < n; ++k)
+    out.code[k] = std::llround(values[k] / step);
+
+  // q·2^e is exact in float32 when |q| < 2^24 and the result stays within
+  // the float exponent range.
+  out.float32Exact = maxAbs / step < 16777215.0 && e > -126 && e < 100;
+  return out;
+}
+
+// Lorenzo sidecar
+
+namespace {
+
+void putBytes(std::vector<unsigned char> &buf, const void *p, std::size_t n) {
+  const auto *b = static_cast<const unsigned char *>(p);
+  buf.insert(buf.end(), b, b + n);
+}
+
+template <typename T> T getBytes(const std::vector<unsigned char> &buf,
+                                 std::size_t &pos) {
+  if (pos + sizeof(T) > buf.size())
+    throw std::runtime_error("LossyCodec: truncated sidecar");
+  T v;
+  std::memcpy(&v, buf.data() + pos, sizeof(T));
+  pos += sizeof(T);
+  return v;
+}
+
+} // namespace
+
+std::vector<unsigned char> LossyCodec::encodeLorenzo(const Quantised &q,
+                                                     int nx, int ny) {
+  auto at = [&](int i, int j) -> int64_t {
+    return (i < 0 || j < 0) ? 0 : q.code[static_cast<std::size_t>(nx) * j + i];
+  };
+
+  // Residuals are small integers on smooth data: zigzag + LEB128 varint.
+  std::vector<unsigned char> stream;
+  stream.reserve(static_cast<std::size_t>(nx) * ny);
+  for (int j = 0; j < ny; ++j)
+    for (int i = 0; i < nx; ++i) {
+      const int64_t r =
+          at(i, j) - at(i - 1, j) - at(i, j - 1) + at(i - 1, j - 1);
+      uint64_t z = (static_cast<uint64_t>(r) << 1) ^ static_cast<uint64_t>(r >> 63);
+      while (z >= 0x80) {
+        stream.push_back(static_cast<unsigned char>(z | 0x80));
+        z >>= 7;
+      }
+      stream.push_back(static_cast<unsigned char>(z));
+    }
+
+  std::vector<unsigned char> packed;
+#ifdef HAVE_ZLIB
+  uLongf len = compressBound(static_cast<uLong>(stream.size()));
+  packed.resize(len);
+  if (compress2(packed.data(), &len, stream.data(),
+                static_cast<uLong>(stream.size()), Z_BEST_COMPRESSION) != Z_OK)
+    throw std::runtime_error("LossyCodec: zlib compress2 failed");
+  packed.resize(len);
+#else
+  packed = stream;
+#endif
+
+  std::vector<unsigned char> out;
+  putBytes(out, "PLZ1", 4);
+  const uint32_t dims[2] = {static_cast<uint32_t>(nx), static_cast<uint32_t>(ny)};
+  putBytes(out, dims, sizeof(dims));
+  putBytes(out, &q.step, sizeof(double));
+  const uint64_t rawBytes = stream.size();
+  putBytes(out, &rawBytes, sizeof(rawBytes));
+  const uint32_t compBytes = static_cast<uint32_t>(packed.size());
+  putBytes(out, &compBytes, sizeof(compBytes));
+  putBytes(out, packed.data(), packed.size());
+  return out;
+}
+
+std::vector<double>
+LossyCodec::decodeLorenzo(const std::vector<unsigned char> &bytes) {
+  std::size_t pos = 0;
+  if (bytes.size() < 4 || std::memcmp(bytes.data(), "PLZ1", 4) != 0)
+    throw std::runtime_error("LossyCodec: not a PLZ1 sidecar");
+  pos = 4;
+  const auto nx = getBytes<uint32_t>(bytes, pos);
+  const auto ny = getBytes<uint32_t>(bytes, pos);
+  const auto step = getBytes<double>(bytes, pos);
+  const auto rawBytes = getBytes<uint64_t>(bytes, pos);
+  const auto compBytes = getBytes<uint32_t>(bytes, pos);
+  if (pos + compBytes > bytes.size())
+    throw std::runtime_error("LossyCodec: truncated sidecar");
+
+  std::vector<unsigned char> stream(rawBytes);
+#ifdef HAVE_ZLIB
+  uLongf len = static_cast<uLongf>(rawBytes);
+  if (uncompress(stream.data(), &len, bytes.data() + pos, compBytes) != Z_OK ||
+      len != rawBytes)
+    throw std::runtime_error("LossyCodec: zlib uncompress failed");
+#else
+  std::memcpy(stream.data(), bytes.data() + pos, rawBytes);
+#endif
+
+  std::vector<int64_t> q(static_cast<std::size_t>(nx) * ny);
+  auto at = [&](int i, int j) -> int64_t {
+    return (i < 0 || j < 0) ? 0 : q[static_cast<std::size_t>(nx) * j + i];
+  };
+  std::size_t s = 0;
+  for (int j = 0; j < static_cast<int>(ny); ++j)
+    for (int i = 0; i < static_cast<int>(nx); ++i) {
+      uint64_t z = 0;
+      for (int shift = 0; s < stream.size(); shift += 7) {
+        const unsigned char b = stream[s++];
+        z |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80))
+          break;
+      }
+      const int64_t r = static_cast<int64_t>(z >> 1) ^ -static_cast<int64_t>(z & 1);
+      q[static_cast<std::size_t>(nx) * j + i] =
+          r + at(i - 1, j) + at(i, j - 1) - at(i - 1, j - 1);
+    }
+
+  std::vector<double> values(q.size());
+  for (std::size_t k = 0; k < q.size(); ++k)
+    values[k] = static_cast<double>(q[k]) * step;
+  return values;
+}
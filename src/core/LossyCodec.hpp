@@ -0,0 +1,84 @@
+#pragma once
+#include "Precision.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @file LossyCodec.hpp
+ * @brief Error-bounded quantisation and Lorenzo predictive coding of output
+ *        fields.
+ */
+
+/**
+ * @brief Pointwise error bound of one output field.
+ *
+ * Either an absolute bound, or a bound relative to the value range
+ * (max - min) of the field at the time it is written. Both zero = lossless.
+ */
+struct ErrorBound {
+  double absolute = 0.0; ///< |x - x'| <= absolute.
+  double relative = 0.0; ///< |x - x'| <= relative * (max - min).
+
+  /// @return @c true if a bound is set.
+  [[nodiscard]] bool enabled() const { return absolute > 0.0 || relative > 0.0; }
+};
+
+/**
+ * @brief In-tree SZ-style lossy codec for output payloads.
+ *
+ * ### Quantisation
+ * Each value is rounded to a multiple of a power-of-two step
+ * \f$ s = 2^{\lfloor \log_2 2\varepsilon \rfloor} \le 2\varepsilon \f$, so
+ * \f$ |x - q s| \le s/2 \le \varepsilon \f$. Because @e s is a power of two
+ * and @f$|q| < 2^{24}@f$, the dequantised value @f$ q s @f$ is exact in
+ * float32: the VTI stores a plain Float32 array (readable by any VTK tool)
+ * whose low mantissa bits are zero, which zlib then compresses well.
+ *
+ * ### Predictive sidecar (optional)
+ * The integer codes can additionally be written with a 2-D Lorenzo
+ * predictor, which is where most of the gain comes from on smooth fields:
+ * ```
+ *   r(i,j) = q(i,j) - q(i-1,j) - q(i,j-1) + q(i-1,j-1)     (q = 0 outside)
+ * ```
+ * Sidecar layout (little endian):
+ * ```
+ *   char     magic[4]   "PLZ1"
+ *   uint32_t nx, ny
+ *   double   step       value = q * step
+ *   uint64_t rawBytes   length of the varint stream
+ *   uint32_t compBytes  length of the zlib stream (== rawBytes without zlib)
+ *   byte[]   zlib( zigzag-varint(r) for j { for i } )
+ * ```
+ * A reader inflates the stream, undoes zigzag/varint, then rebuilds
+ * @e q row by row with the recurrence above and multiplies by @e step.
+ */
+class LossyCodec {
+public:
+  /// @brief Result of quantising one array.
+  struct Quantised {
+    double step = 0.0;         ///< Quantisation step (power of two).
+    std::vector<int64_t> code; ///< Integer codes, value = code * step.
+    bool float32Exact = false; ///< Every code * step is exact in float32.
+  };
+
+  /**
+   * @brief Quantise @p n values under @p bound.
+   * @return Codes and step; @c step == 0 if the data cannot be quantised
+   *         (non-finite values or a degenerate bound), in which case the
+   *         caller should write it losslessly.
+   */
+  [[nodiscard]] static Quantised quantise(const varType *values, std::size_t n,
+                                          const ErrorBound &bound);
+
+  /**
+   * @brief Lorenzo-predict, zigzag/varint and (if available) zlib the codes
+   *        of an @p nx × @p ny array into the sidecar layout above.
+   */
+  [[nodiscard]] static std::vector<unsigned char>
+  encodeLorenzo(const Quantised &q, int nx, int ny);
+
+  /// @brief Inverse of encodeLorenzo(); returns the dequantised values.
+  [[nodiscard]] static std::vector<double>
+  decodeLorenzo(const std::vector<unsigned char> &bytes);
+};
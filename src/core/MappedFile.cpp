@@ -0,0 +1,61 @@
+#include "MappedFile.hpp"
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+
+MappedFile::MappedFile(const std::string &path, Access access) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("[MappedFile] Cannot open '" + path + "'");
+  struct stat st {};
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("[MappedFile] Cannot stat '" + path + "'");
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ > 0) {
+    void *p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("[MappedFile] Cannot map '" + path + "'");
+    }
+    data_ = static_cast<const unsigned char *>(p);
+    // Advice values are not flags and cannot be OR-ed: one call each.
+    if (access == SEQUENTIAL) {
+      madvise(p, size_, MADV_SEQUENTIAL);
+      madvise(p, size_, MADV_WILLNEED);
+    }
+  }
+  close(fd); // the mapping keeps the file referenced
+}
+
+MappedFile::~MappedFile() {
+  if (data_)
+    munmap(const_cast<unsigned char *>(data_), size_);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path, Access /*access*/) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("[MappedFile] Cannot open '" + path + "'");
+  copy_.assign(std::istreambuf_iterator<char>(in),
+               std::istreambuf_iterator<char>());
+  data_ = copy_.data();
+  size_ = copy_.size();
+}
+
+MappedFile::~MappedFile() = default;
+
+#endif
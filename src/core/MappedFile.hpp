@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @file MappedFile.hpp
+ * @brief Read-only memory mapping of a whole file.
+ */
+
+/**
+ * @brief Maps a file read-only into memory for its lifetime.
+ *
+ * Pages are loaded by the kernel on first touch, so a reader that only
+ * looks at part of the file (one MPI block of a mask, say) never reads the
+ * rest, and concurrent readers share the page cache. A reader that
+ * consumes the whole file front to back (a checkpoint) asks for
+ * @c SEQUENTIAL access instead: the mapping is advised both
+ * @c MADV_SEQUENTIAL (aggressive read-ahead, early release of read pages)
+ * and @c MADV_WILLNEED (start reading now). On
+ * systems without @c mmap the file is read into memory.
+ */
+class MappedFile {
+public:
+  /// @brief Expected access pattern, passed to the kernel as a hint.
+  enum Access {
+    ON_DEMAND, ///< Pages are read as they are touched.
+    SEQUENTIAL ///< Read in order: sequential read-ahead, prefetched at once.
+  };
+
+  /// @throws std::runtime_error if @p path cannot be opened or mapped.
+  explicit MappedFile(const std::string &path, Access access = ON_DEMAND);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /// @return First byte of the file.
+  [[nodiscard]] const unsigned char *data() const { return data_; }
+
+  /// @return File size in bytes.
+  [[nodiscard]] std::size_t size() const { return size_; }
+
+private:
+  const unsigned char *data_ = nullptr;
+  std::size_t size_ = 0;
+  std::vector<unsigned char> copy_; ///< Fallback storage without mmap.
+};
@@ -1,6 +1,11 @@
 #include "OutputWriter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <filesystem>
 #include <iomanip>
+#include <iostream>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 
@@ -13,17 +18,29 @@ namespace fs = std::filesystem;
 // OutputWriter
 
 OutputWriter::OutputWriter(const std::string &output_dir,
-                           const std::string &pvd_name)
+                           const std::string &pvd_name,
+                           const WriterOptions &options)
     : output_dir_(output_dir), base_name_(pvd_name), current_step_(0),
-      pvd_finalised_(false) {
+      pvd_finalised_(false), options_(options) {
   fs::create_directories(output_dir_);
+  if (options_.series)
+    series_ = options_.seriesFile
+                  ? options_.seriesFile
+                  : std::make_shared<SeriesFile>(base_name_ + ".bin");
 }
 
 OutputWriter::~OutputWriter() {
   // Guarantee the PVD index is always written even if the caller forgets to
   // call finalisePVD() explicitly.
-  if (!pvd_finalised_ && !pvd_entries_.empty())
-    finalisePVD();
+  // A destructor must not throw: report instead (this also runs while an
+  // earlier output error unwinds the solver).
+  if (!pvd_finalised_ && !pvd_entries_.empty()) {
+    try {
+      finalisePVD();
+    } catch (const std::exception &e) {
+      std::cerr << "[OutputWriter] Error: " << e.what() << '\n';
+    }
+  }
 }
 
 // Private helpers
@@ -31,7 +48,8 @@ OutputWriter::~OutputWriter() {
 // Internal helpers
 
 /**
- * @brief Write a 4-byte little-endian unsigned integer to a binary stream.
+ * @brief Write a 4-byte unsigned integer, in host byte order (see
+ *        byteOrder()), to a binary stream.
  *
  * ParaView uses uint32_t header words to locate appended data by offset, so
  * every length field in the VTK binary block must be exactly 4 bytes.
@@ -42,6 +60,39 @@ OutputWriter::~OutputWriter() {
 static void writeU32(std::ofstream &out, uint32_t v) {
   out.write(reinterpret_cast<const char *>(&v), sizeof(v));
 }
+/**
+ * @brief Format a real attribute value, keeping a decimal point on integral
+ *        values ("1.0", "0.025") as in the original headers.
+ */
+static std::string formatReal(double v) {
+  std::ostringstream oss;
+  oss << std::setprecision(15) << v;
+  std::string s = oss.str();
+  if (s.find_first_of(".e") == std::string::npos)
+    s += ".0";
+  return s;
+}
+
+/// @brief Opening tags of the .pvd, or of the .xmf in series mode.
+static std::string indexHeader(const std::string &name, bool series) {
+  if (!series)
+    return "<VTKFile type=\"Collection\" version=\"0.1\""
+           " byte_order=\"LittleEndian\">\n"
+           "  <Collection>\n";
+  return "<?xml version=\"1.0\" ?>\n"
+         "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n"
+         "<Xdmf Version=\"2.0\">\n"
+         "  <Domain>\n"
+         "    <Grid Name=\"" +
+         name + "\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+}
+
+/// @brief Closing tags matching indexHeader().
+static const char *indexFooter(bool series) {
+  return series ? "    </Grid>\n  </Domain>\n</Xdmf>\n"
+                : "  </Collection>\n</VTKFile>\n";
+}
+
 std::string OutputWriter::formatFilename(const std::string &field_name,
                                          int step) const {
   // Zero-pad the step number to four digits: "u_0042.vti"
@@ -56,61 +107,288 @@ void OutputWriter::appendPVDEntry(const std::string &vti_filename,
   std::ostringstream oss;
   oss << "      <DataSet timestep=\"" << std::fixed << std::setprecision(6)
       << time_value << "\" file=\"" << vti_filename << "\"/>\n";
-  pvd_entries_.push_back(oss.str());
+  appendIndexEntry(oss.str());
+}
+
+std::string OutputWriter::indexPath() const {
+  return output_dir_ + "/" + base_name_ + (options_.series ? ".xmf" : ".pvd");
+}
+
+void OutputWriter::appendIndexEntry(const std::string &entry) {
+  pvd_entries_.push_back(entry);
+  if (index_end_ < 0) {
+    rewriteIndex();
+    return;
+  }
+
+  // Overwrite the closing tags with the new entry and put them back after
+  // it: the file only grows, and is well-formed after every frame.
+  std::fstream out(indexPath(),
+                   std::ios::in | std::ios::out | std::ios::binary);
+  if (!out.is_open()) {
+    rewriteIndex();
+    return;
+  }
+  out.seekp(index_end_);
+  out << entry;
+  index_end_ = out.tellp();
+  out << indexFooter(options_.series);
+  out.flush();
 }
 
-std::vector<unsigned char>
-OutputWriter::preparePayload(const std::vector<varType> &values) {
-  const std::size_t rawBytes = values.size() * sizeof(varType);
-  const auto *rawPtr = reinterpret_cast<const unsigned char *>(values.data());
+void OutputWriter::rewriteIndex() {
+  const std::string path = indexPath();
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open())
+    throw std::runtime_error("OutputWriter: cannot open index file: " + path);
+
+  out << indexHeader(base_name_, options_.series);
+  for (const auto &entry : pvd_entries_)
+    out << entry;
+  index_end_ = out.tellp();
+  out << indexFooter(options_.series);
+}
+
+OutputWriter::Payload OutputWriter::preparePayload(const void *data,
+                                                   std::size_t bytes) const {
+  const auto *raw = static_cast<const unsigned char *>(data);
+  return preparePayload(bytes, 1,
+                        [raw](std::size_t first, std::size_t count,
+                              unsigned char *dst) {
+                          std::memcpy(dst, raw + first, count);
+                        });
+}
+
+OutputWriter::Payload OutputWriter::preparePayload(std::size_t count,
+                                                   std::size_t elemBytes,
+                                                   const Fill &fill) const {
+  const std::size_t rawBytes = count * elemBytes;
+  Payload out;
 
 #ifdef HAVE_ZLIB
-  // zlib: compress at Z_BEST_SPEED to minimise I/O size with low CPU cost.
-  uLongf compBound = compressBound(static_cast<uLong>(rawBytes));
-  std::vector<unsigned char> buf(compBound);
-  uLongf compLen = compBound;
-
-  const int ret = compress2(buf.data(), &compLen, rawPtr,
-                            static_cast<uLong>(rawBytes), Z_BEST_SPEED);
-  if (ret != Z_OK)
+  // Independent blocks so they can be compressed concurrently; the reader
+  // inflates each one separately. Blocks hold whole elements, so each one
+  // is converted straight into a per-thread buffer and compressed.
+  const std::size_t bs =
+      std::max(options_.blockSize / elemBytes, std::size_t(1)) * elemBytes;
+  const std::size_t last = rawBytes % bs;
+  const int numBlocks =
+      std::max(1, static_cast<int>(rawBytes / bs + (last ? 1 : 0)));
+  const int level = std::clamp(options_.compressionLevel, 0, 9);
+
+  std::vector<std::vector<unsigned char>> blocks(numBlocks);
+  bool failed = false;
+#pragma omp parallel reduction(|| : failed)
+  {
+    std::vector<unsigned char> raw(std::min(bs, rawBytes));
+#pragma omp for schedule(dynamic)
+    for (int b = 0; b < numBlocks; ++b) {
+      const std::size_t begin = static_cast<std::size_t>(b) * bs;
+      const std::size_t len =
+          std::min(bs, rawBytes - std::min(begin, rawBytes));
+      if (len > 0)
+        fill(begin / elemBytes, len / elemBytes, raw.data());
+      uLongf compLen = compressBound(static_cast<uLong>(len));
+      blocks[b].resize(compLen);
+      if (compress2(blocks[b].data(), &compLen, raw.data(),
+                    static_cast<uLong>(len), level) != Z_OK)
+        failed = true;
+      blocks[b].resize(compLen); // trim to actual compressed size
+    }
+  }
+  if (failed)
     throw std::runtime_error("OutputWriter: zlib compress2 failed");
 
-  buf.resize(compLen); // trim to actual compressed size
-  return buf;
+  out.header = {static_cast<uint32_t>(numBlocks), static_cast<uint32_t>(bs),
+                static_cast<uint32_t>(last)};
+  std::size_t total = 0;
+  for (const auto &b : blocks) {
+    out.header.push_back(static_cast<uint32_t>(b.size()));
+    total += b.size();
+  }
+  out.data.reserve(total);
+  for (const auto &b : blocks)
+    out.data.insert(out.data.end(), b.begin(), b.end());
 #else
-  // No compression: return a verbatim copy of the raw bytes.
-  return std::vector<unsigned char>(rawPtr, rawPtr + rawBytes);
+  // No compression: a single word with the byte count, then the raw bytes,
+  // converted in parallel chunks directly into the payload.
+  out.header = {static_cast<uint32_t>(rawBytes)};
+  out.data.resize(rawBytes);
+  constexpr std::size_t chunk = 1 << 16;
+  const auto n = static_cast<long long>((count + chunk - 1) / chunk);
+#pragma omp parallel for schedule(static)
+  for (long long k = 0; k < n; ++k) {
+    const std::size_t first = static_cast<std::size_t>(k) * chunk;
+    fill(first, std::min(chunk, count - first),
+         out.data.data() + first * elemBytes);
+  }
 #endif
+  return out;
 }
 
-// Public
+namespace {
 
-bool OutputWriter::writeGrid2D(const Grid2D &grid, const std::string &id) {
-  if (pvd_finalised_)
-    return false;
+/**
+ * @brief Apply @p op to elements [first, first + count) of the cells
+ *        @p range of @p g (x fastest) and store the results in @p dst.
+ *
+ * Works on whole row runs of the Grid2D storage, so the inner loop is a
+ * plain contiguous conversion the compiler can vectorise.
+ */
+template <class Out, class Op>
+void convertRows(const Grid2D &g, const std::array<int, 4> &range,
+                 std::size_t first, std::size_t count, unsigned char *dst,
+                 Op op) {
+  const auto [ib, ie, jb, je] = range;
+  const std::size_t w = static_cast<std::size_t>(ie - ib);
+  auto *out = reinterpret_cast<Out *>(dst);
+  while (count > 0) {
+    const std::size_t j = jb + first / w;
+    const std::size_t i = ib + first % w;
+    const std::size_t run = std::min(count, static_cast<std::size_t>(ie) - i);
+    const varType *src = g.A.data() + j * static_cast<std::size_t>(g.nx) + i;
+    for (std::size_t k = 0; k < run; ++k)
+      out[k] = op(src[k]);
+    out += run;
+    first += run;
+    count -= run;
+  }
+}
 
-  const int nx = grid.nx;
-  const int ny = grid.ny;
-  const uint32_t rawBytes = static_cast<uint32_t>(static_cast<std::size_t>(nx) *
-                                                  ny * sizeof(varType));
+} // namespace
 
-  // Collect grid data in VTK x-fastest (row-major) order.
-  // We use grid.Get(i, j) rather than touching grid.A directly so this code
-  // is correct regardless of the internal storage layout of Grid2D.
-  // VTK ImageData expects values ordered: for j=0..ny-1 { for i=0..nx-1 }.
-  std::vector<varType> values;
-  values.reserve(static_cast<std::size_t>(nx) * ny);
-  for (int j = 0; j < ny; ++j)
-    for (int i = 0; i < nx; ++i)
-      values.push_back(grid.Get(i, j));
+OutputWriter::EncodedArray
+OutputWriter::encodeArray(const NamedGrid &array,
+                          const std::array<int, 4> &range,
+                          const std::string &sidecarStem) const {
+  const auto [ib, ie, jb, je] = range;
+  const int nx = ie - ib;
+  const int ny = je - jb;
+  const std::size_t count = static_cast<std::size_t>(nx) * ny;
+  const Grid2D &g = *array.grid;
 
-  // Compress (or copy) payload
-  const std::vector<unsigned char> payload = preparePayload(values);
+  const ErrorBound bound = options_.boundFor(array.name);
+  if (bound.enabled()) {
+    // The quantiser needs the whole array: gather it row by row.
+    std::vector<varType> values(count);
+#pragma omp parallel for schedule(static)
+    for (int j = jb; j < je; ++j)
+      std::copy_n(g.A.data() + static_cast<std::size_t>(j) * g.nx + ib, nx,
+                  values.data() + static_cast<std::size_t>(j - jb) * nx);
+    const LossyCodec::Quantised q =
+        LossyCodec::quantise(values.data(), values.size(), bound);
+    if (q.step > 0.0) {
+      if (options_.lossySidecar) {
+        const std::vector<unsigned char> side =
+            LossyCodec::encodeLorenzo(q, nx, ny);
+        std::ofstream out(sidecarStem + "." + array.name + ".plz",
+                          std::ios::binary);
+        out.write(reinterpret_cast<const char *>(side.data()),
+                  static_cast<std::streamsize>(side.size()));
+        bytes_written_ += side.size();
+      }
 
-  // Open output file
-  const std::string vti_name = formatFilename(id, current_step_);
-  const std::string vti_path = output_dir_ + "/" + vti_name;
+      // Dequantised values: exact in float32 for all but extreme ranges.
+      if (q.float32Exact) {
+        std::vector<float> deq(q.code.size());
+#pragma omp parallel for schedule(static)
+        for (std::size_t k = 0; k < deq.size(); ++k)
+          deq[k] = static_cast<float>(static_cast<double>(q.code[k]) * q.step);
+        return {"Float32",
+                preparePayload(deq.data(), deq.size() * sizeof(float))};
+      }
+      std::vector<varType> deq(q.code.size());
+#pragma omp parallel for schedule(static)
+      for (std::size_t k = 0; k < deq.size(); ++k)
+        deq[k] = static_cast<varType>(static_cast<double>(q.code[k]) * q.step);
+      return {vtkTypeName(),
+              preparePayload(deq.data(), deq.size() * sizeof(varType))};
+    }
+    return {vtkTypeName(),
+            preparePayload(values.data(), values.size() * sizeof(varType))};
+  }
 
+  using Kind = OutputType::Kind;
+  const OutputType type = options_.typeFor(array.name);
+  auto encode = [&](auto zero, const char *name, auto op) {
+    using Out = decltype(zero);
+    return EncodedArray{
+        name, preparePayload(count, sizeof(Out),
+                             [&](std::size_t first, std::size_t n,
+                                 unsigned char *dst) {
+                               convertRows<Out>(g, range, first, n, dst, op);
+                             })};
+  };
+  auto same = [](varType x) { return x; };
+
+  switch (type.kind) {
+  case Kind::NATIVE:
+    return encode(varType(), vtkTypeName(), same);
+  case Kind::FLOAT64:
+    return encode(double(), "Float64",
+                  [](varType x) { return static_cast<double>(x); });
+  case Kind::FLOAT32:
+    return encode(float(), "Float32",
+                  [](varType x) { return static_cast<float>(x); });
+  case Kind::INT16:
+  case Kind::UINT8:
+    break;
+  }
+
+  // Quantised: code = round((x - offset) / scale), clamped to the type.
+  const bool int16 = type.kind == Kind::INT16;
+  const double cmin = int16 ? -32767.0 : 0.0;
+  const double cmax = int16 ? 32767.0 : 255.0;
+  double scale = type.scale;
+  double offset = type.offset;
+  if (scale <= 0.0) {
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -lo;
+#pragma omp parallel for reduction(min : lo) reduction(max : hi)
+    for (int j = jb; j < je; ++j)
+      for (int i = ib; i < ie; ++i) {
+        const double x = g.Get(i, j);
+        if (std::isfinite(x)) {
+          lo = std::min(lo, x);
+          hi = std::max(hi, x);
+        }
+      }
+    if (!(lo <= hi))
+      lo = hi = 0.0;
+    scale = hi > lo ? (hi - lo) / (cmax - cmin) : 1.0;
+    offset = lo - cmin * scale;
+  }
+  const double inv = 1.0 / scale;
+  auto code = [=](varType x) {
+    const double c = std::nearbyint((static_cast<double>(x) - offset) * inv);
+    return std::isnan(c) ? 0.0 : std::clamp(c, cmin, cmax);
+  };
+  EncodedArray e =
+      int16 ? encode(int16_t(), "Int16",
+                     [=](varType x) { return static_cast<int16_t>(code(x)); })
+            : encode(uint8_t(), "UInt8",
+                     [=](varType x) { return static_cast<uint8_t>(code(x)); });
+  e.scale = scale;
+  e.offset = offset;
+  return e;
+}
+
+bool OutputWriter::writeVTI(const std::string &vti_path,
+                            const std::vector<NamedGrid> &arrays,
+                            const std::array<int, 4> &range,
+                            const std::array<int, 4> &wholeExtent,
+                            const std::array<int, 4> &pieceExtent,
+                            const Geometry &geom,
+                            std::vector<std::string> *types) const {
+  // Encode each grid in VTK x-fastest (row-major) order, which is the
+  // Grid2D storage order: for j=0..ny-1 { for i=0..nx-1 }.
+  const std::string sidecarStem = vti_path.substr(0, vti_path.size() - 4);
+  std::vector<EncodedArray> encoded;
+  encoded.reserve(arrays.size());
+  for (const NamedGrid &a : arrays)
+    encoded.push_back(encodeArray(a, range, sidecarStem));
+
+  // Open output file
   std::ofstream out(vti_path, std::ios::binary);
   if (!out.is_open())
     return false;
@@ -127,23 +405,42 @@ bool OutputWriter::writeGrid2D(const Grid2D &grid, const std::string &id) {
   std::ostringstream xml;
   xml << "<?xml version=\"1.0\"?>\n"
       << "<VTKFile type=\"ImageData\" version=\"0.1\""
-      << " byte_order=\"LittleEndian\"" << compressorAttr << ">\n"
+      << " byte_order=\"" << byteOrder() << "\"" << compressorAttr << ">\n"
       // WholeExtent is in *points*. A grid of nx×ny cells has nx+1 × ny+1
       // corner points, so point indices run 0..nx in x and 0..ny in y.
       // CellData array size = nx*ny, row stride = nx. Consistent with data.
-      << "  <ImageData WholeExtent=\"0 " << nx << " 0 " << ny
+      << "  <ImageData WholeExtent=\"" << wholeExtent[0] << ' '
+      << wholeExtent[1] << ' ' << wholeExtent[2] << ' ' << wholeExtent[3]
       << " 0 0\""
-      << " Origin=\"0.0 0.0 0.0\""
-      << " Spacing=\"1.0 1.0 1.0\">\n"
-      << "    <Piece Extent=\"0 " << nx << " 0 " << ny
-      << " 0 0\">\n"
+      << " Origin=\"" << formatReal(geom.origin[0]) << ' '
+      << formatReal(geom.origin[1]) << " 0.0\""
+      << " Spacing=\"" << formatReal(geom.spacing[0]) << ' '
+      << formatReal(geom.spacing[1]) << " 1.0\">\n"
+      << "    <Piece Extent=\"" << pieceExtent[0] << ' ' << pieceExtent[1]
+      << ' ' << pieceExtent[2] << ' ' << pieceExtent[3] << " 0 0\">\n"
       // CellData: one value per cell (not per corner point).
-      << "      <CellData Scalars=\"" << id << "\">\n"
-      << "        <DataArray type=\"" << vtkTypeName() << "\""
-      << " Name=\"" << id << "\""
-      << " NumberOfComponents=\"1\""
-      << " format=\"appended\" offset=\"0\"/>\n"
-      << "      </CellData>\n"
+      << "      <CellData Scalars=\"" << arrays.front().name << "\">\n";
+
+  // Arrays are appended back to back; each offset is the byte position of
+  // the array's header words within the appended section.
+  std::size_t offset = 0;
+  for (std::size_t k = 0; k < arrays.size(); ++k) {
+    const Payload &payload = encoded[k].payload;
+    xml << "        <DataArray type=\"" << encoded[k].type << "\""
+        << " Name=\"" << arrays[k].name << "\""
+        << " NumberOfComponents=\"1\"";
+    if (encoded[k].scale > 0.0)
+      xml << " scale_factor=\"" << formatReal(encoded[k].scale)
+          << "\" add_offset=\"" << formatReal(encoded[k].offset) << "\"";
+    xml << " format=\"appended\" offset=\"" << offset << "\"/>\n";
+    offset += payload.header.size() * sizeof(uint32_t) + payload.data.size();
+  }
+
+  if (types)
+    for (const EncodedArray &e : encoded)
+      types->push_back(e.type);
+
+  xml << "      </CellData>\n"
       << "    </Piece>\n"
       << "  </ImageData>\n"
       << "  <AppendedData encoding=\"raw\">\n"
@@ -152,45 +449,286 @@ bool OutputWriter::writeGrid2D(const Grid2D &grid, const std::string &id) {
   const std::string xmlStr = xml.str();
   out.write(xmlStr.data(), static_cast<std::streamsize>(xmlStr.size()));
 
-  // Write binary header + payload
-#ifdef HAVE_ZLIB
-  // VTK single-block compressed header (4 × uint32_t):
-  writeU32(out, 1);        // numBlocks
-  writeU32(out, rawBytes); // uncompressed block size
-  writeU32(out, rawBytes); // last partial block size
-  writeU32(out, static_cast<uint32_t>(payload.size())); // compressed size
-#else
-  writeU32(out, rawBytes); // single word: raw byte count
-#endif
-
-  out.write(reinterpret_cast<const char *>(payload.data()),
-            static_cast<std::streamsize>(payload.size()));
+  // Write binary header + payload of every array
+  for (const EncodedArray &e : encoded) {
+    const Payload &payload = e.payload;
+    for (const uint32_t word : payload.header)
+      writeU32(out, word);
+    out.write(reinterpret_cast<const char *>(payload.data.data()),
+              static_cast<std::streamsize>(payload.data.size()));
+  }
 
   out << "\n  </AppendedData>\n"
       << "</VTKFile>\n";
+  bytes_written_ += static_cast<std::uint64_t>(out.tellp());
+  return true;
+}
+
+bool OutputWriter::writeWhole(const std::string &stem,
+                              const std::vector<NamedGrid> &arrays,
+                              const Geometry &geom,
+                              std::optional<double> time) {
+  if (pvd_finalised_ || arrays.empty())
+    return false;
+  const double t = time.value_or(static_cast<double>(current_step_));
+  if (options_.series)
+    return appendSeries(stem, arrays, geom, t);
+
+  const Grid2D &grid = *arrays.front().grid;
+  const std::string vti_name = formatFilename(stem, current_step_);
+  const std::array<int, 4> extent = {0, grid.nx, 0, grid.ny};
+  if (!writeVTI(output_dir_ + "/" + vti_name, arrays, extent, extent, extent,
+                geom))
+    return false;
 
   // Update PVD index
-  appendPVDEntry(vti_name, static_cast<double>(current_step_));
+  appendPVDEntry(vti_name, t);
   ++current_step_;
   return true;
 }
 
-void OutputWriter::finalisePVD() {
-  if (pvd_finalised_)
-    return;
+bool OutputWriter::writePieced(
+    const std::string &stem, const std::vector<NamedGrid> &arrays,
+    const std::array<int, 4> &localRange,
+    const std::vector<std::array<int, 4>> &pieceExtents, int rank,
+    const Geometry &geom) {
+  if (pvd_finalised_ || arrays.empty())
+    return false;
+
+  // Whole extent = bounding box of all pieces.
+  std::array<int, 4> whole = pieceExtents.front();
+  for (const auto &e : pieceExtents) {
+    whole[0] = std::min(whole[0], e[0]);
+    whole[1] = std::max(whole[1], e[1]);
+    whole[2] = std::min(whole[2], e[2]);
+    whole[3] = std::max(whole[3], e[3]);
+  }
+
+  // "p_0042.vti" -> "p_0042_3.vti"
+  auto pieceName = [&](int r) {
+    std::string name = formatFilename(stem, current_step_);
+    return name.insert(name.size() - 4, "_" + std::to_string(r));
+  };
+
+  // Element types of this piece; rank 0 lists its own in the .pvti (lossy
+  // arrays fall back from Float32 only for bounds below float resolution,
+  // which every rank sees alike in practice).
+  std::vector<std::string> types;
+  bool ok = writeVTI(output_dir_ + "/" + pieceName(rank), arrays, localRange,
+                     whole, pieceExtents[rank], geom, &types);
+
+  // Rank 0 writes the .pvti index that stitches the pieces together and
+  // records it in the PVD.
+  if (rank == 0) {
+    std::string pvti_name = formatFilename(stem, current_step_);
+    pvti_name.replace(pvti_name.size() - 4, 4, ".pvti");
+
+    std::ofstream out(output_dir_ + "/" + pvti_name);
+    if (!out.is_open())
+      return false;
+    out << "<?xml version=\"1.0\"?>\n"
+        << "<VTKFile type=\"PImageData\" version=\"0.1\""
+        << " byte_order=\"" << byteOrder() << "\">\n"
+        << "  <PImageData WholeExtent=\"" << whole[0] << ' ' << whole[1]
+        << ' ' << whole[2] << ' ' << whole[3] << " 0 0\""
+        << " GhostLevel=\"0\" Origin=\"" << formatReal(geom.origin[0]) << ' '
+        << formatReal(geom.origin[1]) << " 0.0\""
+        << " Spacing=\"" << formatReal(geom.spacing[0]) << ' '
+        << formatReal(geom.spacing[1]) << " 1.0\">\n"
+        << "    <PCellData Scalars=\"" << arrays.front().name << "\">\n";
+    for (std::size_t k = 0; k < arrays.size(); ++k)
+      out << "      <PDataArray type=\""
+          << (k < types.size() ? types[k] : vtkTypeName()) << "\" Name=\""
+          << arrays[k].name << "\" NumberOfComponents=\"1\"/>\n";
+    out << "    </PCellData>\n";
+    for (std::size_t r = 0; r < pieceExtents.size(); ++r) {
+      const auto &e = pieceExtents[r];
+      out << "    <Piece Extent=\"" << e[0] << ' ' << e[1] << ' ' << e[2]
+          << ' ' << e[3] << " 0 0\" Source=\"" << pieceName(static_cast<int>(r))
+          << "\"/>\n";
+    }
+    out << "  </PImageData>\n"
+        << "</VTKFile>\n";
+    ok &= out.good();
+
+    appendPVDEntry(pvti_name, static_cast<double>(current_step_));
+  }
+
+  ++current_step_;
+  return ok;
+}
+
+// Public
+
+bool OutputWriter::writeGrid2D(const Grid2D &grid, const std::string &id,
+                               const Geometry &geom) {
+  return writeWhole(id, {{id, &grid}}, geom);
+}
+
+bool OutputWriter::writeGrids(const std::vector<NamedGrid> &arrays,
+                              const Geometry &geom,
+                              std::optional<double> time) {
+  return writeWhole(base_name_, arrays, geom, time);
+}
+
+bool OutputWriter::writePiece(
+    const Grid2D &grid, const std::string &id,
+    const std::array<int, 4> &localRange,
+    const std::vector<std::array<int, 4>> &pieceExtents, int rank,
+    const Geometry &geom) {
+  return writePieced(id, {{id, &grid}}, localRange, pieceExtents, rank, geom);
+}
+
+bool OutputWriter::writePieces(
+    const std::vector<NamedGrid> &arrays, const std::array<int, 4> &localRange,
+    const std::vector<std::array<int, 4>> &pieceExtents, int rank,
+    const Geometry &geom) {
+  return writePieced(base_name_, arrays, localRange, pieceExtents, rank,
+                     geom);
+}
+
+bool OutputWriter::writeAMR(const std::vector<AMRBlock> &blocks,
+                            const std::string &id) {
+  if (pvd_finalised_ || blocks.empty())
+    return false;
+
+  // Named after the writer so it cannot collide with the uniform-grid
+  // output of the same field: "smoke_amr_0042.vti" -> "smoke_amr_0042".
+  std::string stem = formatFilename(base_name_, current_step_);
+  stem.resize(stem.size() - 4);
 
-  const std::string pvd_path = output_dir_ + "/" + base_name_ + ".pvd";
-  std::ofstream out(pvd_path);
+  int maxLevel = 0;
+  for (const auto &b : blocks)
+    maxLevel = std::max(maxLevel, b.level);
+
+  std::ostringstream vthb;
+  vthb << "<?xml version=\"1.0\"?>\n"
+       << "<VTKFile type=\"vtkOverlappingAMR\" version=\"1.1\""
+       << " byte_order=\"" << byteOrder() << "\">\n"
+       << "  <vtkOverlappingAMR origin=\"0 0 0\" grid_description=\"XY\">\n";
+
+  bool ok = true;
+  for (int level = 0; level <= maxLevel; ++level) {
+    int index = 0;
+    for (const auto &b : blocks) {
+      if (b.level != level)
+        continue;
+      if (index == 0)
+        vthb << "    <Block level=\"" << level << "\" spacing=\""
+             << b.spacing[0] << ' ' << b.spacing[1] << " 1\">\n";
+
+      const std::string vti_name = stem + "_L" + std::to_string(level) + "_" +
+                                   std::to_string(index) + ".vti";
+      ok &= writeVTI(output_dir_ + "/" + vti_name, {{id, b.grid}}, b.range,
+                     b.box, b.box, {{0.0, 0.0}, b.spacing});
+
+      // amr_box holds inclusive cell indices.
+      vthb << "      <DataSet index=\"" << index << "\" amr_box=\"" << b.box[0]
+           << ' ' << b.box[1] - 1 << ' ' << b.box[2] << ' ' << b.box[3] - 1
+           << " 0 0\" file=\"" << vti_name << "\"/>\n";
+      ++index;
+    }
+    if (index > 0)
+      vthb << "    </Block>\n";
+  }
+  vthb << "  </vtkOverlappingAMR>\n"
+       << "</VTKFile>\n";
+
+  const std::string vthb_name = stem + ".vthb";
+  std::ofstream out(output_dir_ + "/" + vthb_name);
   if (!out.is_open())
-    throw std::runtime_error("OutputWriter: cannot open PVD file: " + pvd_path);
+    return false;
+  out << vthb.str();
 
-  out << "<VTKFile type=\"Collection\" version=\"0.1\""
-      << " byte_order=\"LittleEndian\">\n"
-      << "  <Collection>\n";
-  for (const auto &entry : pvd_entries_)
-    out << entry;
-  out << "  </Collection>\n"
-      << "</VTKFile>\n";
+  appendPVDEntry(vthb_name, static_cast<double>(current_step_));
+  ++current_step_;
+  return ok && out.good();
+}
+
+bool OutputWriter::appendSeries(const std::string &stem,
+                                const std::vector<NamedGrid> &arrays,
+                                const Geometry &geom, double time) {
+  SeriesFile &bin = *series_;
+  if (!bin.out.is_open()) {
+    // A fresh container replaces any earlier one; a restored one (see
+    // restore()) continues after its last checkpointed frame.
+    bin.out.open(output_dir_ + "/" + bin.name,
+                 std::ios::binary |
+                     (bin.bytes == 0 ? std::ios::trunc : std::ios::app));
+    if (!bin.out.is_open())
+      return false;
+  }
+
+  // One uniform grid per frame. Points are (nx+1) × (ny+1) corners of the
+  // nx × ny cells; XDMF lists dimensions (and origin / spacing components)
+  // slowest-first, i.e. "y x", which matches the row-major storage of Grid2D
+  // so A is written as is.
+  const Grid2D &grid = *arrays.front().grid;
+  std::ostringstream xml;
+  xml << "      <Grid Name=\"" << stem << '_' << std::setw(4)
+      << std::setfill('0') << current_step_ << std::setfill(' ')
+      << "\" GridType=\"Uniform\">\n"
+      << "        <Time Value=\"" << time << "\"/>\n"
+      << "        <Topology TopologyType=\"2DCoRectMesh\" Dimensions=\""
+      << grid.ny + 1 << ' ' << grid.nx + 1 << "\"/>\n"
+      << "        <Geometry GeometryType=\"ORIGIN_DXDY\">\n"
+      << "          <DataItem Dimensions=\"2\" Format=\"XML\">"
+      << geom.origin[1] << ' ' << geom.origin[0] << "</DataItem>\n"
+      << "          <DataItem Dimensions=\"2\" Format=\"XML\">"
+      << geom.spacing[1] << ' ' << geom.spacing[0] << "</DataItem>\n"
+      << "        </Geometry>\n";
+  for (const NamedGrid &a : arrays) {
+    const std::size_t bytes = a.grid->A.size() * sizeof(varType);
+    bin.out.write(reinterpret_cast<const char *>(a.grid->A.data()),
+                  static_cast<std::streamsize>(bytes));
+    xml << "        <Attribute Name=\"" << a.name
+        << "\" AttributeType=\"Scalar\" Center=\"Cell\">\n"
+        << "          <DataItem Dimensions=\"" << a.grid->ny << ' '
+        << a.grid->nx << "\" NumberType=\"Float\" Precision=\""
+        << sizeof(varType) << "\" Format=\"Binary\" Endian=\""
+        << xdmfEndian() << "\" Seek=\"" << bin.bytes << "\">" << bin.name
+        << "</DataItem>\n"
+        << "        </Attribute>\n";
+    bin.bytes += bytes;
+    bytes_written_ += bytes;
+  }
+  xml << "      </Grid>\n";
+
+  // Data first, then the index entry that points at it.
+  bin.out.flush();
+  if (!bin.out)
+    return false;
+  appendIndexEntry(xml.str());
+  ++current_step_;
+  return true;
+}
+
+void OutputWriter::restore(const State &s) {
+  current_step_ = s.step;
+  pvd_entries_ = s.entries;
+  if (series_) {
+    // Every writer sharing the container restores the same length.
+    series_->out.close();
+    series_->bytes = s.bytes;
+    const fs::path bin = output_dir_ + "/" + series_->name;
+    std::error_code ec;
+    if (fs::exists(bin, ec) && fs::file_size(bin, ec) > s.bytes)
+      fs::resize_file(bin, s.bytes, ec); // drop frames past the restart
+  }
+  if (!pvd_entries_.empty())
+    rewriteIndex();
+  else
+    index_end_ = -1;
+}
+
+void OutputWriter::finalisePVD() {
+  if (pvd_finalised_)
+    return;
 
+  // The index is already up to date after every frame; rewrite it once so
+  // the final file does not depend on the in-place updates having worked.
+  rewriteIndex();
+  if (series_)
+    series_->out.flush(); // closed with the last writer sharing it
   pvd_finalised_ = true;
 }
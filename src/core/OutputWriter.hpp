@@ -1,7 +1,15 @@
 #pragma once
 #include "Grid2D.hpp"
+#include "LossyCodec.hpp"
 #include "Precision.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -20,7 +28,20 @@
  *   <name>_0000.vti   ← step 0
  *   <name>_0001.vti   ← step 1
  *   ...
- *   <name>.pvd         ← ParaView collection index (written on destruction)
+ *   <name>.pvd         ← ParaView collection index, updated every step
+ * ```
+ * The index is extended in place after each frame (only the new entry and
+ * the closing tags are written), so a killed run still leaves a readable
+ * series.
+ *
+ * ### Series container (WriterOptions::series)
+ * Instead of one file per step, whole-grid frames are appended raw to one
+ * SeriesFile and indexed by an XDMF descriptor that ParaView opens directly:
+ * ```
+ *   series.bin   ← varType arrays of every frame of every writer sharing
+ *                  the container, back to back (<name>.bin if not shared)
+ *   <name>.xmf   ← temporal collection; each frame is a 2DCoRectMesh whose
+ *                  attributes point into the .bin via Seek offsets
  * ```
  *
  * ### Binary payload format inside each .vti
@@ -29,24 +50,141 @@
  *   uint32_t  rawByteCount
  *   varType[] values          (nx * ny elements, storage order)
  * ```
- * With zlib (VTK compressed-block format, single block):
+ * With zlib (VTK compressed-block format):
  * ```
- *   uint32_t  numBlocks      (= 1)
- *   uint32_t  blockSize      (= rawByteCount)
- *   uint32_t  lastBlockSize  (= rawByteCount)
- *   uint32_t  compressedSize
- *   byte[]    compressed data
+ *   uint32_t  numBlocks
+ *   uint32_t  blockSize         (uncompressed bytes per block)
+ *   uint32_t  lastBlockSize     (0 if the last block is full)
+ *   uint32_t  compressedSize[numBlocks]
+ *   byte[]    compressed blocks, back to back
  * ```
+ * Blocks are compressed independently, in parallel (see WriterOptions).
+ *
+ * Arrays with a lossy error bound are quantised first (see LossyCodec) and
+ * stored as Float32 when that is exact, with an optional
+ * @c \<file\>.\<array\>.plz predictive-coded sidecar next to the .vti.
+ *
+ * Other arrays are stored in their OutputType (WriterOptions::types):
+ * the simulation precision by default, or Float64 / Float32 / Int16 /
+ * UInt8. The conversion runs block by block inside the compression loop,
+ * straight from the grid rows, so no full-size copy of the array is made.
+ * Quantised arrays carry @c scale_factor and @c add_offset attributes on
+ * their DataArray; the value of a code @e c is
+ * @f$ c \cdot scale\_factor + add\_offset @f$.
+ * Payloads are in host byte order, and @c byte_order says which one.
+ */
+
+/// @brief Element type of one output array (see WriterOptions::types).
+struct OutputType {
+  enum class Kind {
+    NATIVE,  ///< varType: Float32 or Float64 depending on the build.
+    FLOAT64, ///< Double precision.
+    FLOAT32, ///< Single precision.
+    INT16,   ///< Quantised: code in [-32767, 32767].
+    UINT8    ///< Quantised: code in [0, 255].
+  };
+  Kind kind = Kind::NATIVE;
+  /// Quantised kinds: size of one code step; 0 = fit the value range of
+  /// each frame (and @c offset is then chosen to match).
+  double scale = 0.0;
+  double offset = 0.0; ///< Value of code 0 when @c scale is fixed.
+
+  [[nodiscard]] bool quantised() const {
+    return kind == Kind::INT16 || kind == Kind::UINT8;
+  }
+};
+
+/**
+ * @brief Append-only binary container of series-mode frames.
+ *
+ * Shared through WriterOptions::seriesFile by every writer of a run, so all
+ * fields of all steps go to one file. Writers append one at a time (on the
+ * solver thread, or all on the AsyncWriter thread), so it is not locked.
  */
+struct SeriesFile {
+  explicit SeriesFile(std::string name) : name(std::move(name)) {}
+
+  std::string name;        ///< File name inside the output directory.
+  std::ofstream out;       ///< Open once the first frame is appended.
+  std::uint64_t bytes = 0; ///< Length so far; a restart cuts back to it.
+};
+
+/// @brief Encoding settings shared by the writers of one run.
+struct WriterOptions {
+  int compressionLevel = 1;        ///< zlib level, 0 (store) to 9 (smallest).
+  std::size_t blockSize = 1 << 16; ///< Uncompressed bytes per zlib block.
+
+  /// Lossy error bound per array name; @c "*" applies to every array
+  /// without its own entry. Arrays without a bound are written exactly.
+  std::map<std::string, ErrorBound> errorBounds;
+  bool lossySidecar = false; ///< Also write Lorenzo-coded .plz sidecars.
+
+  /// Output element type per array name; @c "*" applies to every array
+  /// without its own entry. Arrays with a lossy bound ignore it.
+  std::map<std::string, OutputType> types;
+
+  /// Append writeGrid2D() / writeGrids() frames to one .bin + .xmf series
+  /// instead of per-step .vti files (payloads are then raw and exact).
+  /// Not used for pieces or AMR snapshots.
+  bool series = false;
+
+  /// Series mode: container shared with the other writers of the run;
+  /// nullptr gives each writer its own @c \<name\>.bin.
+  std::shared_ptr<SeriesFile> seriesFile;
+
+  /// @return The bound for array @p name (disabled if none applies).
+  [[nodiscard]] ErrorBound boundFor(const std::string &name) const {
+    auto it = errorBounds.find(name);
+    if (it == errorBounds.end())
+      it = errorBounds.find("*");
+    return it == errorBounds.end() ? ErrorBound() : it->second;
+  }
+
+  /// @return The output type of array @p name (NATIVE if none applies).
+  [[nodiscard]] OutputType typeFor(const std::string &name) const {
+    auto it = types.find(name);
+    if (it == types.end())
+      it = types.find("*");
+    return it == types.end() ? OutputType() : it->second;
+  }
+};
+
+/// @brief Placement of a frame in physical space: the @c Origin (corner of
+///        the first cell) and @c Spacing (cell size) of the dataset.
+struct FrameGeometry {
+  std::array<double, 2> origin = {0.0, 0.0};  ///< x, y of cell (0, 0).
+  std::array<double, 2> spacing = {1.0, 1.0}; ///< Cell width and height.
+};
+
 class OutputWriter {
 public:
+  /// @brief One named cell array of a multi-array file (see writeGrids()).
+  struct NamedGrid {
+    std::string name;   ///< Array name in the VTK XML.
+    const Grid2D *grid; ///< Source grid; all arrays of a file share a shape.
+  };
+
+  /// @brief Placement of a whole-grid frame (see FrameGeometry).
+  using Geometry = FrameGeometry;
+
+  /// @brief One dataset of an overlapping-AMR snapshot (see writeAMR()).
+  struct AMRBlock {
+    const Grid2D *grid;            ///< Grid holding the block's data.
+    std::array<int, 4> range;      ///< Local cells to write {ib, ie, jb, je}.
+    int level;                     ///< Refinement level (0 = base grid).
+    std::array<int, 4> box;        ///< Cells in level index space, half-open.
+    std::array<double, 2> spacing; ///< Cell size at this level.
+  };
+
   /**
    * @brief Construct a writer and create the output directory if needed.
    * @param output_dir Directory where .vti files will be written.
    * @param pvd_name   Base name used for both the .vti prefix and the .pvd
    * file.
+   * @param options    Payload encoding settings.
    */
-  OutputWriter(const std::string &output_dir, const std::string &pvd_name);
+  OutputWriter(const std::string &output_dir, const std::string &pvd_name,
+               const WriterOptions &options = WriterOptions());
 
   /// Finalises the PVD index on destruction if not already done.
   ~OutputWriter();
@@ -63,26 +201,116 @@ public:
    *
    * @param grid  Grid to write.
    * @param id    Field name embedded in the VTK XML (e.g. @c "u", @c "p").
+   * @param geom  Origin and spacing of the frame (index space by default).
    * @return @c true on success, @c false if the file could not be opened or
    *         the PVD has already been finalised.
    */
-  bool writeGrid2D(const Grid2D &grid, const std::string &id);
+  bool writeGrid2D(const Grid2D &grid, const std::string &id,
+                   const Geometry &geom = Geometry());
+
+  /**
+   * @brief Write several arrays of one shape into a single
+   *        @c \<pvd_name\>_NNNN.vti (one @c \<DataArray\> each) and append
+   *        a PVD entry.
+   * @param arrays Arrays to write; the first one is the active scalar.
+   * @param geom   Origin and spacing of the frame (index space by default).
+   * @param time   Time value of the index entry; the frame number if unset.
+   * @return @c true on success.
+   */
+  bool writeGrids(const std::vector<NamedGrid> &arrays,
+                  const Geometry &geom = Geometry(),
+                  std::optional<double> time = std::nullopt);
+
+  /**
+   * @brief Write this rank's piece of a distributed grid.
+   *
+   * Every rank writes @c \<id\>_NNNN_\<rank\>.vti holding the cells in
+   * @p localRange; rank 0 additionally writes the @c .pvti index listing all
+   * pieces and records it in the PVD.
+   *
+   * @param grid         Local grid (owned cells + ghosts).
+   * @param id           Field name embedded in the VTK XML.
+   * @param localRange   Owned local cells {ib, ie, jb, je}, half-open.
+   * @param pieceExtents Global cell extents of every rank's piece.
+   * @param rank         Index of this rank's entry in @p pieceExtents.
+   * @param geom         Origin and spacing of the whole dataset, written to
+   *                     every piece and to the .pvti.
+   * @return @c true on success.
+   */
+  bool writePiece(const Grid2D &grid, const std::string &id,
+                  const std::array<int, 4> &localRange,
+                  const std::vector<std::array<int, 4>> &pieceExtents,
+                  int rank, const Geometry &geom = Geometry());
+
+  /// @brief Multi-array variant of writePiece(): pieces and .pvti are named
+  ///        after @c pvd_name and list every array.
+  bool writePieces(const std::vector<NamedGrid> &arrays,
+                   const std::array<int, 4> &localRange,
+                   const std::vector<std::array<int, 4>> &pieceExtents,
+                   int rank, const Geometry &geom = Geometry());
 
   /**
-   * @brief Write the PVD index file and mark the writer as finalised.
+   * @brief Write one overlapping-AMR snapshot: a .vti per block plus a
+   *        @c .vthb index grouping them by level, recorded in the PVD.
+   *
+   * Block files are named @c \<pvd_name\>_NNNN_L\<level\>_\<k\>.vti and carry
+   * their level spacing so ParaView places them correctly.
+   *
+   * @param blocks Blocks of all levels, in any order.
+   * @param id     Field name embedded in the VTK XML.
+   * @return @c true on success.
+   */
+  bool writeAMR(const std::vector<AMRBlock> &blocks, const std::string &id);
+
+  /**
+   * @brief Write the final index (.pvd, or .xmf in series mode) and mark
+   *        the writer as finalised.
    *
    * Called automatically by the destructor if not called explicitly.
    * Subsequent calls are no-ops.
    */
   void finalisePVD();
 
+  /// @brief Frame counter and PVD entries, saved in checkpoints so a
+  ///        restarted run continues the same series.
+  struct State {
+    int step = 0;                     ///< Next frame index.
+    std::vector<std::string> entries; ///< Index entries so far.
+    std::uint64_t bytes = 0;          ///< Length of the series container.
+  };
+
+  /// @return Base name given at construction (identifies the series).
+  [[nodiscard]] const std::string &name() const { return base_name_; }
+
+  /// @return Current series state (see restore()).
+  [[nodiscard]] State state() const {
+    return {current_step_, pvd_entries_, series_ ? series_->bytes : 0};
+  }
+
+  /// @brief Continue the series described by @p s: later frames are
+  ///        numbered from @c s.step, the index is rewritten with the earlier
+  ///        entries and the series container is cut back to @c s.bytes.
+  void restore(const State &s);
+
+  /// @return Bytes of .vti, sidecar and series data written so far (index
+  ///         files excluded); safe to read while a background job writes.
+  [[nodiscard]] std::uint64_t bytesWritten() const {
+    return bytes_written_.load(std::memory_order_relaxed);
+  }
+
 private:
   std::string output_dir_; ///< Destination directory.
   std::string base_name_;  ///< Prefix for .vti files and stem for the .pvd.
   int current_step_;       ///< Monotonically increasing frame counter.
   bool pvd_finalised_;     ///< Guard against double-finalisation.
+  WriterOptions options_;  ///< Payload encoding settings.
+
+  std::vector<std::string> pvd_entries_; ///< Accumulated index entries.
+  std::streamoff index_end_ = -1; ///< Offset of the index closing tags
+                                  ///< (-1 = index not written yet).
 
-  std::vector<std::string> pvd_entries_; ///< Accumulated XML DataSet lines.
+  std::shared_ptr<SeriesFile> series_; ///< Container (series mode only).
+  mutable std::atomic<std::uint64_t> bytes_written_{0}; ///< See bytesWritten().
 
   /**
    * @brief Build the .vti filename for a given field and step.
@@ -100,17 +328,110 @@ private:
    */
   void appendPVDEntry(const std::string &vti_filename, double time_value);
 
+  /// @return Path of the index: @c \<name\>.pvd, or @c \<name\>.xmf in
+  ///         series mode.
+  [[nodiscard]] std::string indexPath() const;
+
+  /// @brief Record @p entry and extend the index file in place.
+  void appendIndexEntry(const std::string &entry);
+
+  /// @brief Write the whole index file from @c pvd_entries_.
+  void rewriteIndex();
+
+  /// @brief Series-mode body of writeWhole(): append the arrays to the .bin
+  ///        and one uniform grid to the .xmf.
+  bool appendSeries(const std::string &stem,
+                    const std::vector<NamedGrid> &arrays, const Geometry &geom,
+                    double time);
+
+  /// @brief Shared body of writeGrid2D() / writeGrids(): files are named
+  ///        @c \<stem\>_NNNN.vti.
+  bool writeWhole(const std::string &stem, const std::vector<NamedGrid> &arrays,
+                  const Geometry &geom = Geometry(),
+                  std::optional<double> time = std::nullopt);
+
+  /// @brief Shared body of writePiece() / writePieces().
+  bool writePieced(const std::string &stem,
+                   const std::vector<NamedGrid> &arrays,
+                   const std::array<int, 4> &localRange,
+                   const std::vector<std::array<int, 4>> &pieceExtents,
+                   int rank, const Geometry &geom);
+
   /**
-   * @brief Compress @p values with zlib (if available) or return raw bytes.
+   * @brief Write the cells @p range of every array to one .vti file.
+   * @param vti_path    Destination path.
+   * @param arrays      Source grids and their names, written back to back in
+   *                    the appended section.
+   * @param range       Local cells to write {ib, ie, jb, je}, half-open.
+   * @param wholeExtent Global extent of the dataset (cells).
+   * @param pieceExtent Global extent of this file's piece (cells).
+   * @param geom        Written to the @c Origin / @c Spacing attributes.
+   * @param types       If non-null, receives the element type of each array.
+   * @return @c true on success.
+   */
+  bool writeVTI(const std::string &vti_path,
+                const std::vector<NamedGrid> &arrays,
+                const std::array<int, 4> &range,
+                const std::array<int, 4> &wholeExtent,
+                const std::array<int, 4> &pieceExtent,
+                const Geometry &geom = Geometry(),
+                std::vector<std::string> *types = nullptr) const;
+
+  /// @brief Binary block of one DataArray: header words, then data bytes.
+  struct Payload {
+    std::vector<uint32_t> header;    ///< Written first, as uint32_t words.
+    std::vector<unsigned char> data; ///< Compressed blocks or raw bytes.
+  };
+
+  /**
+   * @brief Compress @p bytes bytes at @p data with zlib (if available) or
+   *        return them raw.
    *
-   * The returned buffer is the payload that follows the VTK binary header —
-   * it does **not** include the uint32_t header word(s).
+   * With zlib the data is cut into @c options_.blockSize blocks which are
+   * compressed concurrently with OpenMP at @c options_.compressionLevel.
    *
-   * @param values Source data in simulation precision.
-   * @return Compressed (or raw) byte buffer ready to write.
+   * @param data  Array contents, in the VTK element type.
+   * @param bytes Size of the array in bytes.
+   * @return Header words and payload ready to write.
+   */
+  [[nodiscard]] Payload preparePayload(const void *data,
+                                       std::size_t bytes) const;
+
+  /// @brief Writes elements [first, first + count) of an array, in its
+  ///        output type, to @p dst.
+  using Fill = std::function<void(std::size_t first, std::size_t count,
+                                  unsigned char *dst)>;
+
+  /**
+   * @brief Variant of preparePayload() that produces the array on the fly:
+   *        each block is filled by @p fill into a per-thread buffer and
+   *        compressed at once (without zlib, @p fill writes the payload
+   *        directly).
+   * @param count     Number of elements.
+   * @param elemBytes Size of one element; blocks hold whole elements.
    */
-  [[nodiscard]] static std::vector<unsigned char>
-  preparePayload(const std::vector<varType> &values);
+  [[nodiscard]] Payload preparePayload(std::size_t count,
+                                       std::size_t elemBytes,
+                                       const Fill &fill) const;
+
+  /// @brief One array ready for the appended section.
+  struct EncodedArray {
+    const char *type; ///< VTK element type ("Float32", "UInt8", ...).
+    Payload payload;
+    double scale = 0.0;  ///< Code step of quantised types, else 0.
+    double offset = 0.0; ///< Value of code 0 of quantised types.
+  };
+
+  /**
+   * @brief Encode the cells @p range of @p array: apply its lossy bound if
+   *        any, else convert it to its OutputType, and compress it.
+   * @param array       Array name (selects bound and type) and grid.
+   * @param range       Cells {ib, ie, jb, je}, half-open.
+   * @param sidecarStem Path prefix for the .plz sidecar.
+   */
+  [[nodiscard]] EncodedArray encodeArray(const NamedGrid &array,
+                                         const std::array<int, 4> &range,
+                                         const std::string &sidecarStem) const;
 
   /// @return VTK type string: @c "Float32" or @c "Float64".
   static constexpr const char *vtkTypeName() noexcept {
@@ -118,6 +439,24 @@ private:
     return "Float32";
 #else
     return "Float64";
+#endif
+  }
+
+  /// @return XDMF @c Endian of the series payloads (host order).
+  static constexpr const char *xdmfEndian() noexcept {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return "Big";
+#else
+    return "Little";
+#endif
+  }
+
+  /// @return VTK @c byte_order of the payloads (host order).
+  static constexpr const char *byteOrder() noexcept {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return "BigEndian";
+#else
+    return "LittleEndian";
 #endif
   }
 };
@@ -1,5 +1,9 @@
 #include "Parameters.hpp"
 #include "Fields.hpp"
+#include "Helpers.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -28,6 +32,21 @@ SolverConfig SolverConfig::fromJson(const nlohmann::json &j) {
       std::cerr << "[SolverConfig] Unknown solver type '" << t
                 << "' – defaulting to gauss_seidel.\n";
   }
+
+  if (j.contains("log")) {
+    const nlohmann::json &log = j["log"];
+    if (log.is_boolean()) {
+      cfg.log = log.get<bool>();
+    } else {
+      cfg.log = true;
+      if (log.contains("file"))
+        cfg.logFile = log["file"].get<std::string>();
+      if (log.contains("history"))
+        cfg.historySteps = log["history"].get<std::vector<int>>();
+      if (log.contains("history_every"))
+        cfg.historyEvery = std::max(0, log["history_every"].get<int>());
+    }
+  }
   return cfg;
 }
 
@@ -43,6 +62,358 @@ std::string SolverConfig::typeName() const {
   return "unknown"; // unreachable, silences -Wreturn-type
 }
 
+// TilingConfig
+
+TilingConfig TilingConfig::fromJson(const nlohmann::json &j) {
+  TilingConfig cfg;
+  if (j.contains("enabled"))
+    cfg.enabled = j["enabled"].get<bool>();
+  if (j.contains("tile_size"))
+    cfg.tileSize = std::max(1, j["tile_size"].get<int>());
+  if (j.contains("threshold"))
+    cfg.threshold = j["threshold"].get<double>();
+  return cfg;
+}
+
+// AMRConfig
+
+AMRConfig AMRConfig::fromJson(const nlohmann::json &j) {
+  AMRConfig cfg;
+  auto load = [&j](const char *key, auto &member) {
+    if (j.contains(key))
+      member = j[key].get<std::decay_t<decltype(member)>>();
+  };
+  load("enabled", cfg.enabled);
+  load("max_level", cfg.maxLevel);
+  load("ratio", cfg.ratio);
+  load("block_size", cfg.blockSize);
+  load("ghost", cfg.ghost);
+  load("regrid_every", cfg.regridEvery);
+  load("vorticity", cfg.vorticity);
+  load("solid_distance", cfg.solidDistance);
+  load("smoke_gradient", cfg.smokeGradient);
+  cfg.ratio = std::max(2, cfg.ratio);
+  cfg.blockSize = std::max(2, cfg.blockSize);
+  cfg.ghost = std::max(2, cfg.ghost);
+  cfg.regridEvery = std::max(1, cfg.regridEvery);
+  return cfg;
+}
+
+// OutputConfig
+
+ViewConfig ViewConfig::fromJson(const nlohmann::json &j,
+                                const std::map<std::string, int> &vars) {
+  ViewConfig cfg;
+  auto load = [&j](const char *key, auto &member) {
+    if (j.contains(key))
+      member = j[key].get<std::decay_t<decltype(member)>>();
+  };
+  load("name", cfg.name);
+  load("fields", cfg.fields);
+  load("stride", cfg.stride);
+  load("average", cfg.average);
+  load("sampling_rate", cfg.samplingRate);
+  // Rectangle corners accept the same "nx-1"-style expressions as scenes.
+  auto loadCell = [&](const char *key, int &member) {
+    if (j.contains(key))
+      member = resolveInt(j[key], vars);
+  };
+  loadCell("x1", cfg.x1);
+  loadCell("y1", cfg.y1);
+  loadCell("x2", cfg.x2);
+  loadCell("y2", cfg.y2);
+  cfg.stride = std::max(1, cfg.stride);
+  cfg.samplingRate = std::max(0, cfg.samplingRate);
+  return cfg;
+}
+
+OutputConfig OutputConfig::fromJson(const nlohmann::json &j,
+                                    const std::map<std::string, int> &vars) {
+  OutputConfig cfg;
+  auto load = [&j](const char *key, auto &member) {
+    if (j.contains(key))
+      member = j[key].get<std::decay_t<decltype(member)>>();
+  };
+  load("async", cfg.async);
+  load("combined", cfg.combined);
+  load("queue_depth", cfg.queueDepth);
+  load("compression_level", cfg.writer.compressionLevel);
+  load("block_size", cfg.writer.blockSize);
+  load("series", cfg.writer.series);
+  if (j.contains("lossy")) {
+    // "lossy": {"sidecar": true, "fields": {"p": {"absolute": 1e-4},
+    //                                       "*": {"relative": 1e-3}}}
+    const nlohmann::json &l = j["lossy"];
+    if (l.contains("sidecar"))
+      cfg.writer.lossySidecar = l["sidecar"].get<bool>();
+    if (l.contains("fields"))
+      for (auto it = l["fields"].begin(); it != l["fields"].end(); ++it) {
+        ErrorBound b;
+        if (it.value().contains("absolute"))
+          b.absolute = it.value()["absolute"].get<double>();
+        if (it.value().contains("relative"))
+          b.relative = it.value()["relative"].get<double>();
+        cfg.writer.errorBounds[it.key()] = b;
+      }
+  }
+  if (j.contains("types"))
+    // "types": {"p": "float32", "smoke": {"type": "uint8", "scale": 0.004}}
+    for (auto it = j["types"].begin(); it != j["types"].end(); ++it) {
+      const nlohmann::json &t = it.value();
+      OutputType type;
+      const std::string name =
+          t.is_string() ? t.get<std::string>() : t.value("type", "native");
+      if (name == "float64")
+        type.kind = OutputType::Kind::FLOAT64;
+      else if (name == "float32")
+        type.kind = OutputType::Kind::FLOAT32;
+      else if (name == "int16")
+        type.kind = OutputType::Kind::INT16;
+      else if (name == "uint8")
+        type.kind = OutputType::Kind::UINT8;
+      else if (name != "native")
+        std::cerr << "[OutputConfig] Unknown output type '" << name
+                  << "' for '" << it.key() << "' – using native.\n";
+      if (t.is_object()) {
+        type.scale = t.value("scale", 0.0);
+        type.offset = t.value("offset", 0.0);
+      }
+      cfg.writer.types[it.key()] = type;
+    }
+  if (j.contains("views"))
+    for (const auto &v : j["views"]) {
+      cfg.views.push_back(ViewConfig::fromJson(v, vars));
+      if (cfg.views.back().name.empty())
+        cfg.views.back().name = "view" + std::to_string(cfg.views.size() - 1);
+    }
+  cfg.queueDepth = std::max(1, cfg.queueDepth);
+  cfg.writer.compressionLevel = std::clamp(cfg.writer.compressionLevel, 0, 9);
+  cfg.writer.blockSize = std::max<std::size_t>(cfg.writer.blockSize, 1024);
+  return cfg;
+}
+
+RenderConfig RenderConfig::fromJson(const nlohmann::json &j) {
+  RenderConfig cfg;
+  auto load = [&j](const char *key, auto &member) {
+    if (j.contains(key))
+      member = j[key].get<std::decay_t<decltype(member)>>();
+  };
+
+  if (j.contains("field")) {
+    const std::string f = j["field"].get<std::string>();
+    if (f == "smoke")
+      cfg.field = Field::SMOKE;
+    else if (f == "velocity")
+      cfg.field = Field::VELOCITY;
+    else if (f == "vorticity")
+      cfg.field = Field::VORTICITY;
+    else if (f == "pressure")
+      cfg.field = Field::PRESSURE;
+    else
+      std::cerr << "[RenderConfig] Unknown field '" << f
+                << "' – defaulting to smoke.\n";
+  }
+  if (j.contains("colormap")) {
+    const std::string c = j["colormap"].get<std::string>();
+    if (c == "viridis")
+      cfg.colormap = Colormap::VIRIDIS;
+    else if (c == "inferno")
+      cfg.colormap = Colormap::INFERNO;
+    else if (c == "coolwarm")
+      cfg.colormap = Colormap::COOLWARM;
+    else if (c == "gray")
+      cfg.colormap = Colormap::GRAY;
+    else
+      std::cerr << "[RenderConfig] Unknown colormap '" << c
+                << "' – defaulting to viridis.\n";
+  }
+  load("name", cfg.name);
+  load("every", cfg.every);
+  load("mask_solid", cfg.maskSolid);
+  load("scale", cfg.scale);
+  if (j.contains("range")) {
+    cfg.min = j["range"].at(0).get<double>();
+    cfg.max = j["range"].at(1).get<double>();
+  }
+  if (cfg.name.empty())
+    cfg.name = cfg.fieldName();
+  cfg.every = std::max(0, cfg.every);
+  cfg.scale = std::clamp(cfg.scale, 1, 16);
+  return cfg;
+}
+
+std::string RenderConfig::fieldName() const {
+  switch (field) {
+  case Field::SMOKE:
+    return "smoke";
+  case Field::VELOCITY:
+    return "velocity";
+  case Field::VORTICITY:
+    return "vorticity";
+  case Field::PRESSURE:
+    return "pressure";
+  }
+  return "unknown";
+}
+
+CheckpointConfig CheckpointConfig::fromJson(const nlohmann::json &j) {
+  CheckpointConfig cfg;
+  auto load = [&j](const char *key, auto &member) {
+    if (j.contains(key))
+      member = j[key].get<std::decay_t<decltype(member)>>();
+  };
+  load("every", cfg.every);
+  load("path", cfg.path);
+  cfg.every = std::max(0, cfg.every);
+  return cfg;
+}
+
+StatisticsConfig StatisticsConfig::fromJson(const nlohmann::json &j) {
+  StatisticsConfig cfg;
+  cfg.enabled = true;
+  cfg.fields = {"u", "v", "p"};
+  auto load = [&j](const char *key, auto &member) {
+    if (j.contains(key))
+      member = j[key].get<std::decay_t<decltype(member)>>();
+  };
+  load("fields", cfg.fields);
+  load("start", cfg.start);
+  load("every", cfg.every);
+
+  static const char *known[] = {"u",   "v",            "p",
+                                "div", "normVelocity", "smoke"};
+  std::vector<std::string> valid;
+  for (const std::string &f : cfg.fields) {
+    if (std::find(std::begin(known), std::end(known), f) == std::end(known))
+      std::cerr << "[StatisticsConfig] Unknown field '" << f
+                << "' – ignored.\n";
+    else if (std::find(valid.begin(), valid.end(), f) == valid.end())
+      valid.push_back(f);
+  }
+  cfg.fields = std::move(valid);
+  cfg.enabled = !cfg.fields.empty();
+  cfg.start = std::max(0, cfg.start);
+  cfg.every = std::max(1, cfg.every);
+  return cfg;
+}
+
+MonitorConfig MonitorConfig::fromJson(const nlohmann::json &j,
+                                      const std::map<std::string, int> &vars) {
+  MonitorConfig cfg;
+  cfg.enabled = true;
+  auto load = [](const nlohmann::json &node, const char *key, auto &member) {
+    if (node.contains(key))
+      member = node[key].get<std::decay_t<decltype(member)>>();
+  };
+  auto loadCell = [&vars](const nlohmann::json &node, const char *key,
+                          int &member) {
+    if (node.contains(key))
+      member = resolveInt(node[key], vars);
+  };
+  load(j, "file", cfg.file);
+  load(j, "every", cfg.every);
+  cfg.every = std::max(1, cfg.every);
+
+  if (j.contains("probes"))
+    for (const auto &node : j["probes"]) {
+      Probe probe;
+      probe.name = "probe" + std::to_string(cfg.probes.size());
+      probe.fields = {"u", "v", "p"};
+      load(node, "name", probe.name);
+      load(node, "fields", probe.fields);
+      // Fractional positions are plain numbers; expressions are integers.
+      auto loadPos = [&](const char *key, double &member) {
+        if (node.contains(key))
+          member = node[key].is_number() ? node[key].get<double>()
+                                         : resolveInt(node[key], vars);
+      };
+      loadPos("x", probe.x);
+      loadPos("y", probe.y);
+      for (const std::string &f : probe.fields)
+        if (f != "u" && f != "v" && f != "p" && f != "smoke")
+          std::cerr << "[MonitorConfig] Probe field '" << f
+                    << "' is not interpolated – written as 0.\n";
+      cfg.probes.push_back(std::move(probe));
+    }
+
+  if (j.contains("averages"))
+    for (const auto &node : j["averages"]) {
+      Average avg;
+      avg.name = "average" + std::to_string(cfg.averages.size());
+      avg.fields = {"u", "v", "p"};
+      load(node, "name", avg.name);
+      load(node, "fields", avg.fields);
+      loadCell(node, "x1", avg.x1);
+      loadCell(node, "y1", avg.y1);
+      loadCell(node, "x2", avg.x2);
+      loadCell(node, "y2", avg.y2);
+      for (const std::string &f : avg.fields)
+        if (f != "u" && f != "v" && f != "p" && f != "div" &&
+            f != "normVelocity" && f != "smoke")
+          std::cerr << "[MonitorConfig] Average field '" << f
+                    << "' is unknown – written as 0.\n";
+      cfg.averages.push_back(std::move(avg));
+    }
+
+  if (j.contains("forces")) {
+    const nlohmann::json &f = j["forces"];
+    cfg.forces = true;
+    loadCell(f, "x1", cfg.fx1);
+    loadCell(f, "y1", cfg.fy1);
+    loadCell(f, "x2", cfg.fx2);
+    loadCell(f, "y2", cfg.fy2);
+    load(f, "u_ref", cfg.uRef);
+    load(f, "length", cfg.length);
+  }
+  return cfg;
+}
+
+ProfileConfig ProfileConfig::fromJson(const nlohmann::json &j) {
+  ProfileConfig cfg;
+  if (j.is_boolean()) {
+    cfg.enabled = j.get<bool>();
+    return cfg;
+  }
+  cfg.enabled = true;
+  if (j.contains("file"))
+    cfg.file = j["file"].get<std::string>();
+  if (j.contains("counters"))
+    cfg.counters = j["counters"].get<bool>();
+  return cfg;
+}
+
+// SourceConfig
+
+double SourceConfig::scale(double time) const {
+  double a = 1.0;
+  if (ramp > 0.0)
+    a = std::min(1.0, time / ramp);
+  if (amplitude != 0.0)
+    a *= 1.0 + amplitude * std::sin(2.0 * std::acos(-1.0) * time / period);
+  return a;
+}
+
+SourceConfig SourceConfig::fromJson(const nlohmann::json &j) {
+  SourceConfig cfg;
+  if (j.is_boolean()) {
+    cfg.enabled = j.get<bool>();
+    return cfg;
+  }
+  cfg.enabled = true;
+  if (j.contains("ramp"))
+    cfg.ramp = j["ramp"].get<double>();
+  if (j.contains("amplitude"))
+    cfg.amplitude = j["amplitude"].get<double>();
+  if (j.contains("period"))
+    cfg.period = j["period"].get<double>();
+  if (cfg.period <= 0.0) {
+    std::cerr << "[SourceConfig] \"period\" must be positive – defaulting"
+                 " to 1.\n";
+    cfg.period = 1.0;
+  }
+  return cfg;
+}
+
 // Parameters
 
 void Parameters::loadFromJson(const nlohmann::json &j) {
@@ -64,7 +435,9 @@ void Parameters::loadFromJson(const nlohmann::json &j) {
   load("density", density);
  
   // simulation condition
-  load("source", source);
+  if (j.contains("source"))
+    source = SourceConfig::fromJson(j["source"]);
+  load("walls", walls);
 
   // Output flags
   load("write_u", write_u);
@@ -73,6 +446,19 @@ void Parameters::loadFromJson(const nlohmann::json &j) {
   load("write_div", write_div);
   load("write_norm_velocity", write_norm_velocity);
   load("write_smoke", write_smoke);
+  if (j.contains("output"))
+    output = OutputConfig::fromJson(j["output"], {{"nx", nx}, {"ny", ny}});
+  if (j.contains("checkpoint"))
+    checkpoint = CheckpointConfig::fromJson(j["checkpoint"]);
+  if (j.contains("statistics"))
+    statistics = StatisticsConfig::fromJson(j["statistics"]);
+  if (j.contains("monitors"))
+    monitors = MonitorConfig::fromJson(j["monitors"], {{"nx", nx}, {"ny", ny}});
+  if (j.contains("profile"))
+    profile = ProfileConfig::fromJson(j["profile"]);
+  if (j.contains("render"))
+    for (const auto &r : j["render"])
+      render.push_back(RenderConfig::fromJson(r));
 
   // Output paths
   load("folder", folder);
@@ -89,14 +475,52 @@ void Parameters::loadFromJson(const nlohmann::json &j) {
   if (j.contains("smoke"))
     smoke_json = j["smoke"];
 
+  // Distributed runs
+  load("mpi_halo", mpi_halo);
+
   // Solver
   if (j.contains("solver"))
     solver = SolverConfig::fromJson(j["solver"]);
+  if (j.contains("tiling"))
+    tiling = TilingConfig::fromJson(j["tiling"]);
+  if (j.contains("amr"))
+    amr = AMRConfig::fromJson(j["amr"]);
 }
 
 void Parameters::applyToFields(Fields2D &fields) const {
   const std::map<std::string, int> vars = {{"nx", nx}, {"ny", ny}};
 
+  if (!solid_json.is_null()) {
+    const auto solids = parseSceneObjects(solid_json, vars);
+    // Local rows each object can touch.
+    std::vector<std::pair<int, int>> rows(solids.size(), {0, fields.ny});
+    for (std::size_t k = 0; k < solids.size(); ++k) {
+      int j0, j1;
+      if (solids[k]->rowRange(j0, j1))
+        rows[k] = {j0 - fields.originJ, j1 - fields.originJ};
+    }
+    // Bands of rows are independent (only labels are written), so they
+    // are rasterised in parallel, each over every object it meets.
+    constexpr int kBand = 64;
+    const int bands = (fields.ny + kBand - 1) / kBand;
+#pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < bands; ++b) {
+      const int j0 = b * kBand;
+      const int j1 = std::min(j0 + kBand, fields.ny);
+      for (std::size_t k = 0; k < solids.size(); ++k) {
+        const int lo = std::max(j0, rows[k].first);
+        const int hi = std::min(j1, rows[k].second);
+        if (lo < hi)
+          solids[k]->applySolidRows(fields, lo, hi);
+      }
+    }
+  }
+  applySourcesToFields(fields);
+}
+
+void Parameters::applySourcesToFields(Fields2D &fields) const {
+  const std::map<std::string, int> vars = {{"nx", nx}, {"ny", ny}};
+
   if (!velocityU_json.is_null()) {
     for (const auto &obj : parseSceneObjects(velocityU_json, vars))
       obj->applyVelocityU(fields);
@@ -105,16 +529,19 @@ void Parameters::applyToFields(Fields2D &fields) const {
     for (const auto &obj : parseSceneObjects(velocityV_json, vars))
       obj->applyVelocityV(fields);
   }
-  if (!solid_json.is_null()) {
-    for (const auto &obj : parseSceneObjects(solid_json, vars))
-      obj->applySolid(fields);
-  } 
   if (!smoke_json.is_null()) {
     for (const auto &obj : parseSceneObjects(smoke_json, vars))
       obj->applySmoke(fields);
   }
 }
 
+std::vector<std::unique_ptr<SceneObject>>
+Parameters::velocityUObjects() const {
+  if (velocityU_json.is_null())
+    return {};
+  return parseSceneObjects(velocityU_json, {{"nx", nx}, {"ny", ny}});
+}
+
 bool Parameters::loadFromFile(const std::string &path) {
   try {
     std::ifstream file(path);
@@ -136,19 +563,61 @@ bool Parameters::loadFromFile(const std::string &path) {
 }
 
 bool Parameters::parseCommandLine(int argc, char *argv[]) {
-  // Expect exactly:  <prog> -c <path>  or  <prog> --config <path>
-  if (argc == 3) {
-    const std::string_view flag = argv[1];
-    if (flag == "-c" || flag == "--config")
-      return loadFromFile(argv[2]);
+  // Expect:  <prog> -c <path> [--ensemble <sweep.json>] [--restart <file>]
+  //                 [--scaling <mode> [--threads <list>] [--steps <n>]]
+  //                 [--convergence <sizes> [--solvers <list>]
+  //                  [--tolerances <list>] [--target <error>]]
+  for (int k = 1; k < argc; ++k) {
+    const std::string_view flag = argv[k];
+    const bool hasValue = k + 1 < argc;
+    if ((flag == "-c" || flag == "--config") && hasValue)
+      config_path = argv[++k];
+    else if (flag == "--ensemble" && hasValue)
+      ensemble = argv[++k];
+    else if (flag == "--restart" && hasValue)
+      restart = argv[++k];
+    else if (flag == "--scaling" && hasValue)
+      scaling = argv[++k];
+    else if (flag == "--steps" && hasValue)
+      scaling_steps = std::atoi(argv[++k]);
+    else if (flag == "--threads" && hasValue)
+      for (const std::string &item : splitList(argv[++k]))
+        scaling_threads.push_back(std::atoi(item.c_str()));
+    else if (flag == "--convergence" && hasValue)
+      for (const std::string &item : splitList(argv[++k]))
+        convergence.push_back(std::atoi(item.c_str()));
+    else if (flag == "--solvers" && hasValue)
+      convergence_solvers = splitList(argv[++k]);
+    else if (flag == "--tolerances" && hasValue)
+      for (const std::string &item : splitList(argv[++k]))
+        convergence_tolerances.push_back(std::atof(item.c_str()));
+    else if (flag == "--target" && hasValue)
+      convergence_target = std::atof(argv[++k]);
+    else {
+      printUsage(argv[0]);
+      return false;
+    }
+  }
+  if (!scaling.empty() && scaling != "strong" && scaling != "weak" &&
+      scaling != "both") {
+    std::cerr << "[Parameters] --scaling expects strong, weak or both\n";
+    return false;
+  }
+  if (config_path.empty()) {
+    printUsage(argv[0]);
+    return false;
   }
-  printUsage(argv[0]);
-  return false;
+  return loadFromFile(config_path);
 }
 
 void Parameters::printUsage(const char *prog) {
   // RTFM
-  std::cout << "Usage: " << prog << " -c <config.json>\n";
+  std::cout << "Usage: " << prog << " -c <config.json>"
+            << " [--ensemble <sweep.json>] [--restart <checkpoint>]\n"
+            << "       [--scaling strong|weak|both] [--threads 1,2,4]"
+            << " [--steps 20]\n"
+            << "       [--convergence 32,64,128] [--solvers jacobi,...]"
+            << " [--tolerances 1e-2,1e-4] [--target 1e-3]\n";
 }
 
 std::ostream &operator<<(std::ostream &os, const Parameters &p) {
@@ -160,11 +629,50 @@ std::ostream &operator<<(std::ostream &os, const Parameters &p) {
      << "  Sampling: every " << p.sampling_rate << " step(s)" << '\n'
      << "  Solver  : " << p.solver.typeName()
      << "  maxIter=" << p.solver.maxIters << "  tol=" << p.solver.tolerance
+     << "  log=" << (p.solver.log ? "on" : "off") << '\n'
+     << "  Tiling  : " << (p.tiling.enabled ? "on" : "off")
+     << "  tile=" << p.tiling.tileSize << "  thr=" << p.tiling.threshold
      << '\n'
+     << "  AMR     : " << (p.amr.enabled ? "on" : "off")
+     << "  levels=" << p.amr.maxLevel << "  ratio=" << p.amr.ratio << '\n'
+     << "  MPI halo: " << p.mpi_halo << '\n'
      << "  Output  : folder='" << p.folder << "'\n"
      << "  Write   : u=" << p.write_u << " v=" << p.write_v
      << " p=" << p.write_p << " div=" << p.write_div
      << " norm=" << p.write_norm_velocity << '\n'
+     << "  Checkpt : every " << p.checkpoint.every << " step(s)"
+     << (p.restart.empty() ? "" : "  restart='" + p.restart + "'") << '\n'
+     << "  Stats   : "
+     << (p.statistics.enabled ? std::to_string(p.statistics.fields.size()) +
+                                    " field(s) from step " +
+                                    std::to_string(p.statistics.start)
+                              : std::string("off"))
+     << '\n'
+     << "  Monitors: "
+     << (p.monitors.enabled
+             ? std::to_string(p.monitors.probes.size()) + " probe(s), " +
+                   std::to_string(p.monitors.averages.size()) +
+                   " average(s), forces " + (p.monitors.forces ? "on" : "off")
+             : std::string("off"))
+     << '\n'
+     << "  Profile : "
+     << (p.profile.enabled
+             ? (p.profile.file.empty() ? p.folder + "/profile.json"
+                                       : p.profile.file) +
+                   (p.profile.counters ? "  counters=on" : "")
+             : std::string("off"))
+     << '\n'
+     << "  Async   : " << (p.output.async ? "on" : "off")
+     << "  combined=" << (p.output.combined ? "on" : "off")
+     << "  queue=" << p.output.queueDepth
+     << "  zlib=" << p.output.writer.compressionLevel
+     << "  block=" << p.output.writer.blockSize
+     << "  series=" << (p.output.writer.series ? "on" : "off")
+     << "  lossy=" << p.output.writer.errorBounds.size() << " field(s)"
+     << "  types=" << p.output.writer.types.size() << " field(s)"
+     << "  views=" << p.output.views.size()
+     << "  images=" << p.render.size()
+     << '\n'
      << "  InitVelU: " << (!p.velocityU_json.is_null() ? "defined" : "none")
      << '\n'
      << "  InitVelV: " << (!p.velocityV_json.is_null() ? "defined" : "none")
@@ -1,4 +1,5 @@
 #pragma once
+#include "OutputWriter.hpp"
 #include "SceneObjects.hpp"
 #include <nlohmann/json.hpp>
 #include <ostream>
@@ -30,10 +31,18 @@ struct SolverConfig {
   int maxIters = 1000;            ///< Maximum number of iterations per step.
   double tolerance = 1e-2;        ///< Relative residual convergence threshold.
 
+  // Convergence log (see SolverTelemetry)
+  bool log = false;              ///< Write the per-step CSV and summary.
+  std::string logFile;           ///< CSV path; empty = <folder>/pressure.csv.
+  std::vector<int> historySteps; ///< Steps whose residual history is kept.
+  int historyEvery = 0;          ///< Also keep it every N steps (0 = off).
+
   /**
    * @brief Construct a SolverConfig from a JSON object.
    *
-   * Recognised keys: @c "type", @c "max_iterations", @c "tolerance".
+   * Recognised keys: @c "type", @c "max_iterations", @c "tolerance" and
+   * @c "log" (@c true, or an object with @c "file", @c "history" (step
+   * list) and @c "history_every").
    * Unknown solver types fall back to GAUSS_SEIDEL with a warning.
    *
    * @param j JSON object node.
@@ -45,6 +54,318 @@ struct SolverConfig {
   [[nodiscard]] std::string typeName() const;
 };
 
+// TilingConfig
+/**
+ * @brief Configuration of the tile-activity map (see TileMap).
+ */
+struct TilingConfig {
+  bool enabled = false;    ///< Skip SOLID / quiescent tiles in the kernels.
+  int tileSize = 32;       ///< Tile edge length in cells.
+  double threshold = 1e-6; ///< |u|, |v| below which a tile is quiescent.
+
+  /**
+   * @brief Construct a TilingConfig from a JSON object.
+   *
+   * Recognised keys: @c "enabled", @c "tile_size", @c "threshold".
+   *
+   * @param j JSON object node.
+   * @return  Populated TilingConfig.
+   */
+  [[nodiscard]] static TilingConfig fromJson(const nlohmann::json &j);
+};
+
+// AMRConfig
+/**
+ * @brief Configuration of block-structured adaptive refinement (see
+ *        AMRHierarchy).
+ *
+ * Each refinement criterion is disabled when its threshold is 0.
+ */
+struct AMRConfig {
+  bool enabled = false;       ///< Run refined patches on top of the base grid.
+  int maxLevel = 1;           ///< Number of refined levels above the base.
+  int ratio = 2;              ///< Refinement ratio between levels.
+  int blockSize = 16;         ///< Patch granularity, in parent cells.
+  int ghost = 4;              ///< Ghost-ring width of a patch, in fine cells.
+  int regridEvery = 10;       ///< Re-evaluate the criteria every N steps.
+  double vorticity = 0.0;     ///< Refine where |curl u| exceeds this (1/s).
+  int solidDistance = 0;      ///< Refine within N parent cells of SOLID.
+  double smokeGradient = 0.0; ///< Refine where |smoke jump| per cell exceeds
+                              ///< this.
+
+  /**
+   * @brief Construct an AMRConfig from a JSON object.
+   *
+   * Recognised keys: @c "enabled", @c "max_level", @c "ratio",
+   * @c "block_size", @c "ghost", @c "regrid_every", @c "vorticity",
+   * @c "solid_distance", @c "smoke_gradient".
+   *
+   * @param j JSON object node.
+   * @return  Populated AMRConfig.
+   */
+  [[nodiscard]] static AMRConfig fromJson(const nlohmann::json &j);
+};
+
+// ViewConfig
+/**
+ * @brief One extra output series: a sub-rectangle of the grid, optionally
+ *        downsampled, written at its own sampling rate.
+ *
+ * Arrays are resampled to cell centres (as in combined output) and written
+ * to @c \<name\>_NNNN.vti with physical @c Origin / @c Spacing, so views
+ * at different resolutions overlay correctly in ParaView.
+ */
+struct ViewConfig {
+  std::string name;                ///< Series name (file prefix), unique.
+  std::vector<std::string> fields; ///< Arrays to write; empty = every field
+                                   ///< enabled by the write_* flags.
+  int x1 = 0, y1 = 0;   ///< First cell of the rectangle.
+  int x2 = -1, y2 = -1; ///< Last cell (inclusive). Negative coordinates
+                        ///< count from the end: -1 = last grid cell.
+  int stride = 1;       ///< Keep every stride-th cell in x and y.
+  bool average = false; ///< Average stride × stride blocks instead of
+                        ///< sampling one cell per block.
+  int samplingRate = 0; ///< Steps between frames; 0 = global sampling_rate.
+
+  /**
+   * @brief Construct a ViewConfig from a JSON object.
+   *
+   * Recognised keys: @c "name", @c "fields", @c "x1", @c "y1", @c "x2",
+   * @c "y2" (integers or expressions in @c nx / @c ny, see resolveInt()),
+   * @c "stride", @c "average", @c "sampling_rate".
+   *
+   * @param j    JSON object node.
+   * @param vars Variable bindings for the rectangle expressions.
+   * @return     Populated ViewConfig.
+   */
+  [[nodiscard]] static ViewConfig
+  fromJson(const nlohmann::json &j, const std::map<std::string, int> &vars);
+};
+
+// OutputConfig
+/**
+ * @brief Configuration of the output pipeline (see OutputWriter,
+ *        AsyncWriter).
+ */
+struct OutputConfig {
+  bool async = false;    ///< Compress and write on a background thread.
+  bool combined = false; ///< All fields in one cell-centred .vti per step.
+  int queueDepth = 2; ///< Snapshots in flight (staging buffers) when async.
+  WriterOptions writer; ///< Compression level and block size.
+  std::vector<ViewConfig> views; ///< Extra region / downsampled series.
+
+  /**
+   * @brief Construct an OutputConfig from a JSON object.
+   *
+   * Recognised keys: @c "async", @c "combined", @c "queue_depth",
+   * @c "compression_level", @c "block_size" (bytes), @c "series" and
+   * @c "lossy" (@c "sidecar", @c "fields": name → {@c "absolute",
+   * @c "relative"}), @c "views" (array, see ViewConfig).
+   *
+   * @param j    JSON object node.
+   * @param vars Variable bindings forwarded to ViewConfig::fromJson().
+   * @return     Populated OutputConfig.
+   */
+  [[nodiscard]] static OutputConfig
+  fromJson(const nlohmann::json &j, const std::map<std::string, int> &vars);
+};
+
+// RenderConfig
+/**
+ * @brief One in-situ image sequence (see Renderer).
+ */
+struct RenderConfig {
+  /// Scalar shown in the image, sampled at cell centres.
+  enum class Field {
+    SMOKE,     ///< Smoke concentration.
+    VELOCITY,  ///< Velocity magnitude |u|.
+    VORTICITY, ///< Vorticity dv/dx - du/dy.
+    PRESSURE   ///< Pressure.
+  };
+  /// Colour maps (256-entry tables built from a few control points).
+  enum class Colormap {
+    VIRIDIS,  ///< Perceptually uniform, dark blue to yellow.
+    INFERNO,  ///< Perceptually uniform, black to pale yellow.
+    COOLWARM, ///< Diverging blue-white-red; auto range is symmetric.
+    GRAY      ///< Black to white.
+  };
+
+  Field field = Field::SMOKE;
+  Colormap colormap = Colormap::VIRIDIS;
+  std::string name;       ///< File prefix; defaults to the field name.
+  int every = 0;          ///< Steps between images; 0 = global sampling_rate.
+  bool maskSolid = true;  ///< Draw SOLID cells in a flat grey.
+  int scale = 1;          ///< Pixels per cell along each axis.
+  double min = 0.0;       ///< Colour range; min == max selects the range
+  double max = 0.0;       ///< of each frame automatically.
+
+  /**
+   * @brief Construct a RenderConfig from a JSON object.
+   *
+   * Recognised keys: @c "field" (@c "smoke", @c "velocity", @c "vorticity",
+   * @c "pressure"), @c "colormap" (@c "viridis", @c "inferno",
+   * @c "coolwarm", @c "gray"), @c "name", @c "every", @c "mask_solid",
+   * @c "scale", @c "range" ([min, max]). Unknown names fall back to the
+   * defaults with a warning.
+   *
+   * @param j JSON object node.
+   * @return  Populated RenderConfig.
+   */
+  [[nodiscard]] static RenderConfig fromJson(const nlohmann::json &j);
+
+  /// @return The field as a lowercase string (matches JSON values).
+  [[nodiscard]] std::string fieldName() const;
+};
+
+// CheckpointConfig
+/**
+ * @brief Periodic restart snapshots (see Checkpoint).
+ */
+struct CheckpointConfig {
+  int every = 0;    ///< Write a checkpoint every N steps (0 = never).
+  std::string path; ///< Checkpoint file; empty = @c \<folder\>/checkpoint.pic.
+
+  /**
+   * @brief Construct a CheckpointConfig from a JSON object.
+   *
+   * Recognised keys: @c "every", @c "path".
+   *
+   * @param j JSON object node.
+   * @return  Populated CheckpointConfig.
+   */
+  [[nodiscard]] static CheckpointConfig fromJson(const nlohmann::json &j);
+};
+
+// StatisticsConfig
+/**
+ * @brief In-situ running statistics (see RunningStatistics).
+ */
+struct StatisticsConfig {
+  bool enabled = false;            ///< Set when the "statistics" key exists.
+  std::vector<std::string> fields; ///< Fields accumulated (u, v, p, ...).
+  int start = 1; ///< First step sampled (skips the start-up transient).
+  int every = 1; ///< Steps between samples.
+
+  /**
+   * @brief Construct a StatisticsConfig from a JSON object.
+   *
+   * Recognised keys: @c "fields" (any of @c "u", @c "v", @c "p", @c "div",
+   * @c "normVelocity", @c "smoke"; default u, v, p), @c "start",
+   * @c "every".
+   *
+   * @param j JSON object node.
+   * @return  Populated StatisticsConfig.
+   */
+  [[nodiscard]] static StatisticsConfig fromJson(const nlohmann::json &j);
+};
+
+// MonitorConfig
+/**
+ * @brief Per-step time series of probes, region averages and body forces
+ *        (one CSV row per sampled step).
+ *
+ * Cell coordinates accept integers or expressions in @c nx / @c ny (see
+ * resolveInt()); probe coordinates may also be fractional. Probe (x, y)
+ * sits at the physical point ((x + 0.5)·dx, (y + 0.5)·dy), so integer
+ * coordinates are cell centres.
+ */
+struct MonitorConfig {
+  /// @brief Bilinearly interpolated values at one point.
+  struct Probe {
+    std::string name;                ///< Column prefix.
+    double x = 0.0, y = 0.0;         ///< Position in cells.
+    std::vector<std::string> fields; ///< Any of u, v, p, smoke.
+  };
+
+  /// @brief Mean over the FLUID cells of a rectangle (a line when one side
+  ///        is a single cell).
+  struct Average {
+    std::string name;                ///< Column prefix.
+    int x1 = 0, y1 = 0;              ///< First cell.
+    int x2 = -1, y2 = -1;            ///< Last cell (inclusive); negative =
+                                     ///< from the end, -1 = last.
+    std::vector<std::string> fields; ///< Any of u, v, p, div, normVelocity,
+                                     ///< smoke.
+  };
+
+  bool enabled = false; ///< Set when the "monitors" key exists.
+  std::string file;     ///< CSV path; empty = @c \<folder\>/monitors.csv.
+  int every = 1;        ///< Steps between rows.
+  std::vector<Probe> probes;
+  std::vector<Average> averages;
+
+  bool forces = false; ///< Integrate the pressure force on SOLID cells.
+  int fx1 = 1, fy1 = 1;   ///< First cell of the force region.
+  int fx2 = -2, fy2 = -2; ///< Last cell; negative = counted from the end,
+                          ///< -1 = last (the default skips the outer wall
+                          ///< ring).
+  double uRef = 1.0;   ///< Reference velocity of Cd / Cl.
+  double length = 0.0; ///< Reference length (m); 0 = height of the body.
+
+  /**
+   * @brief Construct a MonitorConfig from a JSON object.
+   *
+   * Recognised keys: @c "file", @c "every", @c "probes" (objects with
+   * @c "name", @c "x", @c "y", @c "fields"), @c "averages" (objects with
+   * @c "name", @c "x1", @c "y1", @c "x2", @c "y2", @c "fields") and
+   * @c "forces" (object with @c "x1", @c "y1", @c "x2", @c "y2",
+   * @c "u_ref", @c "length").
+   *
+   * @param j    JSON object node.
+   * @param vars Variable bindings for the cell expressions.
+   * @return     Populated MonitorConfig.
+   */
+  [[nodiscard]] static MonitorConfig
+  fromJson(const nlohmann::json &j, const std::map<std::string, int> &vars);
+};
+
+// ProfileConfig
+/**
+ * @brief Per-phase timing report written at the end of Run() (see Profiler).
+ */
+struct ProfileConfig {
+  bool enabled = false; ///< Set by @c "profile": true or an object.
+  std::string file;     ///< JSON path; empty = @c \<folder\>/profile.json.
+  bool counters = false; ///< Hardware counters (perf_event_open, Linux).
+
+  /**
+   * @brief Construct a ProfileConfig from @c true / @c false or an object
+   *        with @c "file" and @c "counters".
+   * @param j JSON node.
+   * @return  Populated ProfileConfig.
+   */
+  [[nodiscard]] static ProfileConfig fromJson(const nlohmann::json &j);
+};
+
+// SourceConfig
+/**
+ * @brief Scene objects re-imposed every step (see SceneSources).
+ *
+ * The velocity sources are scaled by
+ * @code
+ *   a(t) = min(1, t / ramp) · (1 + amplitude · sin(2π t / period))
+ * @endcode
+ * where t is the time at the start of the step. The defaults give a(t) = 1.
+ * Smoke sources are never scaled.
+ */
+struct SourceConfig {
+  bool enabled = false;   ///< Set by @c "source": true or an object.
+  double ramp = 0.0;      ///< Linear ramp-up time (s); 0 = none.
+  double amplitude = 0.0; ///< Relative oscillation amplitude.
+  double period = 1.0;    ///< Oscillation period (s).
+
+  /// @return The velocity scale a(@p time).
+  [[nodiscard]] double scale(double time) const;
+
+  /**
+   * @brief Construct a SourceConfig from @c true / @c false or an object
+   *        with @c "ramp", @c "amplitude" and @c "period".
+   * @param j JSON node.
+   * @return  Populated SourceConfig.
+   */
+  [[nodiscard]] static SourceConfig fromJson(const nlohmann::json &j);
+};
+
 // Parameters
 /**
  * @brief All simulation parameters parsed from a JSON configuration file.
@@ -74,7 +395,9 @@ public:
   std::string filename =
       "simulation"; ///< Base filename (unused at runtime, reserved).
 
-  bool source = false;              ///< create a source.
+  SourceConfig source;              ///< Per-step scene sources.
+  bool walls = false; ///< Zero normal velocity on all four domain edges.
+  bool quiet = false;               ///< Suppress the progress line in Run().
 
   bool write_u = true;              ///< Write u-velocity field.
   bool write_v = true;              ///< Write v-velocity field.
@@ -82,15 +405,44 @@ public:
   bool write_div = false;           ///< Write divergence field (diagnostic).
   bool write_norm_velocity = false; ///< Write velocity magnitude (diagnostic).
   bool write_smoke = false;         ///< Write smoke (diagnostic).
+  OutputConfig output;              ///< Output pipeline settings.
+  CheckpointConfig checkpoint;      ///< Restart snapshot settings.
+  std::vector<RenderConfig> render; ///< In-situ image sequences.
+  StatisticsConfig statistics;      ///< Running mean / RMS / extrema.
+  MonitorConfig monitors;           ///< Probe / force time series.
+  ProfileConfig profile;            ///< Timing report.
 
   // Solver
   SolverConfig solver; ///< Pressure solver settings.
+  TilingConfig tiling; ///< Tile-activity map settings.
+  AMRConfig amr;       ///< Adaptive refinement settings.
+
+  // Command line
+  std::string config_path; ///< Path given with -c / --config.
+  std::string ensemble;    ///< Sweep specification (--ensemble), or empty.
+  std::string restart;     ///< Checkpoint to resume from (--restart), or empty.
+  std::string scaling; ///< Thread-scaling mode (--scaling), or empty.
+  std::vector<int> scaling_threads; ///< Thread counts (--threads), or empty.
+  int scaling_steps = 20;           ///< Steps per scaling run (--steps).
+  std::vector<int> convergence; ///< Resolution ladder (--convergence).
+  std::vector<std::string> convergence_solvers; ///< Solvers (--solvers).
+  std::vector<double> convergence_tolerances;   ///< Tolerances (--tolerances).
+  double convergence_target = 0.0; ///< Velocity L2 error goal (--target).
+
+  // Distributed runs (PIC_MPI only)
+  int mpi_halo = 4; ///< Ghost-layer width between MPI blocks, in cells.
 
   // Life cycle
   Parameters() = default;
 
   /**
-   * @brief Parse @c -c / @c --config \<path\> from @c argv and load the file.
+   * @brief Parse the command line and load the config file.
+   *
+   * Recognised options: @c -c / @c --config \<path\> (required),
+   * @c --ensemble \<sweep.json\>, @c --restart \<checkpoint\> and
+   * @c --scaling \<strong|weak|both\> with @c --threads \<1,2,4\> and
+   * @c --steps \<n\>, and @c --convergence \<32,64\> with @c --solvers,
+   * @c --tolerances and @c --target.
    * @param argc Argument count from @c main.
    * @param argv Argument vector from @c main.
    * @return @c true on success, @c false on error (usage is printed).
@@ -116,6 +468,24 @@ public:
    */
   void applyToFields(Fields2D &fields) const;
 
+  /**
+   * @brief Apply only the velocity and smoke objects to @p fields — what a
+   *        source re-imposes (SceneSources compiles this once).
+   * @param fields Target fields to mutate.
+   */
+  void applySourcesToFields(Fields2D &fields) const;
+
+  /// @return The initial u-velocity scene objects, built on demand (the
+  ///         convergence driver reads the analytic solution from them).
+  [[nodiscard]] std::vector<std::unique_ptr<SceneObject>>
+  velocityUObjects() const;
+
+  /**
+   * @brief Populate members from a parsed JSON object.
+   * @param j Root JSON object of the config file.
+   */
+  void loadFromJson(const nlohmann::json &j);
+
   /// Pretty-print all parameters to @p os (debug builds).
   friend std::ostream &operator<<(std::ostream &os, const Parameters &p);
 
@@ -126,12 +496,6 @@ private:
   nlohmann::json solid_json;     ///< JSON node for solid geometry.
   nlohmann::json smoke_json;     ///< JSON node for solid geometry.
 
-  /**
-   * @brief Populate members from a parsed JSON object.
-   * @param j Root JSON object of the config file.
-   */
-  void loadFromJson(const nlohmann::json &j);
-
   /// Print command-line usage to stdout.
   static void printUsage(const char *prog);
 };
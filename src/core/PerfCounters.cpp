@@ -0,0 +1,152 @@
+#include "PerfCounters.hpp"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char *PerfCounters::eventName(Event event) {
+  switch (event) {
+  case CYCLES:
+    return "cycles";
+  case INSTRUCTIONS:
+    return "instructions";
+  case CACHE_REFERENCES:
+    return "cache_references";
+  case CACHE_MISSES:
+    return "cache_misses";
+  case L1D_READ_MISSES:
+    return "l1d_read_misses";
+  case NUM_EVENTS:
+    break;
+  }
+  return "?";
+}
+
+#ifdef __linux__
+
+namespace {
+
+/// The counter group of one thread; closed when the thread exits.
+struct Group {
+  bool tried = false;
+  std::string error;                         ///< Why the leader failed.
+  int leader = -1;                           ///< Cycles; -1 = unavailable.
+  std::array<int, PerfCounters::NUM_EVENTS> fd{};
+  std::array<int, PerfCounters::NUM_EVENTS> slot{}; ///< Position in a read.
+  int members = 0;
+
+  Group() {
+    fd.fill(-1);
+    slot.fill(-1);
+  }
+  ~Group() {
+    for (int f : fd)
+      if (f >= 0)
+        close(f);
+  }
+  Group(const Group &) = delete;
+  Group &operator=(const Group &) = delete;
+
+  void open() {
+    tried = true;
+    for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e) {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      switch (e) {
+      case PerfCounters::CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case PerfCounters::INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case PerfCounters::CACHE_REFERENCES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_REFERENCES;
+        break;
+      case PerfCounters::CACHE_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+      default:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D |
+                      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+      }
+      // Calling thread, any CPU; members join the leader's group.
+      const long f = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+      if (f < 0) {
+        if (e == PerfCounters::CYCLES) {
+          error = std::strerror(errno);
+          return;
+        }
+        continue; // optional event not offered
+      }
+      fd[e] = static_cast<int>(f);
+      slot[e] = members++;
+      if (e == PerfCounters::CYCLES)
+        leader = fd[e];
+    }
+  }
+};
+
+Group &threadGroup() {
+  thread_local Group group;
+  if (!group.tried)
+    group.open();
+  return group;
+}
+
+} // namespace
+
+bool PerfCounters::probe(std::string &reason) {
+  const Group &g = threadGroup();
+  if (g.leader < 0)
+    reason = "perf_event_open: " + g.error;
+  return g.leader >= 0;
+}
+
+bool PerfCounters::has(Event event) { return threadGroup().fd[event] >= 0; }
+
+bool PerfCounters::read(Values &out) {
+  const Group &g = threadGroup();
+  if (g.leader < 0)
+    return false;
+  // { nr, time_enabled, time_running, value[nr] }
+  std::uint64_t buf[3 + NUM_EVENTS] = {};
+  if (::read(g.leader, buf, sizeof(buf)) < 0)
+    return false;
+  const double scale =
+      buf[2] > 0 ? static_cast<double>(buf[1]) / static_cast<double>(buf[2])
+                 : 1.0;
+  for (int e = 0; e < NUM_EVENTS; ++e)
+    out[e] = g.slot[e] >= 0 && static_cast<std::uint64_t>(g.slot[e]) < buf[0]
+                 ? static_cast<double>(buf[3 + g.slot[e]]) * scale
+                 : 0.0;
+  return true;
+}
+
+#else
+
+bool PerfCounters::probe(std::string &reason) {
+  reason = "perf_event_open is Linux only";
+  return false;
+}
+
+bool PerfCounters::has(Event) { return false; }
+
+bool PerfCounters::read(Values &) { return false; }
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <string>
+
+/**
+ * @file PerfCounters.hpp
+ * @brief Per-thread hardware counters through Linux @c perf_event_open.
+ */
+
+/**
+ * @brief Reads the hardware counters of the calling thread.
+ *
+ * Each thread opens its own counter group on first use (user-space
+ * events only, so @c perf_event_paranoid up to 2 suffices) and keeps it
+ * until the thread exits; OpenMP pool threads therefore open it once.
+ * Events the CPU or the kernel does not offer are left out of the group;
+ * if the group leader (cycles) cannot be opened, e.g. in a container or a
+ * VM without a virtual PMU, the counters are unavailable and read()
+ * returns @c false. Counts are scaled by enabled / running time when the
+ * kernel multiplexes the group.
+ *
+ * On other systems every call reports "unavailable".
+ */
+class PerfCounters {
+public:
+  /// @brief Counted events.
+  enum Event {
+    CYCLES,           ///< Core cycles.
+    INSTRUCTIONS,     ///< Retired instructions.
+    CACHE_REFERENCES, ///< Last-level cache accesses.
+    CACHE_MISSES,     ///< Last-level cache misses.
+    L1D_READ_MISSES,  ///< L1 data-cache load misses.
+    NUM_EVENTS
+  };
+
+  /// Counts per event; events that could not be opened stay 0.
+  using Values = std::array<double, NUM_EVENTS>;
+
+  /// @return Name of @p event in the report ("cycles", ...).
+  static const char *eventName(Event event);
+
+  /**
+   * @brief Open the counters of the calling thread.
+   * @param reason Set to the failure cause when unavailable.
+   * @return @c true if at least cycles can be counted.
+   */
+  static bool probe(std::string &reason);
+
+  /// @return @c true if @p event was opened on the calling thread.
+  static bool has(Event event);
+
+  /**
+   * @brief Current counts of the calling thread (opens them on first use).
+   * @return @c false if the counters are unavailable.
+   */
+  static bool read(Values &out);
+};
@@ -0,0 +1,221 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <numeric>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+constexpr double kLineBytes = 64.0; ///< Bytes moved per last-level miss.
+
+/// Nearest-rank percentile of sorted @p v, @p q in [0, 1].
+double percentile(const std::vector<double> &v, double q) {
+  if (v.empty())
+    return 0.0;
+  const auto k =
+      static_cast<std::size_t>(q * static_cast<double>(v.size() - 1) + 0.5);
+  return v[std::min(k, v.size() - 1)];
+}
+
+} // namespace
+
+const char *Profiler::phaseName(Phase phase) {
+  switch (phase) {
+  case SOURCES:
+    return "sources";
+  case PROJECT:
+    return "project";
+  case ADVECT:
+    return "advect";
+  case ADVECT_SMOKE:
+    return "advect_smoke";
+  case DIAGNOSTICS:
+    return "diagnostics";
+  case EXCHANGE:
+    return "exchange";
+  case AMR:
+    return "amr";
+  case OUTPUT:
+    return "output";
+  case CHECKPOINT:
+    return "checkpoint";
+  case STEP:
+    return "step";
+  case NUM_PHASES:
+    break;
+  }
+  return "?";
+}
+
+Profiler::Profiler() : start_(GET_TIME()) {
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+  threads_.resize(static_cast<std::size_t>(threads));
+}
+
+void Profiler::nextStep() {
+  for (int k = 0; k < NUM_PHASES; ++k) {
+    samples_[k].push_back(current_[k]);
+    current_[k] = 0.0;
+  }
+}
+
+void Profiler::addThread(Phase phase, double seconds) {
+  int t = 0;
+#ifdef _OPENMP
+  t = omp_get_thread_num();
+#endif
+  if (t < static_cast<int>(threads_.size()))
+    threads_[t].busy[phase] += seconds;
+}
+
+bool Profiler::enableCounters() {
+  counters_ = PerfCounters::probe(countersReason_);
+  return counters_;
+}
+
+void Profiler::addThreadCounters(Phase phase,
+                                 const PerfCounters::Values &start) {
+  PerfCounters::Values now{};
+  if (!PerfCounters::read(now))
+    return;
+  int t = 0;
+#ifdef _OPENMP
+  t = omp_get_thread_num();
+#endif
+  if (t >= static_cast<int>(threads_.size()))
+    return;
+  for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e)
+    threads_[t].events[phase][e] += now[e] - start[e];
+}
+
+nlohmann::json Profiler::report(std::int64_t cells,
+                                std::uint64_t bytesWritten) const {
+  const double wall = GET_TIME() - start_;
+  const std::size_t steps = samples_[STEP].size();
+  const double stepTotal = std::accumulate(samples_[STEP].begin(),
+                                           samples_[STEP].end(), 0.0);
+
+  nlohmann::json phases = nlohmann::json::object();
+  nlohmann::json roofline = nlohmann::json::array();
+  for (int k = 0; k < NUM_PHASES; ++k) {
+    std::vector<double> v = samples_[k];
+    if (!v.empty())
+      v.back() += current_[k]; // work after the last step (final drain)
+    const double total = std::accumulate(v.begin(), v.end(), 0.0);
+    if (total <= 0.0)
+      continue; // never entered
+    std::sort(v.begin(), v.end());
+    nlohmann::json p = {
+        {"total_s", total},
+        {"fraction", stepTotal > 0.0 ? total / stepTotal : 0.0},
+        {"mean_s", total / static_cast<double>(v.size())},
+        {"p50_s", percentile(v, 0.50)},
+        {"p90_s", percentile(v, 0.90)},
+        {"p99_s", percentile(v, 0.99)},
+        {"max_s", v.back()}};
+
+    // Busy time of the threads that took part in instrumented loops.
+    double lo = 0.0, hi = 0.0, sum = 0.0;
+    int active = 0;
+    for (const ThreadSlot &slot : threads_) {
+      const double b = slot.busy[k];
+      if (b <= 0.0)
+        continue;
+      lo = active == 0 ? b : std::min(lo, b);
+      hi = std::max(hi, b);
+      sum += b;
+      ++active;
+    }
+    if (active > 0) {
+      const double mean = sum / active;
+      p["threads"] = {{"active", active},
+                      {"busy_min_s", lo},
+                      {"busy_mean_s", mean},
+                      {"busy_max_s", hi},
+                      {"imbalance", mean > 0.0 ? hi / mean : 1.0}};
+    }
+
+    // Hardware events of those loops, summed over the threads. Rates use
+    // the slowest thread's busy time, i.e. the wall time of the loops.
+    PerfCounters::Values ev{};
+    for (const ThreadSlot &slot : threads_)
+      for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e)
+        ev[e] += slot.events[k][e];
+    if (counters_ && ev[PerfCounters::CYCLES] > 0.0) {
+      auto ratio = [](double a, double b) { return b > 0.0 ? a / b : 0.0; };
+      const double instr = ev[PerfCounters::INSTRUCTIONS];
+      const double bytes = ev[PerfCounters::CACHE_MISSES] * kLineBytes;
+      nlohmann::json c = nlohmann::json::object();
+      for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e)
+        if (PerfCounters::has(static_cast<PerfCounters::Event>(e)))
+          c[PerfCounters::eventName(static_cast<PerfCounters::Event>(e))] =
+              ev[e];
+      c["ipc"] = ratio(instr, ev[PerfCounters::CYCLES]);
+      c["cache_miss_rate"] = ratio(ev[PerfCounters::CACHE_MISSES],
+                                   ev[PerfCounters::CACHE_REFERENCES]);
+      c["llc_mpki"] = 1000.0 * ratio(ev[PerfCounters::CACHE_MISSES], instr);
+      c["l1d_mpki"] =
+          1000.0 * ratio(ev[PerfCounters::L1D_READ_MISSES], instr);
+      c["dram_bytes_est"] = bytes;
+      c["flops"] = flops_[k];
+      c["arithmetic_intensity"] = ratio(flops_[k], bytes);
+      c["gflops"] = ratio(flops_[k], hi) * 1e-9;
+      c["dram_GBps_est"] = ratio(bytes, hi) * 1e-9;
+      roofline.push_back({{"kernel", phaseName(static_cast<Phase>(k))},
+                          {"arithmetic_intensity", c["arithmetic_intensity"]},
+                          {"gflops", c["gflops"]},
+                          {"dram_GBps_est", c["dram_GBps_est"]}});
+      p["counters"] = c;
+    }
+    phases[phaseName(static_cast<Phase>(k))] = p;
+  }
+
+  const double updates =
+      static_cast<double>(cells) * static_cast<double>(steps);
+  auto total = [this](Phase k) {
+    return std::accumulate(samples_[k].begin(), samples_[k].end(),
+                           current_[k]);
+  };
+  const double project = total(PROJECT);
+  const double output = total(OUTPUT) + total(CHECKPOINT);
+  nlohmann::json counters = {{"enabled", counters_}};
+  if (counters_) {
+    nlohmann::json events = nlohmann::json::array();
+    for (int e = 0; e < PerfCounters::NUM_EVENTS; ++e)
+      if (PerfCounters::has(static_cast<PerfCounters::Event>(e)))
+        events.push_back(
+            PerfCounters::eventName(static_cast<PerfCounters::Event>(e)));
+    counters["events"] = events;
+    counters["roofline"] = roofline;
+  } else if (!countersReason_.empty()) {
+    counters["unavailable"] = countersReason_;
+  }
+  return {
+      {"steps", steps},
+      {"cells", cells},
+      {"threads", threads_.size()},
+      {"wall_s", wall},
+      {"step_total_s", stepTotal},
+      {"phases", phases},
+      {"pressure_iterations",
+       {{"total", iterations_},
+        {"per_step", steps > 0 ? static_cast<double>(iterations_) /
+                                     static_cast<double>(steps)
+                               : 0.0}}},
+      {"bytes_written", bytesWritten},
+      {"hardware_counters", counters},
+      {"throughput",
+       {{"cell_updates_per_s", stepTotal > 0.0 ? updates / stepTotal : 0.0},
+        {"pressure_cell_iterations_per_s",
+         project > 0.0 ? static_cast<double>(cells) *
+                             static_cast<double>(iterations_) / project
+                       : 0.0},
+        {"output_GBps",
+         output > 0.0 ? static_cast<double>(bytesWritten) / output * 1e-9
+                      : 0.0}}}};
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include "PerfCounters.hpp"
+#include "Precision.hpp"
+#include <array>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @file Profiler.hpp
+ * @brief Per-phase timers, per-thread busy time and a JSON run report.
+ *
+ * Instrumentation is compiled in when @c PIC_PROFILE is defined (CMake
+ * option @c PIC_ENABLE_PROFILER, ON by default). Without it every
+ * @c PIC_PROFILE_* macro expands to nothing and the hot loops are exactly
+ * the uninstrumented code.
+ */
+
+/**
+ * @brief Collects where the time of a run goes.
+ *
+ * - **Phases**: one sample per phase per time step (a phase entered twice
+ *   in one step adds up), from which totals and percentiles are derived.
+ * - **Threads**: inside instrumented OpenMP regions each thread adds the
+ *   time it spent in its share of the loop (before the closing barrier),
+ *   so max / mean over threads is the load imbalance of that phase.
+ * - **Counters**: pressure iterations and bytes written.
+ * - **Hardware counters** (enableCounters()): cycles, instructions and
+ *   cache misses of each thread over the same instrumented loops, summed
+ *   over the threads, plus the nominal flops the kernels report. From
+ *   them the report derives IPC, miss rates and a roofline point
+ *   (arithmetic intensity against DRAM traffic, GFLOP/s) per kernel.
+ *
+ * One Profiler belongs to one solver; only the thread slots are written
+ * concurrently, each by its own thread.
+ */
+class Profiler {
+public:
+  /// @brief Timed parts of a time step.
+  enum Phase {
+    SOURCES,      ///< Scene sources re-imposed in source mode.
+    PROJECT,      ///< MakeIncompressible(): pressure solve + correction.
+    ADVECT,       ///< Advect(): velocity transport.
+    ADVECT_SMOKE, ///< AdvectSmoke().
+    DIAGNOSTICS,  ///< div, |u|, tiling, statistics, monitors.
+    EXCHANGE,     ///< MPI ghost-layer exchange outside the solvers.
+    AMR,          ///< Refined levels.
+    OUTPUT,       ///< WriteOutput() on the compute thread (incl. stalls).
+    CHECKPOINT,   ///< Checkpoint and statistics files.
+    STEP,         ///< Whole step, for step-time percentiles.
+    NUM_PHASES
+  };
+
+  /// @return Name of @p phase in the report ("project", ...).
+  static const char *phaseName(Phase phase);
+
+  Profiler();
+
+  /// @brief Close the samples of the current step and open the next one.
+  void nextStep();
+
+  /// @brief Add @p seconds to @p phase in the current step.
+  void add(Phase phase, double seconds) { current_[phase] += seconds; }
+
+  /// @brief Add @p seconds of busy time of the calling OpenMP thread.
+  void addThread(Phase phase, double seconds);
+
+  void addIterations(std::int64_t n) { iterations_ += n; }
+
+  /// @brief Add @p n nominal floating-point operations to @p phase.
+  void addFlops(Phase phase, double n) { flops_[phase] += n; }
+
+  /**
+   * @brief Count hardware events in the per-thread scopes from now on.
+   * @return @c false (and the cause in the report) if the counters are
+   *         unavailable; the timings are unaffected either way.
+   */
+  bool enableCounters();
+
+  /// @return Why enableCounters() failed, or empty.
+  [[nodiscard]] const std::string &countersUnavailable() const {
+    return countersReason_;
+  }
+
+  /**
+   * @brief Build the report.
+   * @param cells        Cells updated per step (for cell-updates/s).
+   * @param bytesWritten Bytes written by the output writers.
+   */
+  [[nodiscard]] nlohmann::json report(std::int64_t cells,
+                                      std::uint64_t bytesWritten) const;
+
+  /// @brief Scoped phase timer (see PIC_PROFILE_SCOPE).
+  class Scope {
+  public:
+    Scope(Profiler &p, Phase phase)
+        : p_(p), phase_(phase), start_(GET_TIME()) {}
+    ~Scope() { p_.add(phase_, GET_TIME() - start_); }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    Profiler &p_;
+    Phase phase_;
+    double start_;
+  };
+
+  /// @brief Scoped per-thread timer and counters (see PIC_PROFILE_THREAD).
+  class ThreadScope {
+  public:
+    ThreadScope(Profiler &p, Phase phase)
+        : p_(p), phase_(phase),
+          counting_(p.counters_ && PerfCounters::read(counts_)),
+          start_(GET_TIME()) {}
+    ~ThreadScope() {
+      p_.addThread(phase_, GET_TIME() - start_);
+      if (counting_)
+        p_.addThreadCounters(phase_, counts_);
+    }
+    ThreadScope(const ThreadScope &) = delete;
+    ThreadScope &operator=(const ThreadScope &) = delete;
+
+  private:
+    Profiler &p_;
+    Phase phase_;
+    PerfCounters::Values counts_{}; ///< At entry.
+    bool counting_;
+    double start_;
+  };
+
+private:
+  /// Busy time and event counts of one thread, on its own cache lines.
+  struct alignas(64) ThreadSlot {
+    std::array<double, NUM_PHASES> busy{};
+    std::array<PerfCounters::Values, NUM_PHASES> events{};
+  };
+
+  /// @brief Add the calling thread's counts since @p start to @p phase.
+  void addThreadCounters(Phase phase, const PerfCounters::Values &start);
+
+  std::array<double, NUM_PHASES> current_{}; ///< Open step.
+  std::array<std::vector<double>, NUM_PHASES> samples_; ///< Closed steps.
+  std::vector<ThreadSlot> threads_;
+  std::int64_t iterations_ = 0;
+  std::array<double, NUM_PHASES> flops_{};
+  bool counters_ = false;      ///< Hardware counters enabled and working.
+  std::string countersReason_; ///< Why they are not, if requested.
+  double start_; ///< Construction time, for the wall-clock total.
+};
+
+#ifdef PIC_PROFILE
+/// Time the rest of the enclosing scope as @p phase of @p prof.
+#define PIC_PROFILE_SCOPE(prof, phase)                                         \
+  Profiler::Scope picProfileScope((prof), Profiler::phase)
+/// Time the calling thread's share of an OpenMP region: place it first in
+/// the @c omp @c parallel block, before an @c omp @c for @c nowait.
+#define PIC_PROFILE_THREAD(prof, phase)                                        \
+  Profiler::ThreadScope picProfileThread((prof), Profiler::phase)
+#define PIC_PROFILE_ITERATIONS(prof, n) (prof).addIterations(n)
+/// Add @p n nominal flops of one kernel call to @p phase.
+#define PIC_PROFILE_FLOPS(prof, phase, n) (prof).addFlops(Profiler::phase, (n))
+#else
+#define PIC_PROFILE_SCOPE(prof, phase) ((void)0)
+#define PIC_PROFILE_THREAD(prof, phase) ((void)0)
+#define PIC_PROFILE_ITERATIONS(prof, n) ((void)0)
+#define PIC_PROFILE_FLOPS(prof, phase, n) ((void)0)
+#endif
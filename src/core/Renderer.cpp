@@ -0,0 +1,252 @@
+#include "Renderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+using RGB = std::array<uint8_t, 3>;
+
+/// Control points of each colour map, evenly spaced over [0, 1].
+std::vector<RGB> controlPoints(RenderConfig::Colormap map) {
+  switch (map) {
+  case RenderConfig::Colormap::VIRIDIS:
+    return {{68, 1, 84},    {71, 44, 122},  {59, 81, 139},
+            {44, 113, 142}, {33, 144, 141}, {39, 173, 129},
+            {92, 200, 99},  {170, 220, 50}, {253, 231, 37}};
+  case RenderConfig::Colormap::INFERNO:
+    return {{0, 0, 4},      {31, 12, 72},  {85, 15, 109},
+            {136, 34, 106}, {186, 54, 85}, {227, 89, 51},
+            {249, 140, 10}, {249, 201, 50}, {252, 255, 164}};
+  case RenderConfig::Colormap::COOLWARM:
+    return {{59, 76, 192},
+            {124, 159, 249},
+            {221, 221, 221},
+            {245, 156, 125},
+            {180, 4, 38}};
+  case RenderConfig::Colormap::GRAY:
+    break;
+  }
+  return {{0, 0, 0}, {255, 255, 255}};
+}
+
+constexpr RGB kMaskColour = {96, 96, 96};
+
+#ifdef HAVE_ZLIB
+void putU32BE(std::vector<uint8_t> &out, uint32_t v) {
+  out.push_back(static_cast<uint8_t>(v >> 24));
+  out.push_back(static_cast<uint8_t>(v >> 16));
+  out.push_back(static_cast<uint8_t>(v >> 8));
+  out.push_back(static_cast<uint8_t>(v));
+}
+#endif
+
+} // namespace
+
+Renderer::Renderer(const std::string &output_dir, const RenderConfig &cfg,
+                   int compressionLevel)
+    : output_dir_(output_dir), cfg_(cfg),
+      level_(std::clamp(compressionLevel, 0, 9)) {
+  std::filesystem::create_directories(output_dir_);
+
+  const std::vector<RGB> pts = controlPoints(cfg_.colormap);
+  const double segments = static_cast<double>(pts.size() - 1);
+  for (int k = 0; k < 256; ++k) {
+    const double x = k / 255.0 * segments;
+    const std::size_t s = std::min(static_cast<std::size_t>(x), pts.size() - 2);
+    const double t = x - static_cast<double>(s);
+    for (int c = 0; c < 3; ++c)
+      lut_[k][c] = static_cast<uint8_t>(
+          std::lround((1.0 - t) * pts[s][c] + t * pts[s + 1][c]));
+  }
+}
+
+std::array<double, 2> Renderer::range(const Grid2D &values) const {
+  if (cfg_.max > cfg_.min)
+    return {cfg_.min, cfg_.max};
+
+  double lo = std::numeric_limits<double>::infinity();
+  double hi = -lo;
+#pragma omp parallel for reduction(min : lo) reduction(max : hi)
+  for (std::size_t k = 0; k < values.A.size(); ++k) {
+    const double x = values.A[k];
+    if (std::isfinite(x)) {
+      lo = std::min(lo, x);
+      hi = std::max(hi, x);
+    }
+  }
+  if (!(lo <= hi))
+    return {0.0, 1.0}; // everything masked
+  if (cfg_.colormap == RenderConfig::Colormap::COOLWARM) {
+    const double m = std::max(std::abs(lo), std::abs(hi));
+    return {-m, m};
+  }
+  return {lo, hi};
+}
+
+bool Renderer::write(const Grid2D &values) {
+  const int s = cfg_.scale;
+  const int w = values.nx * s;
+  const int h = values.ny * s;
+  const auto [lo, hi] = range(values);
+  const double inv = hi > lo ? 255.0 / (hi - lo) : 0.0;
+
+  std::vector<uint8_t> rgb(static_cast<std::size_t>(w) * h * 3);
+#pragma omp parallel for schedule(static)
+  for (int j = 0; j < values.ny; ++j) {
+    // Image rows run top-down; the grid's j runs bottom-up.
+    uint8_t *row = rgb.data() +
+                   static_cast<std::size_t>(values.ny - 1 - j) * s * w * 3;
+    for (int i = 0; i < values.nx; ++i) {
+      const double x = values.Get(i, j);
+      const RGB &c =
+          std::isnan(x)
+              ? kMaskColour
+              : lut_[static_cast<int>(std::clamp((x - lo) * inv, 0.0, 255.0))];
+      for (int p = 0; p < s; ++p)
+        std::copy(c.begin(), c.end(),
+                  row + (static_cast<std::size_t>(i) * s + p) * 3);
+    }
+    for (int r = 1; r < s; ++r) // replicate the row for scale > 1
+      std::copy(row, row + w * 3, row + static_cast<std::size_t>(r) * w * 3);
+  }
+
+  std::ostringstream name;
+  name << output_dir_ << '/' << cfg_.name << '_' << std::setw(4)
+       << std::setfill('0') << frame_;
+#ifdef HAVE_ZLIB
+  const bool ok = writePNG(name.str() + ".png", w, h, rgb);
+#else
+  const bool ok = writePPM(name.str() + ".ppm", w, h, rgb);
+#endif
+  if (ok)
+    ++frame_;
+  return ok;
+}
+
+bool Renderer::writePPM(const std::string &path, int w, int h,
+                        const std::vector<uint8_t> &rgb) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out.is_open())
+    return false;
+  out << "P6\n" << w << ' ' << h << "\n255\n";
+  out.write(reinterpret_cast<const char *>(rgb.data()),
+            static_cast<std::streamsize>(rgb.size()));
+  return static_cast<bool>(out);
+}
+
+#ifdef HAVE_ZLIB
+bool Renderer::writePNG(const std::string &path, int w, int h,
+                        const std::vector<uint8_t> &rgb) const {
+  // Filtered scanlines: one filter byte per row. "Sub" (1) stores each byte
+  // minus the one three to its left, which turns flat colour runs into
+  // zeros.
+  const std::size_t stride = static_cast<std::size_t>(w) * 3 + 1;
+  std::vector<uint8_t> raw(stride * h);
+#pragma omp parallel for schedule(static)
+  for (int y = 0; y < h; ++y) {
+    const uint8_t *src = rgb.data() + static_cast<std::size_t>(y) * w * 3;
+    uint8_t *dst = raw.data() + y * stride;
+    dst[0] = 1;
+    for (std::size_t k = 0; k < static_cast<std::size_t>(w) * 3; ++k)
+      dst[1 + k] = static_cast<uint8_t>(src[k] - (k >= 3 ? src[k - 3] : 0));
+  }
+
+  // Deflate bands of rows independently: every band but the last ends with
+  // a sync flush (byte aligned, no final bit), so the raw deflate outputs
+  // concatenate into one stream. The Adler-32 checksums are combined.
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+  const int bands = std::clamp(h / 32, 1, std::max(1, threads));
+  std::vector<std::vector<uint8_t>> out(bands);
+  std::vector<uLong> adler(bands);
+  bool failed = false;
+#pragma omp parallel for schedule(static) reduction(|| : failed)
+  for (int b = 0; b < bands; ++b) {
+    const std::size_t begin = raw.size() * b / bands;
+    const std::size_t end = raw.size() * (b + 1) / bands;
+    z_stream zs{};
+    if (deflateInit2(&zs, level_, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) !=
+        Z_OK) {
+      failed = true;
+      continue;
+    }
+    out[b].resize(deflateBound(&zs, static_cast<uLong>(end - begin)) + 16);
+    zs.next_in = raw.data() + begin;
+    zs.avail_in = static_cast<uInt>(end - begin);
+    zs.next_out = out[b].data();
+    zs.avail_out = static_cast<uInt>(out[b].size());
+    const int rc = deflate(&zs, b + 1 == bands ? Z_FINISH : Z_SYNC_FLUSH);
+    if (rc == Z_STREAM_ERROR || zs.avail_in != 0)
+      failed = true;
+    out[b].resize(zs.total_out);
+    deflateEnd(&zs);
+    adler[b] = adler32(adler32(0L, Z_NULL, 0), raw.data() + begin,
+                       static_cast<uInt>(end - begin));
+  }
+  if (failed)
+    return false;
+
+  std::vector<uint8_t> idat = {0x78, 0x01}; // zlib header, 32K window
+  uLong check = adler[0];
+  for (int b = 0; b < bands; ++b) {
+    idat.insert(idat.end(), out[b].begin(), out[b].end());
+    if (b > 0) {
+      const std::size_t len =
+          raw.size() * (b + 1) / bands - raw.size() * b / bands;
+      check = adler32_combine(check, adler[b], static_cast<z_off_t>(len));
+    }
+  }
+  putU32BE(idat, static_cast<uint32_t>(check));
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return false;
+  auto chunk = [&file](const char *type, const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> head;
+    putU32BE(head, static_cast<uint32_t>(data.size()));
+    head.insert(head.end(), type, type + 4);
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, head.data() + 4, 4);
+    if (!data.empty()) // crc32() with a null buffer resets to 0
+      crc = crc32(crc, data.data(), static_cast<uInt>(data.size()));
+    std::vector<uint8_t> tail;
+    putU32BE(tail, static_cast<uint32_t>(crc));
+    file.write(reinterpret_cast<const char *>(head.data()), 8);
+    file.write(reinterpret_cast<const char *>(data.data()),
+               static_cast<std::streamsize>(data.size()));
+    file.write(reinterpret_cast<const char *>(tail.data()), 4);
+  };
+
+  static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a,
+                                       '\n'};
+  file.write(reinterpret_cast<const char *>(signature), 8);
+  std::vector<uint8_t> ihdr;
+  putU32BE(ihdr, static_cast<uint32_t>(w));
+  putU32BE(ihdr, static_cast<uint32_t>(h));
+  ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0}); // 8-bit RGB, no interlace
+  chunk("IHDR", ihdr);
+  chunk("IDAT", idat);
+  chunk("IEND", {});
+  return static_cast<bool>(file);
+}
+#else
+bool Renderer::writePNG(const std::string &, int, int,
+                        const std::vector<uint8_t> &) const {
+  return false; // PNG needs zlib; write() falls back to PPM
+}
+#endif
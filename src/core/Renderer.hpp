@@ -0,0 +1,74 @@
+#pragma once
+#include "Grid2D.hpp"
+#include "Parameters.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @file Renderer.hpp
+ * @brief In-situ colour-mapped images of a scalar field.
+ */
+
+/**
+ * @brief Turns a cell-centred scalar grid into an RGB image sequence.
+ *
+ * ### Output
+ * ```
+ *   <output_dir>/<name>_0000.png   (8-bit RGB; .ppm (P6) without zlib)
+ * ```
+ * Row 0 of the image is the top of the domain (largest @e j). Each cell
+ * becomes a @c scale × @c scale block of pixels. NaN values are drawn in a
+ * flat grey: the caller uses them for masked (SOLID) cells.
+ *
+ * ### Cost
+ * Colour mapping is a table lookup per pixel, parallel over rows. The PNG
+ * stream is deflated in independent row bands on all threads (each band
+ * ends on a sync-flush boundary, so the bands concatenate into one valid
+ * zlib stream), which keeps a frame well below the cost of a time step.
+ */
+class Renderer {
+public:
+  /**
+   * @param output_dir       Directory of the image files (created if needed).
+   * @param cfg              Field, colour map, range and file prefix.
+   * @param compressionLevel zlib level of the PNG stream, 0 to 9.
+   */
+  Renderer(const std::string &output_dir, const RenderConfig &cfg,
+           int compressionLevel);
+
+  /**
+   * @brief Render @p values and write the next image of the sequence.
+   * @param values Cell-centred scalar; NaN marks masked cells.
+   * @return @c true on success.
+   */
+  bool write(const Grid2D &values);
+
+  [[nodiscard]] const RenderConfig &config() const { return cfg_; }
+
+  /// @return Index of the next image (saved in checkpoints).
+  [[nodiscard]] int frame() const { return frame_; }
+
+  /// @brief Continue the sequence at image @p frame after a restart.
+  void setFrame(int frame) { frame_ = frame; }
+
+private:
+  std::string output_dir_;
+  RenderConfig cfg_;
+  int level_;
+  int frame_ = 0;
+  std::array<std::array<uint8_t, 3>, 256> lut_; ///< Colour map table.
+
+  /// @brief Colour range of @p values: the configured one, or min / max of
+  ///        the finite values (symmetric about 0 for COOLWARM).
+  [[nodiscard]] std::array<double, 2> range(const Grid2D &values) const;
+
+  /// @brief Write @p rgb (w × h × 3 bytes, top row first) as a PNG.
+  bool writePNG(const std::string &path, int w, int h,
+                const std::vector<uint8_t> &rgb) const;
+
+  /// @brief Write @p rgb as a binary PPM (P6).
+  static bool writePPM(const std::string &path, int w, int h,
+                       const std::vector<uint8_t> &rgb);
+};
@@ -0,0 +1,51 @@
+#include "RunningStatistics.hpp"
+#include <cmath>
+#include <limits>
+
+RunningStatistics::RunningStatistics(int nx, int ny,
+                                     std::vector<std::string> fields)
+    : nx_(nx), ny_(ny), fields_(std::move(fields)) {
+  const std::size_t n = cells();
+  acc_.resize(fields_.size());
+  for (std::vector<double> &a : acc_) {
+    a.assign(4 * n, 0.0);
+    std::fill(a.begin() + 2 * n, a.begin() + 3 * n,
+              std::numeric_limits<double>::infinity());
+    std::fill(a.begin() + 3 * n, a.end(),
+              -std::numeric_limits<double>::infinity());
+  }
+}
+
+std::vector<OutputWriter::NamedGrid>
+RunningStatistics::arrays(std::deque<Grid2D> &storage) const {
+  static const char *suffix[] = {"_mean", "_rms", "_min", "_max"};
+  const std::size_t n = cells();
+  const double inv = samples_ > 0 ? 1.0 / static_cast<double>(samples_) : 0.0;
+
+  std::vector<OutputWriter::NamedGrid> out;
+  for (std::size_t k = 0; k < fields_.size(); ++k) {
+    for (int s = 0; s < 4; ++s) {
+      Grid2D &g = storage.emplace_back(nx_, ny_);
+      const double *src = acc_[k].data() + s * n;
+#pragma omp parallel for schedule(static)
+      for (long long c = 0; c < static_cast<long long>(n); ++c) {
+        const double x = s == 1 ? std::sqrt(src[c] * inv) : src[c];
+        g.A[c] = static_cast<varType>(samples_ > 0 ? x : 0.0);
+      }
+      out.push_back({fields_[k] + suffix[s], &g});
+    }
+  }
+  return out;
+}
+
+bool RunningStatistics::restore(std::int64_t samples,
+                                const std::vector<std::vector<double>> &acc) {
+  if (acc.size() != acc_.size())
+    return false;
+  for (const std::vector<double> &a : acc)
+    if (a.size() != 4 * cells())
+      return false;
+  acc_ = acc;
+  samples_ = samples;
+  return true;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include "Grid2D.hpp"
+#include "OutputWriter.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+/**
+ * @file RunningStatistics.hpp
+ * @brief Per-cell running mean, RMS and extrema of solver fields.
+ */
+
+/**
+ * @brief Accumulates, for every cell of an nx × ny grid and every selected
+ *        field, the running mean, the RMS of the fluctuation and the
+ *        minimum / maximum over all samples taken so far.
+ *
+ * Mean and variance use Welford's update, which stays accurate over
+ * millions of samples where a sum of squares would cancel:
+ * \f[
+ *   \delta = x - \bar{x}_{n-1},\quad
+ *   \bar{x}_n = \bar{x}_{n-1} + \delta / n,\quad
+ *   M_{2,n} = M_{2,n-1} + \delta\,(x - \bar{x}_n)
+ * \f]
+ * and the RMS of the fluctuation is \f$ \sqrt{M_{2,n} / n} \f$. Every cell
+ * is sampled at every update, so the sample count @e n is shared.
+ *
+ * Accumulators are kept in double precision whatever @c varType is. Each
+ * field owns one vector of 4 × nx × ny values — mean, M2, min, max — which
+ * is also the layout stored in checkpoints (see data()).
+ */
+class RunningStatistics {
+public:
+  /**
+   * @param nx     Cells in x.
+   * @param ny     Cells in y.
+   * @param fields Names of the accumulated fields; @c update() samples them
+   *               by index in this order.
+   */
+  RunningStatistics(int nx, int ny, std::vector<std::string> fields);
+
+  /**
+   * @brief Add one sample of every field in every cell.
+   *
+   * @p sample(k, i, j) returns the value of field @e k at cell (i, j); it
+   * is inlined into a single parallel sweep that updates all fields of a
+   * row before moving on.
+   */
+  template <class Sample> void update(const Sample &sample) {
+    beginSample();
+#pragma omp parallel for schedule(static)
+    for (int j = 0; j < ny_; ++j)
+      accumulate(0, nx_, j, j + 1, sample);
+  }
+
+  /**
+   * @brief Start a sample that the caller fills piecewise with
+   *        accumulate(), e.g. from inside a sweep that already visits
+   *        every cell. The pieces must cover each cell exactly once.
+   */
+  void beginSample() { ++samples_; }
+
+  /**
+   * @brief Fold cells [i0, i1) × [j0, j1) of the sample begun by
+   *        beginSample() into the accumulators (serial; disjoint ranges
+   *        may be accumulated concurrently).
+   */
+  template <class Sample>
+  void accumulate(int i0, int i1, int j0, int j1, const Sample &sample) {
+    const double inv = 1.0 / static_cast<double>(samples_);
+    const std::size_t n = cells();
+    for (int j = j0; j < j1; ++j) {
+      for (std::size_t k = 0; k < acc_.size(); ++k) {
+        double *mean = acc_[k].data();
+        double *m2 = mean + n;
+        double *lo = m2 + n;
+        double *hi = lo + n;
+        for (int i = i0; i < i1; ++i) {
+          const std::size_t c = static_cast<std::size_t>(j) * nx_ + i;
+          const double x = static_cast<double>(sample(k, i, j));
+          const double delta = x - mean[c];
+          mean[c] += delta * inv;
+          m2[c] += delta * (x - mean[c]);
+          lo[c] = std::min(lo[c], x);
+          hi[c] = std::max(hi[c], x);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Current statistics as cell arrays for OutputWriter::writeGrids():
+   *        @c \<field\>_mean, @c _rms, @c _min and @c _max per field.
+   * @param storage Receives the grids the returned arrays point to.
+   */
+  [[nodiscard]] std::vector<OutputWriter::NamedGrid>
+  arrays(std::deque<Grid2D> &storage) const;
+
+  [[nodiscard]] const std::vector<std::string> &fields() const {
+    return fields_;
+  }
+
+  /// @return Number of samples taken so far.
+  [[nodiscard]] std::int64_t samples() const { return samples_; }
+
+  /// @brief Raw accumulators of field @p k (mean, M2, min, max; each
+  ///        nx × ny), for checkpoints.
+  [[nodiscard]] const std::vector<double> &data(std::size_t k) const {
+    return acc_[k];
+  }
+
+  /**
+   * @brief Resume from accumulators saved with data() and samples().
+   * @return @c false (and no change) if a size does not match.
+   */
+  bool restore(std::int64_t samples,
+               const std::vector<std::vector<double>> &acc);
+
+private:
+  int nx_, ny_;
+  std::vector<std::string> fields_;
+  std::vector<std::vector<double>> acc_; ///< Per field: mean | M2 | min | max.
+  std::int64_t samples_ = 0;
+
+  [[nodiscard]] std::size_t cells() const {
+    return static_cast<std::size_t>(nx_) * ny_;
+  }
+};
@@ -1,7 +1,10 @@
 #include "SceneObjects.hpp"
+#include "MappedFile.hpp"
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 
 // Expression resolver
@@ -80,52 +83,414 @@ int resolveInt(const nlohmann::json &val,
 
 // RectangleObject
 
-void RectangleObject::applySolid(Fields2D &f) const {
-  const int iMax = std::min(x2, f.nx - 1);
-  const int jMax = std::min(y2, f.ny - 1);
-  for (int j = std::max(y1, 0); j <= jMax; ++j)
-    for (int i = std::max(x1, 0); i <= iMax; ++i)
+void RectangleObject::applySolidRows(Fields2D &f, int j0, int j1) const {
+  const int iMax = std::min(x2 - f.originI, f.nx - 1);
+  const int jMax = std::min({y2 - f.originJ, f.ny - 1, j1 - 1});
+  for (int j = std::max({y1 - f.originJ, 0, j0}); j <= jMax; ++j)
+    for (int i = std::max(x1 - f.originI, 0); i <= iMax; ++i)
       f.SetLabel(i, j, Fields2D::SOLID);
 }
 
+bool RectangleObject::rowRange(int &j0, int &j1) const {
+  j0 = y1;
+  j1 = y2 + 1;
+  return true;
+}
+
 void RectangleObject::applyVelocityU(Fields2D &f) const {
-  const int iMax = std::min(x2, f.u.nx - 1);
-  const int jMax = std::min(y2, f.u.ny - 1);
-  for (int j = std::max(y1, 0); j <= jMax; ++j)
-    for (int i = std::max(x1, 0); i <= iMax; ++i)
+  const int iMax = std::min(x2 - f.originI, f.u.nx - 1);
+  const int jMax = std::min(y2 - f.originJ, f.u.ny - 1);
+  for (int j = std::max(y1 - f.originJ, 0); j <= jMax; ++j)
+    for (int i = std::max(x1 - f.originI, 0); i <= iMax; ++i)
       f.u.Set(i, j, val);
 }
 
 void RectangleObject::applyVelocityV(Fields2D &f) const {
-  const int iMax = std::min(x2, f.v.nx - 1);
-  const int jMax = std::min(y2, f.v.ny - 1);
-  for (int j = std::max(y1, 0); j <= jMax; ++j)
-    for (int i = std::max(x1, 0); i <= iMax; ++i)
+  const int iMax = std::min(x2 - f.originI, f.v.nx - 1);
+  const int jMax = std::min(y2 - f.originJ, f.v.ny - 1);
+  for (int j = std::max(y1 - f.originJ, 0); j <= jMax; ++j)
+    for (int i = std::max(x1 - f.originI, 0); i <= iMax; ++i)
       f.v.Set(i, j, val);
 }
 
 void RectangleObject::applySmoke(Fields2D &f) const {
-  const int iMax = std::min(x2, f.smokeMap.nx - 1);
-  const int jMax = std::min(y2, f.smokeMap.ny - 1);
-  for (int j = std::max(y1, 0); j <= jMax; ++j)
-    for (int i = std::max(x1, 0); i <= iMax; ++i)
+  const int iMax = std::min(x2 - f.originI, f.smokeMap.nx - 1);
+  const int jMax = std::min(y2 - f.originJ, f.smokeMap.ny - 1);
+  for (int j = std::max(y1 - f.originJ, 0); j <= jMax; ++j)
+    for (int i = std::max(x1 - f.originI, 0); i <= iMax; ++i)
+      f.smokeMap.Set(i, j, val);
+}
+
+// ShapeObject
+
+void ShapeObject::spans(int j, int i0, int i1,
+                        std::vector<std::pair<int, int>> &out) const {
+  int start = -1;
+  for (int i = i0; i <= i1; ++i) {
+    const bool in = contains(i, j);
+    if (in && start < 0)
+      start = i;
+    else if (!in && start >= 0) {
+      out.emplace_back(start, i - 1);
+      start = -1;
+    }
+  }
+  if (start >= 0)
+    out.emplace_back(start, i1);
+}
+
+template <typename Set>
+void ShapeObject::raster(const Fields2D &f, int nx, int j0, int j1,
+                         Set set) const {
+  int bi0, bj0, bi1, bj1;
+  bounds(bi0, bj0, bi1, bj1);
+  // Bounding box in local indices, clipped to the grid and the rows.
+  const int iLo = std::max(bi0 - f.originI, 0);
+  const int iHi = std::min(bi1 - f.originI, nx - 1);
+  const int jLo = std::max(bj0 - f.originJ, j0);
+  const int jHi = std::min(bj1 - f.originJ, j1 - 1);
+  std::vector<std::pair<int, int>> runs;
+  for (int j = jLo; j <= jHi && iLo <= iHi; ++j) {
+    runs.clear();
+    spans(j + f.originJ, iLo + f.originI, iHi + f.originI, runs);
+    for (const auto &[a, b] : runs)
+      set(std::max(a - f.originI, iLo), std::min(b - f.originI, iHi), j);
+  }
+}
+
+void ShapeObject::applySolidRows(Fields2D &f, int j0, int j1) const {
+  raster(f, f.nx, j0, j1, [&](int a, int b, int j) {
+    for (int i = a; i <= b; ++i)
+      f.SetLabel(i, j, Fields2D::SOLID);
+  });
+}
+
+bool ShapeObject::rowRange(int &j0, int &j1) const {
+  int i0, i1;
+  bounds(i0, j0, i1, j1);
+  ++j1;
+  return true;
+}
+
+void ShapeObject::applyVelocityU(Fields2D &f) const {
+  raster(f, f.u.nx, 0, f.u.ny, [&](int a, int b, int j) {
+    for (int i = a; i <= b; ++i)
+      f.u.Set(i, j, val);
+  });
+}
+
+void ShapeObject::applyVelocityV(Fields2D &f) const {
+  raster(f, f.v.nx, 0, f.v.ny, [&](int a, int b, int j) {
+    for (int i = a; i <= b; ++i)
+      f.v.Set(i, j, val);
+  });
+}
+
+void ShapeObject::applySmoke(Fields2D &f) const {
+  raster(f, f.smokeMap.nx, 0, f.smokeMap.ny, [&](int a, int b, int j) {
+    for (int i = a; i <= b; ++i)
       f.smokeMap.Set(i, j, val);
+  });
 }
 
 // CylinderObject
 
-void CylinderObject::applySolid(Fields2D &f) const {
-  const int r2 = r * r;
-  for (int j = 0; j < f.ny; ++j) {
-    const int ddy = j - cy;
-    for (int i = 0; i < f.nx; ++i) {
-      const int ddx = i - cx;
-      if (ddx * ddx + ddy * ddy <= r2)
+void CylinderObject::bounds(int &i0, int &j0, int &i1, int &j1) const {
+  i0 = cx - r;
+  j0 = cy - r;
+  i1 = cx + r;
+  j1 = cy + r;
+}
+
+bool CylinderObject::contains(double x, double y) const {
+  return (x - cx) * (x - cx) + (y - cy) * (y - cy) <=
+         static_cast<double>(r) * r;
+}
+
+void CylinderObject::spans(int j, int i0, int i1,
+                           std::vector<std::pair<int, int>> &out) const {
+  // Largest w with w² <= r² - dy², in integers.
+  const long long rem = static_cast<long long>(r) * r -
+                        static_cast<long long>(j - cy) * (j - cy);
+  if (rem < 0)
+    return;
+  long long w = static_cast<long long>(std::sqrt(static_cast<double>(rem)));
+  while (w * w > rem)
+    --w;
+  while ((w + 1) * (w + 1) <= rem)
+    ++w;
+  const int a = std::max<long long>(cx - w, i0);
+  const int b = std::min<long long>(cx + w, i1);
+  if (a <= b)
+    out.emplace_back(a, b);
+}
+
+// EllipseObject
+
+void EllipseObject::bounds(int &i0, int &j0, int &i1, int &j1) const {
+  const double c = std::cos(angle), s = std::sin(angle);
+  const double hx = std::sqrt(rx * rx * c * c + ry * ry * s * s);
+  const double hy = std::sqrt(rx * rx * s * s + ry * ry * c * c);
+  i0 = static_cast<int>(std::floor(cx - hx));
+  i1 = static_cast<int>(std::ceil(cx + hx));
+  j0 = static_cast<int>(std::floor(cy - hy));
+  j1 = static_cast<int>(std::ceil(cy + hy));
+}
+
+bool EllipseObject::contains(double x, double y) const {
+  const double c = std::cos(angle), s = std::sin(angle);
+  const double u = ((x - cx) * c + (y - cy) * s) / rx;
+  const double v = (-(x - cx) * s + (y - cy) * c) / ry;
+  return u * u + v * v <= 1.0;
+}
+
+void EllipseObject::spans(int j, int i0, int i1,
+                          std::vector<std::pair<int, int>> &out) const {
+  // (u/rx)² + (v/ry)² <= 1 is a quadratic A·dx² + B·dx + C <= 0 in
+  // dx = x - cx for the fixed dy of the row.
+  const double c = std::cos(angle), s = std::sin(angle);
+  const double dy = j - cy;
+  const double a = c * c / (rx * rx) + s * s / (ry * ry);
+  const double b = 2.0 * dy * c * s * (1.0 / (rx * rx) - 1.0 / (ry * ry));
+  const double cc = dy * dy * (s * s / (rx * rx) + c * c / (ry * ry)) - 1.0;
+  const double disc = b * b - 4.0 * a * cc;
+  if (disc < 0.0)
+    return;
+  const double root = std::sqrt(disc);
+  const int lo = std::max(
+      static_cast<int>(std::ceil(cx + (-b - root) / (2.0 * a))), i0);
+  const int hi = std::min(
+      static_cast<int>(std::floor(cx + (-b + root) / (2.0 * a))), i1);
+  if (lo <= hi)
+    out.emplace_back(lo, hi);
+}
+
+// PolygonObject
+
+void PolygonObject::bounds(int &i0, int &j0, int &i1, int &j1) const {
+  double xMin = points.front().first, xMax = xMin;
+  double yMin = points.front().second, yMax = yMin;
+  for (const auto &[x, y] : points) {
+    xMin = std::min(xMin, x);
+    xMax = std::max(xMax, x);
+    yMin = std::min(yMin, y);
+    yMax = std::max(yMax, y);
+  }
+  i0 = static_cast<int>(std::floor(xMin));
+  i1 = static_cast<int>(std::ceil(xMax));
+  j0 = static_cast<int>(std::floor(yMin));
+  j1 = static_cast<int>(std::ceil(yMax));
+}
+
+bool PolygonObject::contains(double x, double y) const {
+  // Even-odd rule with the same half-open edges as spans().
+  bool inside = false;
+  const std::size_t n = points.size();
+  for (std::size_t k = 0, l = n - 1; k < n; l = k++) {
+    const auto &[xk, yk] = points[k];
+    const auto &[xl, yl] = points[l];
+    if ((yk <= y) != (yl <= y) &&
+        x < xk + (y - yk) * (xl - xk) / (yl - yk))
+      inside = !inside;
+  }
+  return inside;
+}
+
+void PolygonObject::spans(int j, int i0, int i1,
+                          std::vector<std::pair<int, int>> &out) const {
+  // Scanline: crossings of the row with every edge, filled pairwise.
+  std::vector<double> xs;
+  const double y = j;
+  const std::size_t n = points.size();
+  for (std::size_t k = 0, l = n - 1; k < n; l = k++) {
+    const auto &[xk, yk] = points[k];
+    const auto &[xl, yl] = points[l];
+    if ((yk <= y) != (yl <= y))
+      xs.push_back(xk + (y - yk) * (xl - xk) / (yl - yk));
+  }
+  std::sort(xs.begin(), xs.end());
+  for (std::size_t k = 0; k + 1 < xs.size(); k += 2) {
+    // Columns i with xs[k] <= i < xs[k + 1].
+    const int a = std::max(static_cast<int>(std::ceil(xs[k])), i0);
+    const int b = std::min(static_cast<int>(std::ceil(xs[k + 1])) - 1, i1);
+    if (a <= b)
+      out.emplace_back(a, b);
+  }
+}
+
+// SdfObject
+
+double SdfObject::Term::distance(double x, double y) const {
+  switch (kind) {
+  case CIRCLE:
+    return std::hypot(x - x1, y - y1) - r;
+  case BOX: {
+    const double qx = std::abs(x - x1) - x2, qy = std::abs(y - y1) - y2;
+    return std::hypot(std::max(qx, 0.0), std::max(qy, 0.0)) +
+           std::min(std::max(qx, qy), 0.0);
+  }
+  case SEGMENT: {
+    const double px = x - x1, py = y - y1;
+    const double ex = x2 - x1, ey = y2 - y1;
+    const double len2 = ex * ex + ey * ey;
+    const double t =
+        len2 > 0.0 ? std::clamp((px * ex + py * ey) / len2, 0.0, 1.0) : 0.0;
+    return std::hypot(px - t * ex, py - t * ey) - r;
+  }
+  }
+  return 0.0;
+}
+
+double SdfObject::distance(double x, double y) const {
+  double d = terms.front().distance(x, y);
+  for (std::size_t t = 1; t < terms.size(); ++t) {
+    const double e = terms[t].distance(x, y);
+    switch (op) {
+    case UNION:
+      d = std::min(d, e);
+      break;
+    case INTERSECTION:
+      d = std::max(d, e);
+      break;
+    case SUBTRACTION:
+      d = std::max(d, -e);
+      break;
+    case SMOOTH_UNION: {
+      // Polynomial smooth minimum.
+      const double h = std::clamp(0.5 + 0.5 * (e - d) / k, 0.0, 1.0);
+      d = e + (d - e) * h - k * h * (1.0 - h);
+      break;
+    }
+    }
+  }
+  return d - round;
+}
+
+void SdfObject::bounds(int &i0, int &j0, int &i1, int &j1) const {
+  // Union of the term boxes (only the first term for a subtraction),
+  // grown by the rounding and the blend radius.
+  double xMin = 0, xMax = 0, yMin = 0, yMax = 0;
+  const std::size_t n = op == SUBTRACTION ? 1 : terms.size();
+  for (std::size_t t = 0; t < n; ++t) {
+    const Term &term = terms[t];
+    double a0, a1, b0, b1;
+    switch (term.kind) {
+    case Term::BOX:
+      a0 = term.x1 - term.x2, a1 = term.x1 + term.x2;
+      b0 = term.y1 - term.y2, b1 = term.y1 + term.y2;
+      break;
+    case Term::SEGMENT:
+      a0 = std::min(term.x1, term.x2) - term.r;
+      a1 = std::max(term.x1, term.x2) + term.r;
+      b0 = std::min(term.y1, term.y2) - term.r;
+      b1 = std::max(term.y1, term.y2) + term.r;
+      break;
+    default:
+      a0 = term.x1 - term.r, a1 = term.x1 + term.r;
+      b0 = term.y1 - term.r, b1 = term.y1 + term.r;
+      break;
+    }
+    xMin = t == 0 ? a0 : std::min(xMin, a0);
+    xMax = t == 0 ? a1 : std::max(xMax, a1);
+    yMin = t == 0 ? b0 : std::min(yMin, b0);
+    yMax = t == 0 ? b1 : std::max(yMax, b1);
+  }
+  const double grow = std::max(round, 0.0) + (op == SMOOTH_UNION ? k : 0.0);
+  i0 = static_cast<int>(std::floor(xMin - grow));
+  i1 = static_cast<int>(std::ceil(xMax + grow));
+  j0 = static_cast<int>(std::floor(yMin - grow));
+  j1 = static_cast<int>(std::ceil(yMax + grow));
+}
+
+bool SdfObject::contains(double x, double y) const {
+  return distance(x, y) <= 0.0;
+}
+
+// MaskObject
+
+void MaskObject::applySolidRows(Fields2D &f, int j0, int j1) const {
+  const unsigned char *pixels = file->data() + offset;
+  const int iBegin = std::max(x0 - f.originI, 0);
+  const int iEnd = std::min(x0 + w - f.originI, f.nx);
+  const int jEnd = std::min({y0 + h - f.originJ, f.ny, j1});
+  for (int j = std::max({y0 - f.originJ, 0, j0}); j < jEnd; ++j) {
+    // Nearest pixel row; image row 0 is the top of the mask.
+    const long long py =
+        ph - 1 - static_cast<long long>(j + f.originJ - y0) * ph / h;
+    const unsigned char *row = pixels + py * rowBytes;
+    for (int i = iBegin; i < iEnd; ++i) {
+      const long long px = static_cast<long long>(i + f.originI - x0) * pw / w;
+      bool set;
+      switch (format) {
+      case GREY16:
+        set = (row[2 * px] << 8 | row[2 * px + 1]) >= threshold;
+        break;
+      case BITS:
+        set = row[px >> 3] >> (7 - (px & 7)) & 1;
+        break;
+      default:
+        set = row[px] >= threshold;
+        break;
+      }
+      if (set != invert)
         f.SetLabel(i, j, Fields2D::SOLID);
     }
   }
 }
 
+bool MaskObject::rowRange(int &j0, int &j1) const {
+  j0 = y0;
+  j1 = y0 + h;
+  return true;
+}
+
+// TaylorGreenObject
+
+namespace {
+const double kPi = std::acos(-1.0);
+} // namespace
+
+double TaylorGreenObject::wavenumber(double length) const {
+  return modes * kPi / length;
+}
+
+double TaylorGreenObject::u(double x, double y, double dx, double dy) const {
+  const double kx = wavenumber(gnx * dx), ky = wavenumber(gny * dy);
+  return u0 * std::sin(kx * x) * std::cos(ky * y);
+}
+
+double TaylorGreenObject::v(double x, double y, double dx, double dy) const {
+  const double kx = wavenumber(gnx * dx), ky = wavenumber(gny * dy);
+  return -u0 * (kx / ky) * std::cos(kx * x) * std::sin(ky * y);
+}
+
+double TaylorGreenObject::p(double x, double y, double dx, double dy,
+                            double density) const {
+  const double kx = wavenumber(gnx * dx), ky = wavenumber(gny * dy);
+  const double r = kx / ky;
+  return 0.25 * density * u0 * u0 *
+         (std::cos(2.0 * kx * x) + r * r * std::cos(2.0 * ky * y));
+}
+
+void TaylorGreenObject::applyVelocityU(Fields2D &f) const {
+  // u-face (i, j) sits at (i·dx, (j+0.5)·dy) in global coordinates.
+  for (int j = 0; j < f.u.ny; ++j)
+    for (int i = 0; i < f.u.nx; ++i)
+      f.u.Set(i, j,
+              static_cast<varType>(u((i + f.originI) * f.dx,
+                                     (j + f.originJ + 0.5) * f.dy, f.dx,
+                                     f.dy)));
+}
+
+void TaylorGreenObject::applyVelocityV(Fields2D &f) const {
+  // v-face (i, j) sits at ((i+0.5)·dx, j·dy).
+  for (int j = 0; j < f.v.ny; ++j)
+    for (int i = 0; i < f.v.nx; ++i)
+      f.v.Set(i, j,
+              static_cast<varType>(v((i + f.originI + 0.5) * f.dx,
+                                     (j + f.originJ) * f.dy, f.dx, f.dy)));
+}
+
 // Parsers
 
 static std::unique_ptr<RectangleObject>
@@ -146,6 +511,229 @@ parseCylinder(const nlohmann::json &j, const std::map<std::string, int> &vars) {
   if (j.contains("x")) obj->cx = resolveInt(j["x"], vars);
   if (j.contains("y")) obj->cy = resolveInt(j["y"], vars);
   if (j.contains("r")) obj->r  = resolveInt(j["r"], vars);
+  if (j.contains("val")) obj->val = j["val"].get<double>();
+  return obj;
+}
+
+/// A real number, or an integer expression (see resolveInt()).
+static double resolveReal(const nlohmann::json &val,
+                          const std::map<std::string, int> &vars) {
+  if (val.is_number())
+    return val.get<double>();
+  return resolveInt(val, vars);
+}
+
+static std::unique_ptr<EllipseObject>
+parseEllipse(const nlohmann::json &j, const std::map<std::string, int> &vars) {
+  auto obj = std::make_unique<EllipseObject>();
+  if (j.contains("x"))     obj->cx    = resolveReal(j["x"], vars);
+  if (j.contains("y"))     obj->cy    = resolveReal(j["y"], vars);
+  if (j.contains("rx"))    obj->rx    = resolveReal(j["rx"], vars);
+  if (j.contains("ry"))    obj->ry    = resolveReal(j["ry"], vars);
+  if (j.contains("angle")) obj->angle = j["angle"].get<double>() *
+                                        std::acos(-1.0) / 180.0;
+  if (j.contains("val"))   obj->val   = j["val"].get<double>();
+  if (obj->rx <= 0.0 || obj->ry <= 0.0) {
+    std::cerr << "[SceneObjects] Ellipse semi-axes must be positive – "
+                 "ignored.\n";
+    return nullptr;
+  }
+  return obj;
+}
+
+static std::unique_ptr<PolygonObject>
+parsePolygon(const nlohmann::json &j, const std::map<std::string, int> &vars) {
+  auto obj = std::make_unique<PolygonObject>();
+  if (j.contains("points"))
+    for (const auto &pt : j["points"])
+      obj->points.emplace_back(resolveReal(pt.at(0), vars),
+                               resolveReal(pt.at(1), vars));
+  if (j.contains("val")) obj->val = j["val"].get<double>();
+  if (obj->points.size() < 3) {
+    std::cerr << "[SceneObjects] Polygon needs at least 3 points – "
+                 "ignored.\n";
+    return nullptr;
+  }
+  return obj;
+}
+
+static std::unique_ptr<SdfObject>
+parseSdf(const nlohmann::json &j, const std::map<std::string, int> &vars) {
+  auto obj = std::make_unique<SdfObject>();
+  auto real = [&](const nlohmann::json &t, const char *key) {
+    return t.contains(key) ? resolveReal(t[key], vars) : 0.0;
+  };
+  if (j.contains("terms"))
+    for (const auto &entry : j["terms"])
+      for (auto it = entry.begin(); it != entry.end(); ++it) {
+        const nlohmann::json &t = it.value();
+        SdfObject::Term term;
+        if (it.key() == "circle") {
+          term.kind = SdfObject::Term::CIRCLE;
+          term.x1 = real(t, "x"), term.y1 = real(t, "y");
+          term.r = real(t, "r");
+        } else if (it.key() == "box") {
+          term.kind = SdfObject::Term::BOX;
+          term.x1 = real(t, "x"), term.y1 = real(t, "y");
+          term.x2 = real(t, "hx"), term.y2 = real(t, "hy");
+        } else if (it.key() == "segment") {
+          term.kind = SdfObject::Term::SEGMENT;
+          term.x1 = real(t, "x1"), term.y1 = real(t, "y1");
+          term.x2 = real(t, "x2"), term.y2 = real(t, "y2");
+          term.r = real(t, "r");
+        } else {
+          std::cerr << "[SceneObjects] Unknown SDF term: '" << it.key()
+                    << "' – ignored.\n";
+          continue;
+        }
+        obj->terms.push_back(term);
+      }
+  if (j.contains("op")) {
+    const std::string op = j["op"].get<std::string>();
+    if (op == "union")
+      obj->op = SdfObject::UNION;
+    else if (op == "intersection")
+      obj->op = SdfObject::INTERSECTION;
+    else if (op == "subtraction")
+      obj->op = SdfObject::SUBTRACTION;
+    else if (op == "smooth_union")
+      obj->op = SdfObject::SMOOTH_UNION;
+    else
+      std::cerr << "[SceneObjects] Unknown SDF op '" << op
+                << "' – defaulting to union.\n";
+  }
+  obj->k = real(j, "k");
+  obj->round = real(j, "round");
+  if (j.contains("val")) obj->val = j["val"].get<double>();
+  if (obj->op == SdfObject::SMOOTH_UNION && obj->k <= 0.0)
+    obj->op = SdfObject::UNION; // k = 0 is the plain union
+  if (obj->terms.empty()) {
+    std::cerr << "[SceneObjects] SDF without terms – ignored.\n";
+    return nullptr;
+  }
+  return obj;
+}
+
+namespace {
+
+/// Cursor over the ASCII header of a binary PGM / PBM file.
+struct NetpbmHeader {
+  const unsigned char *data;
+  std::size_t size, pos;
+
+  /// Skip whitespace and '#' comments.
+  void skip() {
+    while (pos < size) {
+      if (data[pos] == '#')
+        while (pos < size && data[pos] != '\n')
+          ++pos;
+      else if (std::isspace(data[pos]))
+        ++pos;
+      else
+        break;
+    }
+  }
+
+  /// @return The next decimal field, or -1 if there is none.
+  long long number() {
+    skip();
+    if (pos >= size || !std::isdigit(data[pos]))
+      return -1;
+    long long n = 0;
+    while (pos < size && std::isdigit(data[pos]) && n < (1LL << 40))
+      n = 10 * n + (data[pos++] - '0');
+    return n;
+  }
+};
+
+} // namespace
+
+static std::unique_ptr<MaskObject>
+parseMask(const nlohmann::json &j, const std::map<std::string, int> &vars) {
+  if (!j.contains("file")) {
+    std::cerr << "[SceneObjects] Mask without \"file\" – ignored.\n";
+    return nullptr;
+  }
+  const std::string path = j["file"].get<std::string>();
+  auto obj = std::make_unique<MaskObject>();
+  obj->file = std::make_shared<const MappedFile>(path);
+  const unsigned char *data = obj->file->data();
+  const std::size_t size = obj->file->size();
+  auto fail = [&](const std::string &why) {
+    return std::runtime_error("[SceneObjects] Mask '" + path + "': " + why);
+  };
+
+  // Header. Only the binary Netpbm variants can be read in place.
+  long long width, height, maxval = 255;
+  if (size >= 2 && data[0] == 'P' && (data[1] == '5' || data[1] == '4')) {
+    NetpbmHeader hdr{data, size, 2};
+    width = hdr.number();
+    height = hdr.number();
+    if (data[1] == '5')
+      maxval = hdr.number();
+    if (width <= 0 || height <= 0 || maxval <= 0 || maxval > 65535 ||
+        hdr.pos >= size || !std::isspace(data[hdr.pos]))
+      throw fail("malformed header");
+    obj->offset = hdr.pos + 1; // one whitespace byte before the pixels
+    obj->format = data[1] == '4'   ? MaskObject::BITS
+                  : maxval > 255 ? MaskObject::GREY16
+                                 : MaskObject::GREY8;
+  } else if (size >= 2 && data[0] == 'P' && data[1] >= '1' && data[1] <= '6') {
+    throw fail("only binary PGM (P5) and PBM (P4) are supported");
+  } else {
+    if (!j.contains("width") || !j.contains("height"))
+      throw fail("a raw mask needs \"width\" and \"height\"");
+    width = resolveInt(j["width"], vars);
+    height = resolveInt(j["height"], vars);
+    if (width <= 0 || height <= 0)
+      throw fail("\"width\" and \"height\" must be positive");
+    obj->format = MaskObject::GREY8;
+    maxval = 1; // default threshold 1: any non-zero byte is set
+  }
+  if (width > std::numeric_limits<int>::max() ||
+      height > std::numeric_limits<int>::max())
+    throw fail("image too large");
+  obj->pw = static_cast<int>(width);
+  obj->ph = static_cast<int>(height);
+  switch (obj->format) {
+  case MaskObject::BITS:
+    obj->rowBytes = (static_cast<std::size_t>(width) + 7) / 8;
+    break;
+  case MaskObject::GREY16:
+    obj->rowBytes = 2 * static_cast<std::size_t>(width);
+    break;
+  default:
+    obj->rowBytes = static_cast<std::size_t>(width);
+    break;
+  }
+  if (obj->offset > size ||
+      (size - obj->offset) / obj->rowBytes < static_cast<std::size_t>(height))
+    throw fail("file shorter than its " + std::to_string(width) + "x" +
+               std::to_string(height) + " pixels");
+
+  obj->threshold = static_cast<int>((maxval + 1) / 2);
+  if (j.contains("threshold")) obj->threshold = resolveInt(j["threshold"], vars);
+  if (j.contains("invert"))    obj->invert    = j["invert"].get<bool>();
+  if (j.contains("x"))         obj->x0        = resolveInt(j["x"], vars);
+  if (j.contains("y"))         obj->y0        = resolveInt(j["y"], vars);
+  obj->w = j.contains("w") ? resolveInt(j["w"], vars) : obj->pw;
+  obj->h = j.contains("h") ? resolveInt(j["h"], vars) : obj->ph;
+  if (obj->w <= 0 || obj->h <= 0) {
+    std::cerr << "[SceneObjects] Mask '" << path
+              << "' with an empty size – ignored.\n";
+    return nullptr;
+  }
+  return obj;
+}
+
+static std::unique_ptr<TaylorGreenObject>
+parseTaylorGreen(const nlohmann::json &j,
+                 const std::map<std::string, int> &vars) {
+  auto obj = std::make_unique<TaylorGreenObject>();
+  if (j.contains("u0"))    obj->u0    = j["u0"].get<double>();
+  if (j.contains("modes")) obj->modes = resolveInt(j["modes"], vars);
+  obj->gnx = vars.at("nx");
+  obj->gny = vars.at("ny");
   return obj;
 }
 
@@ -154,6 +742,11 @@ makeSceneObject(const std::string &type, const nlohmann::json &j,
                 const std::map<std::string, int> &vars) {
   if (type == "rectangle") return parseRectangle(j, vars);
   if (type == "cylinder")  return parseCylinder(j, vars);
+  if (type == "ellipse")   return parseEllipse(j, vars);
+  if (type == "polygon")   return parsePolygon(j, vars);
+  if (type == "sdf")       return parseSdf(j, vars);
+  if (type == "mask")      return parseMask(j, vars);
+  if (type == "taylor_green") return parseTaylorGreen(j, vars);
 
   std::cerr << "[SceneObjects] Unknown object type: '" << type << "' – ignored.\n";
   return nullptr;
@@ -1,9 +1,11 @@
 #pragma once
 #include "Fields.hpp"
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <utility>
 #include <vector>
 
 /**
@@ -17,14 +19,26 @@
  * ### JSON shape
  * | JSON key      | Class           | Supported operations    |
  * |---------------|-----------------|-------------------------|
- * | `"rectangle"` | RectangleObject | velocity u/v, solid     |
- * | `"cylinder"`  | CylinderObject  | solid only              |
+ * | `"rectangle"` | RectangleObject | velocity u/v, solid, smoke |
+ * | `"cylinder"`  | CylinderObject  | velocity u/v, solid, smoke |
+ * | `"ellipse"`   | EllipseObject   | velocity u/v, solid, smoke |
+ * | `"polygon"`   | PolygonObject   | velocity u/v, solid, smoke |
+ * | `"sdf"`       | SdfObject       | velocity u/v, solid, smoke |
+ * | `"mask"`      | MaskObject      | solid only              |
+ * | `"taylor_green"` | TaylorGreenObject | velocity u/v        |
  *
  * Coordinate values may be integer literals **or** simple arithmetic
  * expressions referencing `nx` and `ny` (e.g. `"nx/2 - 10"`).
- * See @c resolveInt() for the supported grammar.
+ * See @c resolveInt() for the supported grammar. Ellipse, polygon and SDF
+ * values may also be real numbers.
+ *
+ * Every primitive only visits the cells of its bounding box, and
+ * Parameters::applyToFields() rasterises the solids of a scene in parallel
+ * over bands of rows (see SceneObject::rowRange()).
  */
 
+class MappedFile;
+
 /**
  * @brief Abstract base for all scene primitives.
  *
@@ -35,7 +49,22 @@ struct SceneObject {
   virtual ~SceneObject() = default;
 
   /// @brief Mark cells covered by this object as SOLID.
-  virtual void applySolid(Fields2D &f) const { (void)f; }
+  void applySolid(Fields2D &f) const { applySolidRows(f, 0, f.ny); }
+
+  /// @brief Mark cells covered by this object in local rows [j0, j1) as
+  ///        SOLID. Calls for disjoint row ranges may run concurrently.
+  virtual void applySolidRows(Fields2D &f, int j0, int j1) const {
+    (void)f, (void)j0, (void)j1;
+  }
+
+  /**
+   * @brief Global cell rows [j0, j1) this object can touch.
+   * @return @c false if the object is unbounded (the default).
+   */
+  virtual bool rowRange(int &j0, int &j1) const {
+    (void)j0, (void)j1;
+    return false;
+  }
 
   /// @brief Set the u-velocity of cells covered by this object.
   virtual void applyVelocityU(Fields2D &f) const { (void)f; }
@@ -58,24 +87,216 @@ struct RectangleObject : public SceneObject {
   int x1{0}, y1{0}; ///< Bottom-left corner (inclusive, cell indices).
   int x2{0}, y2{0}; ///< Top-right  corner (inclusive, cell indices).
 
-  void applySolid(Fields2D &f) const override;
+  void applySolidRows(Fields2D &f, int j0, int j1) const override;
+  bool rowRange(int &j0, int &j1) const override;
   void applyVelocityU(Fields2D &f) const override;
   void applyVelocityV(Fields2D &f) const override;
   void applySmoke(Fields2D &f) const override;
 };
 
 /**
- * @brief Filled disc primitive — marks cells inside the disc as SOLID.
+ * @brief Base of the primitives defined by an inside test: cell (i, j)
+ *        is covered when the point (i, j) — global cell indices — is
+ *        inside the shape.
  *
- * JSON keys: `"x"`, `"y"`, `"r"` (centre and radius in cell indices).
+ * Subclasses give the bounding box and either contains() alone (each row
+ * of the box is then scanned) or also a closed-form spans().
+ */
+struct ShapeObject : public SceneObject {
+  varType val{0}; ///< Velocity / smoke value written inside the shape.
+
+  void applySolidRows(Fields2D &f, int j0, int j1) const override;
+  bool rowRange(int &j0, int &j1) const override;
+  void applyVelocityU(Fields2D &f) const override;
+  void applyVelocityV(Fields2D &f) const override;
+  void applySmoke(Fields2D &f) const override;
+
+  /// @brief Inclusive bounding box in global cell indices.
+  virtual void bounds(int &i0, int &j0, int &i1, int &j1) const = 0;
+
+  /// @return @c true if the point (x, y) is inside the shape.
+  [[nodiscard]] virtual bool contains(double x, double y) const = 0;
+
+  /**
+   * @brief Append the inclusive column runs [a, b] of row @p j that are
+   *        inside the shape, limited to columns [i0, i1].
+   *
+   * The default tests contains() at every column.
+   */
+  virtual void spans(int j, int i0, int i1,
+                     std::vector<std::pair<int, int>> &out) const;
+
+private:
+  /// @brief Call @p set(i0, i1, j) with the local inclusive runs of local
+  ///        rows [j0, j1) of an @p nx-wide grid at @p f's origin.
+  template <typename Set>
+  void raster(const Fields2D &f, int nx, int j0, int j1, Set set) const;
+};
+
+/**
+ * @brief Filled disc.
  *
- * @note Velocity initialisation for cylinder objects is not yet implemented.
+ * JSON keys: `"x"`, `"y"`, `"r"` (centre and radius in cell indices),
+ * `"val"` (velocity / smoke value).
  */
-struct CylinderObject : public SceneObject {
+struct CylinderObject : public ShapeObject {
   int cx{0}, cy{0}; ///< Centre cell indices.
   int r{0};         ///< Radius in cells.
 
-  void applySolid(Fields2D &f) const override;
+  void bounds(int &i0, int &j0, int &i1, int &j1) const override;
+  [[nodiscard]] bool contains(double x, double y) const override;
+  void spans(int j, int i0, int i1,
+             std::vector<std::pair<int, int>> &out) const override;
+};
+
+/**
+ * @brief Filled, optionally rotated ellipse.
+ *
+ * JSON keys: `"x"`, `"y"` (centre), `"rx"`, `"ry"` (semi-axes, cells),
+ * `"angle"` (degrees, counter-clockwise, default 0), `"val"`.
+ */
+struct EllipseObject : public ShapeObject {
+  double cx{0}, cy{0}; ///< Centre (cell indices).
+  double rx{1}, ry{1}; ///< Semi-axes (cells).
+  double angle{0};     ///< Rotation (radians).
+
+  void bounds(int &i0, int &j0, int &i1, int &j1) const override;
+  [[nodiscard]] bool contains(double x, double y) const override;
+  void spans(int j, int i0, int i1,
+             std::vector<std::pair<int, int>> &out) const override;
+};
+
+/**
+ * @brief Filled simple or self-intersecting polygon (even-odd rule).
+ *
+ * JSON keys: `"points"` (array of `[x, y]` vertices in cell indices, at
+ * least three), `"val"`. Rows are filled by scanline, half-open like the
+ * pixel centres of a rasteriser: the polygon `[[0,0],[4,0],[4,4],[0,4]]`
+ * covers the 4 × 4 cells 0..3.
+ */
+struct PolygonObject : public ShapeObject {
+  std::vector<std::pair<double, double>> points; ///< Vertices (x, y).
+
+  void bounds(int &i0, int &j0, int &i1, int &j1) const override;
+  [[nodiscard]] bool contains(double x, double y) const override;
+  void spans(int j, int i0, int i1,
+             std::vector<std::pair<int, int>> &out) const override;
+};
+
+/**
+ * @brief Signed-distance-function shape: cells where the combined distance
+ *        is <= 0.
+ *
+ * JSON keys:
+ * - `"terms"`: array of `{ "circle": {"x","y","r"} }`,
+ *   `{ "box": {"x","y","hx","hy"} }` (centre and half sizes) or
+ *   `{ "segment": {"x1","y1","x2","y2","r"} }` (capsule);
+ * - `"op"`: `"union"` (default), `"intersection"`, `"subtraction"` (the
+ *   first term minus the others) or `"smooth_union"` with blend radius
+ *   `"k"`;
+ * - `"round"`: grows the result by this distance (default 0);
+ * - `"val"`.
+ *
+ * All lengths are in cells.
+ */
+struct SdfObject : public ShapeObject {
+  /// One primitive distance function.
+  struct Term {
+    enum Kind { CIRCLE, BOX, SEGMENT } kind = CIRCLE;
+    double x1{0}, y1{0}; ///< Centre, or first end of a segment.
+    double x2{0}, y2{0}; ///< Half sizes (box) or second end (segment).
+    double r{0};         ///< Radius (circle, segment).
+
+    /// @return Signed distance from (x, y) to the term.
+    [[nodiscard]] double distance(double x, double y) const;
+  };
+  enum Op { UNION, INTERSECTION, SUBTRACTION, SMOOTH_UNION };
+
+  std::vector<Term> terms;
+  Op op{UNION};
+  double k{0};     ///< Blend radius of SMOOTH_UNION.
+  double round{0}; ///< Outward offset of the surface.
+
+  /// @return Combined signed distance at (x, y).
+  [[nodiscard]] double distance(double x, double y) const;
+
+  void bounds(int &i0, int &j0, int &i1, int &j1) const override;
+  [[nodiscard]] bool contains(double x, double y) const override;
+};
+
+/**
+ * @brief Solid cells read from a memory-mapped bitmap file.
+ *
+ * JSON keys:
+ * - `"file"`: binary PGM (P5, 8 or 16 bit), binary PBM (P4) or, with
+ *   neither magic number, raw 8-bit pixels;
+ * - `"width"`, `"height"`: pixel size of a raw file (required for raw);
+ * - `"x"`, `"y"`: cell of the lower-left image corner (default 0);
+ * - `"w"`, `"h"`: image size in cells (default: one cell per pixel),
+ *   nearest-neighbour scaled, so `"w": "nx", "h": "ny"` fits the domain;
+ * - `"threshold"`: a PGM / raw pixel is set when its value is at least
+ *   this (default: half the PGM maxval, 1 for raw); PBM black pixels are
+ *   set;
+ * - `"invert"`: mark the unset pixels instead.
+ *
+ * Set pixels become SOLID; the first image row is the top. Nothing is
+ * decoded up front: each row band of Parameters::applyToFields() reads
+ * its pixel rows straight from the mapped pages, so a rank or a band only
+ * touches the part of the file it covers.
+ */
+struct MaskObject : public SceneObject {
+  /// Pixel encoding of the mapped data.
+  enum Format { GREY8, GREY16, BITS };
+
+  std::shared_ptr<const MappedFile> file; ///< The mapped mask file.
+  std::size_t offset{0};  ///< Byte offset of the first pixel row.
+  std::size_t rowBytes{0}; ///< Bytes per pixel row.
+  Format format{GREY8};
+  int pw{0}, ph{0};      ///< Image size in pixels.
+  int threshold{1};      ///< GREY8 / GREY16: set when value >= threshold.
+  bool invert{false};    ///< Mark unset pixels instead.
+  int x0{0}, y0{0};      ///< Lower-left cell of the image.
+  int w{0}, h{0};        ///< Image size in cells.
+
+  void applySolidRows(Fields2D &f, int j0, int j1) const override;
+  bool rowRange(int &j0, int &j1) const override;
+};
+
+/**
+ * @brief Taylor-Green vortex array filling the whole domain.
+ *
+ * JSON keys: `"u0"` (amplitude, default 1) and `"modes"` (default 1). With
+ * L_x = nx·dx, L_y = ny·dy, k_x = modes·π / L_x, k_y likewise and
+ * r = k_x / k_y:
+ * @code
+ *   u =  u0   sin(k_x x) cos(k_y y)
+ *   v = -u0 r cos(k_x x) sin(k_y y)
+ *   p =  ρ u0² / 4 · (cos(2 k_x x) + r² cos(2 k_y y))
+ * @endcode
+ * All four edges are cell walls of the vortex array (no normal velocity,
+ * no normal pressure gradient), so the scene needs @c "walls": true — the
+ * default open right/top boundaries let the vortex drain. Without
+ * viscosity this is a steady solution of the Euler equations, so the
+ * initial field is also the exact solution at any time (see the
+ * @c --convergence driver).
+ */
+struct TaylorGreenObject : public SceneObject {
+  double u0{1.0};     ///< Velocity amplitude.
+  int modes{1};       ///< Vortex cells per side.
+  int gnx{0}, gny{0}; ///< Global grid size (for the domain length).
+
+  void applyVelocityU(Fields2D &f) const override;
+  void applyVelocityV(Fields2D &f) const override;
+
+  /// @brief Exact u, v and p at (x, y) for a grid with spacing dx, dy.
+  [[nodiscard]] double u(double x, double y, double dx, double dy) const;
+  [[nodiscard]] double v(double x, double y, double dx, double dy) const;
+  [[nodiscard]] double p(double x, double y, double dx, double dy,
+                         double density) const;
+
+private:
+  /// @return k for a domain side of @p length.
+  [[nodiscard]] double wavenumber(double length) const;
 };
 
 /**
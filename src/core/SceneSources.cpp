@@ -0,0 +1,75 @@
+#include "SceneSources.hpp"
+#include "Fields.hpp"
+#include "Parameters.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/// Below this many cells a parallel region costs more than the copy.
+constexpr std::size_t kParallelCells = 16384;
+
+} // namespace
+
+// Compilation
+
+SceneSources::SceneSources(const Parameters &params, const Fields2D &fields) {
+  // Apply the scene once to a NaN-filled scratch copy: whatever is no
+  // longer NaN afterwards is written by some object.
+  Fields2D scratch(fields.nx, fields.ny, fields.density, fields.dt, fields.dx,
+                   fields.dy);
+  scratch.originI = fields.originI;
+  scratch.originJ = fields.originJ;
+  const varType nan = std::numeric_limits<varType>::quiet_NaN();
+  Grid2D *grids[NUM_FIELDS] = {&scratch.u, &scratch.v, &scratch.smokeMap};
+  for (Grid2D *g : grids)
+    std::fill(g->A.begin(), g->A.end(), nan);
+  params.applySourcesToFields(scratch);
+
+  // One span per run of written cells in a row.
+  for (int field = 0; field < NUM_FIELDS; ++field) {
+    const Grid2D &g = *grids[field];
+    for (int j = 0; j < g.ny; ++j) {
+      int i = 0;
+      while (i < g.nx) {
+        if (std::isnan(g.Get(i, j))) {
+          ++i;
+          continue;
+        }
+        Span s{j, i, i, values_.size()};
+        for (; i < g.nx && !std::isnan(g.Get(i, j)); ++i)
+          values_.push_back(g.Get(i, j));
+        s.i1 = i;
+        spans_[field].push_back(s);
+      }
+    }
+  }
+}
+
+// Application
+
+void SceneSources::apply(Fields2D &fields, double scale) const {
+  Grid2D *grids[NUM_FIELDS] = {&fields.u, &fields.v, &fields.smokeMap};
+  const bool parallel = values_.size() > kParallelCells;
+
+  for (int field = 0; field < NUM_FIELDS; ++field) {
+    Grid2D &g = *grids[field];
+    const std::vector<Span> &spans = spans_[field];
+    // Smoke is a concentration: only the velocities follow the schedule.
+    const double a = field == SMOKE ? 1.0 : scale;
+    const int n = static_cast<int>(spans.size());
+
+#pragma omp parallel for schedule(static) if (parallel)
+    for (int k = 0; k < n; ++k) {
+      const Span &s = spans[k];
+      const varType *src = values_.data() + s.first;
+      varType *dst = g.A.data() + static_cast<std::size_t>(g.nx) * s.j;
+      if (a == 1.0)
+        std::copy(src, src + (s.i1 - s.i0), dst + s.i0);
+      else
+        for (int i = s.i0; i < s.i1; ++i)
+          dst[i] = static_cast<varType>(a * src[i - s.i0]);
+    }
+  }
+}
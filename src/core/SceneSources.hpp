@@ -0,0 +1,69 @@
+#pragma once
+#include "Precision.hpp"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @file SceneSources.hpp
+ * @brief Scene velocity / smoke sources compiled once and re-imposed every
+ *        step in source mode.
+ */
+
+class Fields2D;
+class Parameters;
+
+/**
+ * @brief The cells a source-mode scene writes, as row spans with their
+ *        values.
+ *
+ * Re-applying the scene with Parameters::applyToFields() every step would
+ * re-parse the JSON, re-evaluate the coordinate expressions and allocate
+ * the SceneObjects each time. Instead the velocity and smoke objects are
+ * applied once to a NaN-filled scratch copy of the fields; every run of
+ * written cells in a row becomes one Span. apply() then only copies values:
+ * @code
+ * SceneSources sources(params, *fields);       // constructor
+ * sources.apply(*fields, params.source.scale(t)); // every step
+ * @endcode
+ * Solid objects are left out — the labels they set never change after
+ * start-up. Objects applied later overwrite earlier ones, as before.
+ */
+class SceneSources {
+public:
+  /// @brief The grids a source writes.
+  enum Field { U = 0, V = 1, SMOKE = 2, NUM_FIELDS = 3 };
+
+  /// @brief A run of written cells in one row of one grid.
+  struct Span {
+    int j;             ///< Row.
+    int i0, i1;        ///< Columns [i0, i1).
+    std::size_t first; ///< Index of the value of (i0, j) in values().
+  };
+
+  /**
+   * @brief Compile the velocity and smoke objects of @p params for grids
+   *        shaped like @p fields (same size and MPI origin).
+   */
+  SceneSources(const Parameters &params, const Fields2D &fields);
+
+  /**
+   * @brief Write every compiled value into @p fields.
+   * @param scale Factor on the u and v values (SourceConfig::scale()).
+   */
+  void apply(Fields2D &fields, double scale) const;
+
+  /// @return The spans of @p field, in row order.
+  [[nodiscard]] const std::vector<Span> &spans(Field field) const {
+    return spans_[field];
+  }
+
+  /// @return The unscaled values, indexed by Span::first.
+  [[nodiscard]] const std::vector<varType> &values() const { return values_; }
+
+  /// @return Number of cells written per step, over all grids.
+  [[nodiscard]] std::size_t cells() const { return values_.size(); }
+
+private:
+  std::vector<Span> spans_[NUM_FIELDS];
+  std::vector<varType> values_;
+};
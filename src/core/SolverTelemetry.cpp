@@ -0,0 +1,97 @@
+#include "SolverTelemetry.hpp"
+#include "Helpers.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+
+namespace {
+
+constexpr std::size_t kMaxListedSteps = 20; ///< hit_max step numbers kept.
+
+} // namespace
+
+bool SolverTelemetry::open(const std::string &csvPath,
+                           std::vector<int> historySteps, int historyEvery,
+                           int firstStep) {
+  historySteps_ = std::move(historySteps);
+  std::sort(historySteps_.begin(), historySteps_.end());
+  historyEvery_ = std::max(0, historyEvery);
+  const std::filesystem::path path(csvPath);
+  jsonPath_ = std::filesystem::path(path).replace_extension(".json").string();
+  if (!path.parent_path().empty())
+    std::filesystem::create_directories(path.parent_path());
+
+  // A restarted run keeps the rows before its first step and appends.
+  if (firstStep > 1) {
+    csv_ = openCsvForRestart(csvPath, firstStep);
+  } else {
+    csv_.open(csvPath, std::ios::trunc);
+    if (csv_.is_open())
+      csv_ << "step,iterations,initial_residual,final_residual,"
+              "relative_residual,time_s,hit_max\n";
+  }
+  csv_ << std::setprecision(8);
+  return csv_.is_open();
+}
+
+bool SolverTelemetry::wantsHistory(int step) const {
+  return (historyEvery_ > 0 && step % historyEvery_ == 0) ||
+         std::binary_search(historySteps_.begin(), historySteps_.end(), step);
+}
+
+void SolverTelemetry::record(int step, Solve solve) {
+  const double relative = solve.initialResidual > 0.0
+                              ? solve.finalResidual / solve.initialResidual
+                              : 0.0;
+  iterations_.push_back(solve.iterations);
+  totalIterations_ += solve.iterations;
+  seconds_ += solve.seconds;
+  worstRelative_ = std::max(worstRelative_, relative);
+  if (solve.hitMax) {
+    ++hitMax_;
+    if (hitMaxSteps_.size() < kMaxListedSteps)
+      hitMaxSteps_.push_back(step);
+  }
+  if (!solve.history.empty())
+    histories_[step] = std::move(solve.history);
+
+  if (csv_.is_open())
+    csv_ << step << ',' << solve.iterations << ',' << solve.initialResidual
+         << ',' << solve.finalResidual << ',' << relative << ','
+         << solve.seconds << ',' << (solve.hitMax ? 1 : 0) << '\n';
+}
+
+nlohmann::json SolverTelemetry::summary() const {
+  std::vector<int> sorted = iterations_;
+  std::sort(sorted.begin(), sorted.end());
+  auto pct = [&sorted](double q) {
+    return sorted.empty()
+               ? 0
+               : sorted[static_cast<std::size_t>(
+                     q * static_cast<double>(sorted.size() - 1) + 0.5)];
+  };
+  const double n = static_cast<double>(std::max<std::size_t>(1, solves()));
+  return {{"solves", solves()},
+          {"iterations",
+           {{"total", totalIterations_},
+            {"mean", static_cast<double>(totalIterations_) / n},
+            {"min", sorted.empty() ? 0 : sorted.front()},
+            {"p50", pct(0.50)},
+            {"p95", pct(0.95)},
+            {"max", sorted.empty() ? 0 : sorted.back()}}},
+          {"time_s", seconds_},
+          {"mean_time_s", seconds_ / n},
+          {"hit_max", {{"count", hitMax_}, {"first_steps", hitMaxSteps_}}},
+          {"worst_relative_residual", worstRelative_}};
+}
+
+void SolverTelemetry::writeSummary() {
+  if (!csv_.is_open())
+    return;
+  csv_.flush();
+  nlohmann::json out = summary();
+  out["history"] = nlohmann::json::object();
+  for (const auto &[step, residuals] : histories_)
+    out["history"][std::to_string(step)] = residuals;
+  std::ofstream(jsonPath_) << out.dump(2) << '\n';
+}
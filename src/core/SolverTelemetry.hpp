@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @file SolverTelemetry.hpp
+ * @brief Per-step convergence record of the pressure solver.
+ */
+
+/**
+ * @brief Collects one record per pressure solve and summarises them.
+ *
+ * Recording is always on and costs a few words per step; the per-step CSV
+ * and the JSON summary are only written once open() has been called.
+ *
+ * ### Files
+ * ```
+ *   <log>.csv   step,iterations,initial_residual,final_residual,
+ *               relative_residual,time_s,hit_max
+ *   <log>.json  summary (see summary()) + "history": { "<step>": [r0, r1, ...] }
+ * ```
+ * Residuals are the RMS Poisson residuals of SemiLagrangian::
+ * computeResidualNorm(); the relative residual is final / initial.
+ */
+class SolverTelemetry {
+public:
+  /// @brief Outcome of one pressure solve.
+  struct Solve {
+    int iterations = 0;           ///< Sweeps performed.
+    double initialResidual = 0.0; ///< After the first sweep.
+    double finalResidual = 0.0;   ///< After the last sweep.
+    double seconds = 0.0;         ///< Wall time of the solve.
+    bool hitMax = false;          ///< Stopped at maxIters, not converged.
+    std::vector<double> history;  ///< Residual per sweep, if requested.
+  };
+
+  /**
+   * @brief Start writing the CSV log.
+   * @param csvPath      Log path; the summary goes next to it as .json.
+   * @param historySteps Steps whose residual history is kept.
+   * @param historyEvery Also keep it every N steps (0 = never).
+   * @param firstStep    First step of this run: on a restart, rows from
+   *                     @p firstStep on are dropped and new rows appended.
+   * @return @c false if the file cannot be opened.
+   */
+  bool open(const std::string &csvPath, std::vector<int> historySteps,
+            int historyEvery, int firstStep);
+
+  /// @return @c true if the solve of @p step should record its history.
+  [[nodiscard]] bool wantsHistory(int step) const;
+
+  /// @brief Add the solve of @p step (and its CSV row when open).
+  void record(int step, Solve solve);
+
+  /**
+   * @brief Totals over the recorded steps: solve count, iterations (total,
+   *        mean, min, p50, p95, max), time, steps that hit maxIters
+   *        (count and first few step numbers) and the worst final relative
+   *        residual.
+   */
+  [[nodiscard]] nlohmann::json summary() const;
+
+  /// @brief Write summary() and the histories to the .json next to the
+  ///        log and flush the CSV (no-op unless open).
+  void writeSummary();
+
+  /// @return Number of recorded solves.
+  [[nodiscard]] std::size_t solves() const { return iterations_.size(); }
+
+private:
+  std::ofstream csv_;
+  std::string jsonPath_;
+  std::vector<int> historySteps_;
+  int historyEvery_ = 0;
+
+  std::vector<int> iterations_; ///< Per solve, for the percentiles.
+  std::int64_t totalIterations_ = 0;
+  double seconds_ = 0.0;
+  double worstRelative_ = 0.0;
+  std::int64_t hitMax_ = 0;
+  std::vector<int> hitMaxSteps_; ///< First few steps that hit maxIters.
+  std::map<int, std::vector<double>> histories_;
+};
@@ -0,0 +1,122 @@
+#include "TileMap.hpp"
+#include "Fields.hpp"
+#include <algorithm>
+#include <cmath>
+
+TileMap::TileMap(int nx, int ny, int tileSize)
+    : nx(nx), ny(ny), tileSize(tileSize), ntx((nx + tileSize - 1) / tileSize),
+      nty((ny + tileSize - 1) / tileSize),
+      state_(static_cast<std::size_t>(ntx) * nty, ACTIVE),
+      pinned_(static_cast<std::size_t>(ntx) * nty, 0) {
+  rebuildActiveList();
+}
+
+void TileMap::rebuildActiveList() {
+  active_.clear();
+  fluid_.clear();
+  for (int t = 0; t < ntx * nty; ++t) {
+    if (state_[t] == ACTIVE)
+      active_.push_back(t);
+    if (state_[t] != SOLID)
+      fluid_.push_back(t);
+  }
+}
+
+void TileMap::classifySolid(const Fields2D &f) {
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int tj = 0; tj < nty; ++tj) {
+    for (int ti = 0; ti < ntx; ++ti) {
+      const Range r = tileRange(ti, tj, nx, ny);
+      bool allSolid = true;
+      for (int j = r.j0; j < r.j1 && allSolid; ++j)
+        for (int i = r.i0; i < r.i1; ++i)
+          if (f.Label(i, j) != Fields2D::SOLID) {
+            allSolid = false;
+            break;
+          }
+      if (allSolid)
+        state_[ntx * tj + ti] = SOLID;
+    }
+  }
+  rebuildActiveList();
+}
+
+void TileMap::keepActive(int i0, int i1, int j0, int j1) {
+  if (i0 >= i1 || j0 >= j1)
+    return;
+  // u / v spans may reach one face past the last cell: clamp to the map.
+  const int ti0 = std::clamp(i0 / tileSize, 0, ntx - 1);
+  const int ti1 = std::clamp((i1 - 1) / tileSize, 0, ntx - 1);
+  const int tj0 = std::clamp(j0 / tileSize, 0, nty - 1);
+  const int tj1 = std::clamp((j1 - 1) / tileSize, 0, nty - 1);
+  for (int tj = tj0; tj <= tj1; ++tj)
+    for (int ti = ti0; ti <= ti1; ++ti) {
+      pinned_[ntx * tj + ti] = 1;
+      if (state_[ntx * tj + ti] != SOLID)
+        state_[ntx * tj + ti] = ACTIVE;
+    }
+  rebuildActiveList();
+}
+
+// Returns true if any |value| of grid g inside range r exceeds threshold.
+static bool anyAbove(const Grid2D &g, const TileMap::Range &r,
+                     varType threshold) {
+  for (int j = r.j0; j < r.j1; ++j)
+    for (int i = r.i0; i < r.i1; ++i)
+      if (std::abs(g.Get(i, j)) > threshold)
+        return true;
+  return false;
+}
+
+void TileMap::update(const Fields2D &f, varType threshold, bool full) {
+  const int n = ntx * nty;
+
+  // Candidates: tiles the flow may have reached since the last update.
+  std::vector<uint8_t> candidate(n, full ? 1 : 0);
+  if (!full) {
+    for (const int t : active_) {
+      const int ti = t % ntx;
+      const int tj = t / ntx;
+      for (int dj = -1; dj <= 1; ++dj)
+        for (int di = -1; di <= 1; ++di) {
+          const int a = ti + di;
+          const int b = tj + dj;
+          if (a >= 0 && a < ntx && b >= 0 && b < nty)
+            candidate[ntx * b + a] = 1;
+        }
+    }
+  }
+
+  std::vector<uint8_t> hot(n, 0);
+#pragma omp parallel for schedule(dynamic)
+  for (int t = 0; t < n; ++t) {
+    if (!candidate[t] || state_[t] == SOLID)
+      continue;
+    const int ti = t % ntx;
+    const int tj = t / ntx;
+    hot[t] = anyAbove(f.u, tileRange(ti, tj, f.u.nx, f.u.ny), threshold) ||
+             anyAbove(f.v, tileRange(ti, tj, f.v.nx, f.v.ny), threshold);
+  }
+
+  for (int t = 0; t < n; ++t)
+    if (candidate[t] && state_[t] != SOLID && !pinned_[t])
+      state_[t] = QUIESCENT;
+
+  // Dilate hot tiles by one so flow can advect into their neighbours.
+  for (int t = 0; t < n; ++t) {
+    if (!hot[t])
+      continue;
+    const int ti = t % ntx;
+    const int tj = t / ntx;
+    for (int dj = -1; dj <= 1; ++dj)
+      for (int di = -1; di <= 1; ++di) {
+        const int a = ti + di;
+        const int b = tj + dj;
+        if (a >= 0 && a < ntx && b >= 0 && b < nty &&
+            state_[ntx * b + a] != SOLID)
+          state_[ntx * b + a] = ACTIVE;
+      }
+  }
+
+  rebuildActiveList();
+}
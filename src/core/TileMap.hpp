@@ -0,0 +1,154 @@
+#pragma once
+#include "Precision.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file TileMap.hpp
+ * @brief Coarse tile-activity map used to skip solid and quiescent regions.
+ */
+
+class Fields2D;
+
+/**
+ * @brief Partition of the nx × ny cell grid into square tiles, each flagged
+ *        ACTIVE, QUIESCENT or SOLID.
+ *
+ * Kernels loop over @c numActive() tiles instead of the full grid:
+ * @code
+ * #pragma omp parallel for schedule(dynamic)
+ * for (int t = 0; t < tiles.numActive(); ++t) {
+ *   const TileMap::Range r = tiles.activeRange(t, grid.nx, grid.ny);
+ *   for (int j = r.j0; j < r.j1; ++j)
+ *     for (int i = r.i0; i < r.i1; ++i) ...
+ * }
+ * @endcode
+ * Ranges are given per grid so the staggered u/v (one extra column/row) and
+ * the diagnostic grids (one fewer) are covered exactly: the last tile in each
+ * direction extends to the grid edge.
+ *
+ * The pressure solve is elliptic: a QUIESCENT tile still carries pressure
+ * that the active flow depends on, so the solver sweeps the @c numFluid()
+ * tiles (everything but SOLID) instead; only the local kernels (advection,
+ * diagnostics) skip QUIESCENT tiles.
+ *
+ * When tiling is disabled every tile stays ACTIVE, which keeps results
+ * identical to a full sweep while still giving a tile-parallel schedule.
+ */
+class TileMap {
+public:
+  /// @brief Activity state of one tile.
+  enum State : uint8_t {
+    ACTIVE = 0,    ///< Swept by every kernel.
+    QUIESCENT = 1, ///< All velocities below threshold: skipped.
+    SOLID = 2      ///< Every cell SOLID: skipped permanently.
+  };
+
+  /// @brief Half-open index range of one tile on a given grid.
+  struct Range {
+    int i0, i1, j0, j1;
+  };
+
+  /**
+   * @brief Build a map with every tile ACTIVE.
+   * @param nx       Number of pressure cells in x.
+   * @param ny       Number of pressure cells in y.
+   * @param tileSize Tile edge length in cells.
+   */
+  TileMap(int nx, int ny, int tileSize);
+
+  int nx, ny;   ///< Cell grid covered by the map.
+  int tileSize; ///< Tile edge length in cells.
+  int ntx, nty; ///< Number of tiles in x / y.
+
+  /**
+   * @brief Flag tiles whose cells are all SOLID; call after the solid
+   *        geometry has been applied.
+   */
+  void classifySolid(const Fields2D &f);
+
+  /**
+   * @brief Keep the tiles covering cells [@p i0, @p i1) × [@p j0, @p j1)
+   *        ACTIVE for good (unless SOLID).
+   *
+   * For the cells of per-step sources: a source that is zero for a while
+   * (a ramp, an amplitude through 0) would otherwise leave its tile
+   * QUIESCENT, and a tile no ACTIVE tile touches is never rescanned.
+   */
+  void keepActive(int i0, int i1, int j0, int j1);
+
+  /**
+   * @brief Re-evaluate activity after the flow has moved.
+   *
+   * Only tiles that are ACTIVE or touch an ACTIVE tile are rescanned, since
+   * flow cannot cross more than one tile per step (CFL < tileSize). A tile
+   * becomes ACTIVE if any |u| or |v| on it exceeds @p threshold; the active
+   * set is then dilated by one tile so the flow can spread into it. Tiles
+   * passed to keepActive() stay ACTIVE.
+   *
+   * @param f         Current fields.
+   * @param threshold Velocity magnitude below which a tile is quiescent.
+   * @param full      Rescan every non-SOLID tile (used at start-up).
+   */
+  void update(const Fields2D &f, varType threshold, bool full = false);
+
+  /// @return Number of ACTIVE tiles.
+  [[nodiscard]] int numActive() const {
+    return static_cast<int>(active_.size());
+  }
+
+  /// @return Fraction of tiles that are ACTIVE.
+  [[nodiscard]] double activeFraction() const {
+    return static_cast<double>(active_.size()) / (ntx * nty);
+  }
+
+  /// @return Number of tiles that are not SOLID.
+  [[nodiscard]] int numFluid() const {
+    return static_cast<int>(fluid_.size());
+  }
+
+  /// @return Fraction of tiles that are not SOLID.
+  [[nodiscard]] double fluidFraction() const {
+    return static_cast<double>(fluid_.size()) / (ntx * nty);
+  }
+
+  /// @return @c true if tile (ti, tj) is not SOLID.
+  [[nodiscard]] bool isFluid(int ti, int tj) const {
+    return state_[ntx * tj + ti] != SOLID;
+  }
+
+  /// @brief activeRange() over the non-SOLID tiles, @p t in [0, numFluid()).
+  [[nodiscard]] Range fluidRange(int t, int gnx, int gny) const {
+    return tileRange(fluid_[t] % ntx, fluid_[t] / ntx, gnx, gny);
+  }
+
+  /// @return @c true if tile (ti, tj) is ACTIVE.
+  [[nodiscard]] bool isActive(int ti, int tj) const {
+    return state_[ntx * tj + ti] == ACTIVE;
+  }
+
+  /**
+   * @brief Range of the @p t-th active tile on a grid of @p gnx × @p gny.
+   * @param t   Index into the active list, in [0, numActive()).
+   * @param gnx Width of the grid being swept (nx, nx+1 or nx-1).
+   * @param gny Height of the grid being swept.
+   */
+  [[nodiscard]] Range activeRange(int t, int gnx, int gny) const {
+    return tileRange(active_[t] % ntx, active_[t] / ntx, gnx, gny);
+  }
+
+  /// @brief Range of tile (ti, tj) on a grid of @p gnx × @p gny.
+  [[nodiscard]] Range tileRange(int ti, int tj, int gnx, int gny) const {
+    return {ti * tileSize, ti == ntx - 1 ? gnx : (ti + 1) * tileSize,
+            tj * tileSize, tj == nty - 1 ? gny : (tj + 1) * tileSize};
+  }
+
+private:
+  std::vector<uint8_t> state_; ///< Per-tile State, row-major.
+  std::vector<int> active_;    ///< Flat indices of ACTIVE tiles.
+  std::vector<int> fluid_;     ///< Flat indices of non-SOLID tiles.
+  std::vector<uint8_t> pinned_; ///< Per-tile flag set by keepActive().
+
+  /// @brief Rebuild @c active_ and @c fluid_ from @c state_.
+  void rebuildActiveList();
+};
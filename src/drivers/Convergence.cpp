@@ -0,0 +1,243 @@
+#include "Convergence.hpp"
+#include "../solvers/SemiLagrangian/SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+/// @return Memory held by the fields and labels of @p f, in MiB. Unlike the
+///         process RSS, whose peak only grows over the ladder, it belongs
+///         to this run alone.
+double fieldMb(const Fields2D &f) {
+  std::size_t bytes = f.Labels().size();
+  for (const Grid2D *g : {&f.u, &f.v, &f.p, &f.div, &f.normVelocity,
+                          &f.smokeMap})
+    bytes += g->A.size() * sizeof(varType);
+  return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+/// @return The Taylor-Green object of @p p's initial u-velocity, if any.
+std::unique_ptr<TaylorGreenObject> taylorGreen(const Parameters &p) {
+  for (auto &obj : p.velocityUObjects())
+    if (auto *tg = dynamic_cast<TaylorGreenObject *>(obj.get())) {
+      obj.release();
+      return std::unique_ptr<TaylorGreenObject>(tg);
+    }
+  return nullptr;
+}
+
+} // namespace
+
+// Construction
+
+Convergence::Convergence(const Parameters &base)
+    : base_(base), sizes_(base.convergence),
+      solvers_(base.convergence_solvers),
+      tolerances_(base.convergence_tolerances) {
+  if (!taylorGreen(base))
+    throw std::runtime_error("[Convergence] The config has no \"taylor_green\""
+                             " object under \"velocityu\"");
+  sizes_.erase(std::remove_if(sizes_.begin(), sizes_.end(),
+                              [](int n) { return n < 4; }),
+               sizes_.end());
+  std::sort(sizes_.begin(), sizes_.end());
+  sizes_.erase(std::unique(sizes_.begin(), sizes_.end()), sizes_.end());
+  if (sizes_.empty())
+    throw std::runtime_error("[Convergence] No grid size of at least 4");
+  if (!base.walls)
+    std::cerr << "[Convergence] Warning: the config has no \"walls\": true;"
+                 " the runs close the domain edges anyway\n";
+  if (solvers_.empty())
+    solvers_.push_back(base.solver.typeName());
+  if (tolerances_.empty())
+    tolerances_.push_back(base.solver.tolerance);
+}
+
+// Execution
+
+Convergence::Result Convergence::measure(const std::string &solver,
+                                         double tolerance, int n) const {
+  // Same domain, same CFL number, same end time.
+  const double refine = static_cast<double>(n) / base_.nx;
+  Parameters p = base_;
+  p.nx = n;
+  p.ny = std::max(4, static_cast<int>(std::lround(base_.ny * refine)));
+  p.dx = base_.dx / refine;
+  p.dy = base_.dy * base_.ny / p.ny;
+  p.dt = base_.dt / refine;
+  p.nt = std::max(1, static_cast<int>(std::lround(base_.nt * refine)));
+  p.solver = SolverConfig::fromJson(
+      {{"type", solver},
+       {"tolerance", tolerance},
+       {"max_iterations", base_.solver.maxIters}});
+  p.walls = true; // the analytic solution has no flow through the edges
+  p.quiet = true;
+  p.restart.clear();
+  p.folder = base_.folder + "/convergence";
+  p.write_u = p.write_v = p.write_p = false;
+  p.write_div = p.write_norm_velocity = p.write_smoke = false;
+  p.output.views.clear();
+  p.render.clear();
+  p.checkpoint.every = 0;
+  p.statistics.enabled = false;
+  p.monitors.enabled = false;
+  p.profile.enabled = false;
+
+  Result r;
+  r.solver = p.solver.typeName();
+  r.tolerance = tolerance;
+  r.nx = p.nx;
+  r.ny = p.ny;
+  r.steps = p.nt;
+  try {
+    SemiLagrangian sim(p);
+    const double start = GET_TIME();
+    sim.Run();
+    r.wall = GET_TIME() - start;
+    r.fieldMb = fieldMb(sim.GetFields());
+    r.iterations = static_cast<long long>(
+        sim.GetPressureTelemetry().summary()["iterations"]["total"]
+            .get<double>());
+
+    const std::unique_ptr<TaylorGreenObject> tg = taylorGreen(p);
+    const Fields2D &f = sim.GetFields();
+    const double dx = p.dx, dy = p.dy;
+
+    // Velocity: every u and v face.
+    double sq = 0.0;
+    for (int j = 0; j < f.u.ny; ++j)
+      for (int i = 0; i < f.u.nx; ++i) {
+        const double e = f.u.Get(i, j) - tg->u(i * dx, (j + 0.5) * dy, dx, dy);
+        sq += e * e;
+        r.linfU = std::max(r.linfU, std::abs(e));
+      }
+    for (int j = 0; j < f.v.ny; ++j)
+      for (int i = 0; i < f.v.nx; ++i) {
+        const double e = f.v.Get(i, j) - tg->v((i + 0.5) * dx, j * dy, dx, dy);
+        sq += e * e;
+        r.linfU = std::max(r.linfU, std::abs(e));
+      }
+    r.l2U = std::sqrt(sq / static_cast<double>(f.u.A.size() + f.v.A.size()));
+
+    // Pressure: FLUID cells, up to the constant the solver leaves free.
+    std::vector<double> diff;
+    diff.reserve(f.p.A.size());
+    for (int j = 0; j < f.p.ny; ++j)
+      for (int i = 0; i < f.p.nx; ++i)
+        if (f.Label(i, j) == Fields2D::FLUID)
+          diff.push_back(f.p.Get(i, j) - tg->p((i + 0.5) * dx, (j + 0.5) * dy,
+                                               dx, dy, p.density));
+    double mean = 0.0;
+    for (const double d : diff)
+      mean += d;
+    mean /= static_cast<double>(std::max<std::size_t>(1, diff.size()));
+    sq = 0.0;
+    for (const double d : diff) {
+      sq += (d - mean) * (d - mean);
+      r.linfP = std::max(r.linfP, std::abs(d - mean));
+    }
+    r.l2P = std::sqrt(sq / static_cast<double>(
+                               std::max<std::size_t>(1, diff.size())));
+  } catch (const std::exception &e) {
+    r.error = e.what();
+  }
+  return r;
+}
+
+bool Convergence::Run() {
+  std::vector<Result> results;
+  bool ok = true;
+  for (const std::string &solver : solvers_)
+    for (const double tol : tolerances_)
+      for (const int n : sizes_) {
+        std::cout << "\r[Convergence] " << solver << ", tolerance " << tol
+                  << ", nx = " << n << "        " << std::flush;
+        results.push_back(measure(solver, tol, n));
+        ok &= results.back().error.empty();
+      }
+  std::cout << '\n';
+  report(results);
+  return ok;
+}
+
+// Report
+
+void Convergence::report(const std::vector<Result> &results) const {
+  std::filesystem::create_directories(base_.folder);
+  const std::string csvPath = base_.folder + "/convergence.csv";
+  std::ofstream csv(csvPath);
+  csv << "solver,tolerance,nx,ny,steps,wall_s,iterations,field_mb,"
+         "l2_velocity,linf_velocity,l2_pressure,linf_pressure,order,status\n";
+
+  std::cout << "[Convergence] t_end = " << base_.nt * base_.dt << ", "
+            << results.size() << " runs\n"
+            << std::left << std::setw(24) << "solver" << std::right
+            << std::setw(9) << "tol" << std::setw(7) << "nx" << std::setw(7)
+            << "steps" << std::setw(10) << "wall[s]" << std::setw(10)
+            << "iters" << std::setw(9) << "mem[MB]" << std::setw(12)
+            << "L2(u)" << std::setw(12) << "Linf(u)" << std::setw(12)
+            << "L2(p)" << std::setw(7) << "order" << '\n';
+
+  const Result *best = nullptr;
+  for (std::size_t k = 0; k < results.size(); ++k) {
+    const Result &r = results[k];
+    // Observed order against the previous rung of the same combination.
+    double order = std::numeric_limits<double>::quiet_NaN();
+    if (k > 0) {
+      const Result &prev = results[k - 1];
+      if (prev.solver == r.solver && prev.tolerance == r.tolerance &&
+          prev.nx < r.nx && prev.error.empty() && r.error.empty() &&
+          r.l2U > 0.0 && prev.l2U > 0.0)
+        order = std::log(prev.l2U / r.l2U) /
+                std::log(static_cast<double>(r.nx) / prev.nx);
+    }
+
+    csv << r.solver << ',' << r.tolerance << ',' << r.nx << ',' << r.ny << ','
+        << r.steps << ',' << r.wall << ',' << r.iterations << ',' << r.fieldMb
+        << ',' << r.l2U << ',' << r.linfU << ',' << r.l2P << ',' << r.linfP
+        << ',' << (std::isnan(order) ? std::string() : std::to_string(order))
+        << ',' << (r.error.empty() ? "ok" : r.error) << '\n';
+
+    std::cout << std::left << std::setw(24) << r.solver << std::right
+              << std::setw(9) << std::setprecision(2) << r.tolerance
+              << std::setw(7) << r.nx << std::setw(7) << r.steps;
+    if (!r.error.empty()) {
+      std::cout << "  failed: " << r.error << '\n';
+      continue;
+    }
+    std::cout << std::setw(10) << std::setprecision(3) << r.wall
+              << std::setw(10) << r.iterations << std::setw(9)
+              << std::setprecision(4) << r.fieldMb << std::setw(12)
+              << std::setprecision(3) << r.l2U << std::setw(12) << r.linfU
+              << std::setw(12) << r.l2P << std::setw(7);
+    if (std::isnan(order))
+      std::cout << '-';
+    else
+      std::cout << std::fixed << std::setprecision(2) << order
+                << std::defaultfloat;
+    std::cout << '\n';
+
+    if (base_.convergence_target > 0.0 && r.l2U <= base_.convergence_target &&
+        (!best || r.wall < best->wall))
+      best = &r;
+  }
+
+  if (base_.convergence_target > 0.0) {
+    if (best)
+      std::cout << "[Convergence] Cheapest run with L2(u) <= "
+                << base_.convergence_target << ": " << best->solver
+                << ", tolerance " << best->tolerance << ", nx = " << best->nx
+                << " (" << best->wall << " s, L2(u) = " << best->l2U << ")\n";
+    else
+      std::cout << "[Convergence] No run reaches L2(u) <= "
+                << base_.convergence_target << '\n';
+  }
+  std::cout << "[Convergence] Written to " << csvPath << '\n';
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "../core/Parameters.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * @file Convergence.hpp
+ * @brief Accuracy-versus-cost driver (--convergence) for Taylor-Green
+ *        scenes.
+ */
+
+/**
+ * @brief Runs a Taylor-Green config on a ladder of resolutions for every
+ *        solver / tolerance combination and measures the error against
+ *        the analytic solution.
+ *
+ * ```
+ * PIC -c test/taylorgreen.json --convergence 32,64,128
+ *     [--solvers jacobi,gauss_seidel,red_black_gauss_seidel]
+ *     [--tolerances 1e-2,1e-4] [--target 1e-3]
+ * ```
+ * The config must set the initial velocity with a @c "taylor_green" object
+ * (see TaylorGreenObject); the runs always close the domain edges
+ * (@c walls). For each ladder entry N, @c nx = N and @c ny
+ * keeps the aspect ratio. dx, dy and dt shrink with the grid (fixed domain
+ * and CFL number) and @c nt grows, so every run ends at the same physical
+ * time @c nt·dt of the config. All file output is off. Solvers and
+ * tolerances default to the config's own.
+ *
+ * Reported per run: wall time of Run(), pressure iterations, the memory of
+ * its fields and labels, L2 (RMS) and L∞ error of the velocity over all u
+ * and v faces, the same for the pressure after removing its mean offset,
+ * and the observed order of the velocity L2 error against the previous
+ * rung. With @c --target, the cheapest run whose velocity L2 error meets
+ * it is named. Everything is written to @c \<folder\>/convergence.csv.
+ * Serial builds only.
+ */
+class Convergence {
+public:
+  /// @throws std::runtime_error if the config has no Taylor-Green velocity.
+  explicit Convergence(const Parameters &base);
+
+  /// @brief Run the ladder for every combination and report.
+  /// @return @c true if every run completed.
+  bool Run();
+
+private:
+  /// One run of the ladder.
+  struct Result {
+    std::string solver;
+    double tolerance = 0.0;
+    int nx = 0, ny = 0, steps = 0;
+    double wall = 0.0;          ///< Run() wall time (s).
+    long long iterations = 0;   ///< Pressure iterations, all steps.
+    double fieldMb = 0.0;       ///< Fields and labels of the run (MiB).
+    double l2U = 0.0, linfU = 0.0; ///< Velocity error, u and v faces.
+    double l2P = 0.0, linfP = 0.0; ///< Pressure error, mean removed.
+    std::string error;          ///< Exception message, or empty.
+  };
+
+  const Parameters &base_;
+  std::vector<int> sizes_;
+  std::vector<std::string> solvers_;
+  std::vector<double> tolerances_;
+
+  /// @brief Run @p solver at @p tolerance on an nx = @p n grid.
+  Result measure(const std::string &solver, double tolerance, int n) const;
+
+  /// @brief Print the table and the cheapest run, write convergence.csv.
+  void report(const std::vector<Result> &results) const;
+};
@@ -0,0 +1,198 @@
+#include "Ensemble.hpp"
+#include "../solvers/SemiLagrangian/SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+// Helpers
+
+static nlohmann::json readJson(const std::string &path) {
+  std::ifstream file(path);
+  if (!file.is_open())
+    throw std::runtime_error("[Ensemble] Could not open '" + path + "'");
+  nlohmann::json j;
+  file >> j;
+  return j;
+}
+
+// "nt" -> "/nt"; "/solid/cylinder/x" is kept as-is.
+static nlohmann::json::json_pointer toPointer(const std::string &key) {
+  return nlohmann::json::json_pointer(key.front() == '/' ? key : "/" + key);
+}
+
+// Quoted CSV field: embedded quotes are doubled, so commas, quotes and
+// newlines in exception messages or JSON stay inside one column.
+static std::string csvQuoted(const std::string &s) {
+  std::string out = "\"";
+  for (const char c : s)
+    out += (c == '"') ? std::string("\"\"") : std::string(1, c);
+  return out + '"';
+}
+
+// Construction
+
+Ensemble::Ensemble(const std::string &basePath, const std::string &sweepPath) {
+  const nlohmann::json base = readJson(basePath);
+  const nlohmann::json sweep = readJson(sweepPath);
+
+  if (sweep.contains("folder"))
+    folder_ = sweep["folder"].get<std::string>();
+  if (sweep.contains("small_cells"))
+    smallCells_ = sweep["small_cells"].get<long long>();
+  if (sweep.contains("threads_per_member"))
+    threadsPerMember_ = std::max(1, sweep["threads_per_member"].get<int>());
+
+  // Cartesian product of all "parameters" lists, last key varying fastest.
+  if (sweep.contains("parameters")) {
+    const nlohmann::json &axes = sweep["parameters"];
+    std::vector<nlohmann::json> combos = {nlohmann::json::object()};
+    for (auto it = axes.begin(); it != axes.end(); ++it) {
+      const nlohmann::json values =
+          it.value().is_array() ? it.value() : nlohmann::json::array({it.value()});
+      std::vector<nlohmann::json> next;
+      for (const auto &c : combos)
+        for (const auto &v : values) {
+          nlohmann::json e = c;
+          e[it.key()] = v;
+          next.push_back(std::move(e));
+        }
+      combos = std::move(next);
+    }
+    for (const auto &c : combos)
+      addMember(base, c);
+  }
+
+  if (sweep.contains("members"))
+    for (const auto &m : sweep["members"])
+      addMember(base, m);
+
+  if (members_.empty())
+    throw std::runtime_error("[Ensemble] Sweep defines no members");
+}
+
+void Ensemble::addMember(const nlohmann::json &base,
+                         const nlohmann::json &overrides) {
+  nlohmann::json j = base;
+  for (auto it = overrides.begin(); it != overrides.end(); ++it)
+    j[toPointer(it.key())] = it.value();
+
+  Member m;
+  m.overrides = overrides;
+  m.params.loadFromJson(j);
+  m.params.quiet = true;
+
+  std::ostringstream dir;
+  dir << folder_ << "/member_" << std::setw(4) << std::setfill('0')
+      << members_.size();
+  m.params.folder = dir.str();
+
+  members_.push_back(std::move(m));
+}
+
+// Execution
+
+void Ensemble::runMember(Member &m) {
+  try {
+    SemiLagrangian solver(m.params);
+    const double start = GET_TIME();
+    solver.Run();
+    m.wallTime = GET_TIME() - start;
+
+    const Fields2D &f = solver.GetFields();
+    double maxDiv = 0.0;
+    for (const varType d : f.div.A)
+      maxDiv = std::max(maxDiv, std::abs(static_cast<double>(d)));
+    m.maxDiv = maxDiv;
+  } catch (const std::exception &e) {
+    m.error = e.what();
+  }
+}
+
+bool Ensemble::Run() {
+  const int maxThreads = omp_get_max_threads();
+
+  std::vector<std::size_t> small, large;
+  for (std::size_t k = 0; k < members_.size(); ++k) {
+    const Parameters &p = members_[k].params;
+    (static_cast<long long>(p.nx) * p.ny < smallCells_ ? small : large)
+        .push_back(k);
+  }
+
+  std::cout << "[Ensemble] " << members_.size() << " members: " << small.size()
+            << " concurrent, " << large.size() << " sequential, "
+            << maxThreads << " threads\n";
+
+  const double start = GET_TIME();
+  std::size_t done = 0;
+
+  // Small members: one member per team, teams of threadsPerMember_ threads.
+  // The solver's own `omp parallel for` loops become nested regions.
+  if (!small.empty()) {
+    const int teams = std::max(1, maxThreads / threadsPerMember_);
+    omp_set_max_active_levels(2);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(teams)
+    for (std::size_t s = 0; s < small.size(); ++s) {
+      omp_set_num_threads(threadsPerMember_);
+      Member &m = members_[small[s]];
+      runMember(m);
+#pragma omp critical(ensemble_report)
+      std::cout << "\r[Ensemble] " << ++done << " / " << members_.size()
+                << " done" << std::flush;
+    }
+    omp_set_num_threads(maxThreads);
+  }
+
+  // Large members: one at a time, each with the whole machine.
+  for (const std::size_t k : large) {
+    runMember(members_[k]);
+    std::cout << "\r[Ensemble] " << ++done << " / " << members_.size()
+              << " done" << std::flush;
+  }
+
+  std::cout << "\n[Ensemble] Total: " << (GET_TIME() - start) << " s\n";
+  writeSummary();
+
+  return std::none_of(members_.begin(), members_.end(),
+                      [](const Member &m) { return !m.error.empty(); });
+}
+
+// Summary
+
+void Ensemble::writeSummary() const {
+  fs::create_directories(folder_);
+  std::ofstream csv(folder_ + "/summary.csv");
+  csv << "member,folder,nx,ny,nt,wall_s,cell_updates_per_s,max_div,status,"
+         "overrides\n";
+
+  std::cout << std::left << std::setw(8) << "member" << std::setw(12)
+            << "grid" << std::setw(10) << "wall[s]" << std::setw(14)
+            << "Mcell/s" << std::setw(14) << "max|div|"
+            << "overrides\n";
+
+  for (std::size_t k = 0; k < members_.size(); ++k) {
+    const Member &m = members_[k];
+    const Parameters &p = m.params;
+    const double updates = static_cast<double>(p.nx) * p.ny * p.nt;
+    const double rate = m.wallTime > 0.0 ? updates / m.wallTime : 0.0;
+    const std::string status = m.error.empty() ? "ok" : m.error;
+    const std::string ov = m.overrides.dump();
+
+    std::ostringstream grid;
+    grid << p.nx << 'x' << p.ny;
+    std::cout << std::left << std::setw(8) << k << std::setw(12) << grid.str()
+              << std::setw(10) << std::setprecision(4) << m.wallTime
+              << std::setw(14) << rate * 1e-6 << std::setw(14) << m.maxDiv
+              << ov << (m.error.empty() ? "" : "  [" + m.error + "]") << '\n';
+
+    csv << k << ',' << p.folder << ',' << p.nx << ',' << p.ny << ',' << p.nt
+        << ',' << m.wallTime << ',' << rate << ',' << m.maxDiv << ','
+        << csvQuoted(status) << ',' << csvQuoted(ov) << '\n';
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "../core/Parameters.hpp"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @file Ensemble.hpp
+ * @brief Parameter-sweep driver running many SemiLagrangian instances in one
+ *        process.
+ */
+
+/**
+ * @brief Runs a base configuration under a list of JSON overrides.
+ *
+ * The base config is parsed once; each member is a copy of it with a few
+ * values replaced, addressed by JSON pointer (e.g. @c "/solid/cylinder/x").
+ * Plain keys without a leading slash address top-level entries.
+ *
+ * ### Sweep specification
+ * @code
+ * {
+ *   "folder": "ensemble",           // members write to <folder>/member_NNNN
+ *   "small_cells": 250000,          // nx*ny threshold for concurrent runs
+ *   "threads_per_member": 1,        // OpenMP team size of a small member
+ *   "parameters": {                 // Cartesian product of value lists
+ *     "/velocityu/rectangle/val": [0.5, 1.0, 2.0],
+ *     "/solid/cylinder/x": [80, 100]
+ *   },
+ *   "members": [ { "nt": 50 } ]     // extra explicit members (optional)
+ * }
+ * @endcode
+ *
+ * ### Scheduling
+ * Members with fewer than @c small_cells cells run concurrently, one per
+ * OpenMP team of @c threads_per_member threads (nested parallelism); larger
+ * members then run one after another with all threads.
+ *
+ * A summary table is printed and written to @c <folder>/summary.csv.
+ */
+class Ensemble {
+public:
+  /**
+   * @brief Expand the sweep specification against the base config.
+   * @param basePath  Base JSON config.
+   * @param sweepPath Sweep specification.
+   * @throws std::runtime_error if either file cannot be read or parsed.
+   */
+  Ensemble(const std::string &basePath, const std::string &sweepPath);
+
+  /// @brief Run all members and write the summary.
+  /// @return @c true if every member completed.
+  bool Run();
+
+private:
+  /// One expanded member of the sweep.
+  struct Member {
+    nlohmann::json overrides; ///< Pointer → value pairs applied to the base.
+    Parameters params;        ///< Fully resolved parameters.
+    double wallTime = 0.0;    ///< Run() wall time (s).
+    double maxDiv = 0.0;      ///< Final max |div u| over the grid.
+    std::string error;        ///< Exception message, empty on success.
+  };
+
+  std::string folder_ = "ensemble";
+  long long smallCells_ = 250000;
+  int threadsPerMember_ = 1;
+  std::vector<Member> members_;
+
+  /// @brief Build one member from the base config and its overrides.
+  void addMember(const nlohmann::json &base, const nlohmann::json &overrides);
+
+  /// @brief Construct and run one member with the current thread count.
+  static void runMember(Member &m);
+
+  /// @brief Print the summary table and write summary.csv.
+  void writeSummary() const;
+};
@@ -0,0 +1,235 @@
+#include "Scaling.hpp"
+#include "../solvers/SemiLagrangian/SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+/// Report order of the columns; phases a run never entered are left out.
+/// project/iter is a per-sweep time, compared like the phases.
+const char *const kColumns[] = {"run",          "step",   "sources",
+                                "project",      "project/iter", "advect",
+                                "advect_smoke", "diagnostics",  "amr",
+                                "output"};
+
+constexpr int kWidth = 14; ///< Width of a table column.
+
+} // namespace
+
+// Construction
+
+Scaling::Scaling(const Parameters &base)
+    : base_(base), threads_(base.scaling_threads),
+      steps_(std::max(1, base.scaling_steps)) {
+  if (threads_.empty()) {
+    int maxThreads = 1;
+#ifdef _OPENMP
+    maxThreads = omp_get_max_threads();
+#endif
+    for (int t = 1; t < maxThreads; t *= 2)
+      threads_.push_back(t);
+    threads_.push_back(maxThreads);
+  }
+  for (int &t : threads_)
+    t = std::max(1, t);
+  std::sort(threads_.begin(), threads_.end());
+  threads_.erase(std::unique(threads_.begin(), threads_.end()),
+                 threads_.end());
+}
+
+// Execution
+
+Scaling::Point Scaling::measure(int threads, int nx, int ny) const {
+  Point pt;
+  pt.threads = threads;
+  pt.nx = nx;
+  pt.ny = ny;
+
+  // The config as given, minus everything that is not compute.
+  Parameters p = base_;
+  p.nx = nx;
+  p.ny = ny;
+  p.nt = steps_;
+  p.quiet = true;
+  p.restart.clear();
+  p.folder = base_.folder + "/scaling";
+  p.write_u = p.write_v = p.write_p = false;
+  p.write_div = p.write_norm_velocity = p.write_smoke = false;
+  p.output.views.clear();
+  p.render.clear();
+  p.checkpoint.every = 0;
+  p.statistics.enabled = false;
+  p.monitors.enabled = false;
+  p.profile.enabled = false;
+  p.solver.log = false;
+
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+  try {
+    SemiLagrangian solver(p);
+    const double start = GET_TIME();
+    solver.Run();
+    pt.seconds["run"] = (GET_TIME() - start) / steps_;
+
+    const nlohmann::json report = solver.GetProfiler().report(
+        static_cast<std::int64_t>(nx) * ny, 0);
+    for (const auto &[name, phase] : report["phases"].items())
+      pt.seconds[name] = phase["total_s"].get<double>() / steps_;
+    const double iterations =
+        solver.GetPressureTelemetry().summary()["iterations"]["total"]
+            .get<double>();
+    if (iterations > 0.0 && pt.seconds.count("project"))
+      pt.seconds["project/iter"] =
+          pt.seconds["project"] * steps_ / iterations;
+  } catch (const std::exception &e) {
+    pt.error = e.what();
+  }
+  return pt;
+}
+
+bool Scaling::Run() {
+  int maxThreads = 1;
+#ifdef _OPENMP
+  maxThreads = omp_get_max_threads();
+#endif
+  const bool strong = base_.scaling != "weak";
+  const bool weak = base_.scaling != "strong";
+
+  std::filesystem::create_directories(base_.folder);
+  const std::string csvPath = base_.folder + "/scaling.csv";
+  std::ofstream csv(csvPath);
+  csv << "mode,threads,nx,ny,phase,seconds_per_step,speedup,efficiency\n";
+
+  bool ok = true;
+  auto sweep = [&](const std::string &mode) {
+    std::vector<Point> points;
+    for (const int t : threads_) {
+      const double grow = mode == "weak" ? std::sqrt(static_cast<double>(t))
+                                         : 1.0;
+      const int nx = static_cast<int>(std::lround(base_.nx * grow));
+      const int ny = static_cast<int>(std::lround(base_.ny * grow));
+      std::cout << "\r[Scaling] " << mode << ": " << t << " thread(s), "
+                << nx << " x " << ny << "        " << std::flush;
+      points.push_back(measure(t, nx, ny));
+      ok &= points.back().error.empty();
+    }
+    std::cout << '\n';
+    printTables(mode, points);
+    writeRows(csv, mode, points);
+  };
+  if (strong)
+    sweep("strong");
+  if (weak)
+    sweep("weak");
+
+#ifdef _OPENMP
+  omp_set_num_threads(maxThreads);
+#endif
+  std::cout << "[Scaling] Written to " << csvPath << '\n';
+  return ok;
+}
+
+// Report
+
+void Scaling::printTables(const std::string &mode,
+                          const std::vector<Point> &points) const {
+  const bool weak = mode == "weak";
+  std::cout << "\n[Scaling] " << mode << ": " << base_.nx << " x "
+            << base_.ny << (weak ? " at 1 thread, sqrt(p) per side" : "")
+            << ", " << steps_ << " steps\n";
+  for (const Point &pt : points)
+    if (!pt.error.empty())
+      std::cout << "  " << pt.threads << " thread(s) failed: " << pt.error
+                << '\n';
+
+  const Point &ref = points.front();
+  // Phases below 0.5 % of the run are timer noise here.
+  std::vector<std::string> columns;
+  for (const char *c : kColumns)
+    if (ref.error.empty() && ref.seconds.count(c) &&
+        (ref.seconds.at(c) > 0.005 * ref.seconds.at("run") ||
+         std::string(c) == "project/iter"))
+      columns.emplace_back(c);
+  if (columns.empty())
+    return;
+
+  // value(point, column) -> cell text
+  auto table = [&](const char *title, auto value) {
+    std::cout << title << '\n'
+              << std::setw(8) << "threads" << std::setw(12) << "grid";
+    for (const std::string &c : columns)
+      std::cout << std::setw(kWidth) << c;
+    std::cout << '\n';
+    for (const Point &pt : points) {
+      std::ostringstream grid;
+      grid << pt.nx << 'x' << pt.ny;
+      std::cout << std::setw(8) << pt.threads << std::setw(12) << grid.str();
+      for (const std::string &c : columns) {
+        std::ostringstream cell;
+        if (pt.error.empty() && pt.seconds.count(c))
+          cell << std::fixed << std::setprecision(2) << value(pt, c);
+        else
+          cell << '-';
+        std::cout << std::setw(kWidth) << cell.str();
+      }
+      std::cout << '\n';
+    }
+  };
+  auto speedup = [&](const Point &pt, const std::string &c) {
+    const double s = ref.seconds.at(c) / pt.seconds.at(c);
+    return weak ? s * pt.threads / ref.threads : s; // scaled for weak
+  };
+  auto efficiency = [&](const Point &pt, const std::string &c) {
+    return 100.0 * speedup(pt, c) * ref.threads / pt.threads;
+  };
+
+  table("time per step [ms]", [](const Point &pt, const std::string &c) {
+    return 1e3 * pt.seconds.at(c);
+  });
+  table(weak ? "scaled speedup" : "speedup", speedup);
+  table("parallel efficiency [%]", efficiency);
+
+  // Karp-Flatt: the serial fraction e = (1/S - 1/p) / (1 - 1/p) that
+  // explains the measured strong-scaling speedup S on p threads.
+  const Point &last = points.back();
+  const double p = static_cast<double>(last.threads) / ref.threads;
+  if (weak || p <= 1.0 || !last.error.empty())
+    return;
+  std::cout << "serial fraction (Karp-Flatt, " << last.threads
+            << " threads):";
+  for (const std::string &c : columns)
+    if (last.seconds.count(c))
+      std::cout << ' ' << c << ' ' << std::fixed << std::setprecision(3)
+                << (1.0 / speedup(last, c) - 1.0 / p) / (1.0 - 1.0 / p);
+  std::cout << std::defaultfloat << '\n';
+}
+
+void Scaling::writeRows(std::ostream &csv, const std::string &mode,
+                        const std::vector<Point> &points) const {
+  const Point &ref = points.front();
+  for (const Point &pt : points) {
+    if (!pt.error.empty())
+      continue;
+    for (const auto &[phase, seconds] : pt.seconds) {
+      double speedup = 0.0;
+      if (ref.error.empty() && ref.seconds.count(phase) && seconds > 0.0) {
+        speedup = ref.seconds.at(phase) / seconds;
+        if (mode == "weak")
+          speedup *= static_cast<double>(pt.threads) / ref.threads;
+      }
+      csv << mode << ',' << pt.threads << ',' << pt.nx << ',' << pt.ny << ','
+          << phase << ',' << seconds << ',' << speedup << ','
+          << speedup * ref.threads / pt.threads << '\n';
+    }
+  }
+}
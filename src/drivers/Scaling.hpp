@@ -0,0 +1,71 @@
+#pragma once
+#include "../core/Parameters.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @file Scaling.hpp
+ * @brief Thread-scaling benchmark driver (--scaling).
+ */
+
+/**
+ * @brief Runs one config at increasing OpenMP thread counts and reports
+ *        per-phase speedup and parallel efficiency.
+ *
+ * ```
+ * PIC -c config.json --scaling strong|weak|both [--threads 1,2,4] [--steps 20]
+ * ```
+ * Every run is the config for @c --steps steps with all file output,
+ * statistics, monitors and the solver log switched off. Thread counts
+ * default to 1, 2, 4, ... up to @c omp_get_max_threads() (which is always
+ * included).
+ *
+ * - **strong**: the grid stays fixed. Speedup is T(1) / T(p) and the
+ *   efficiency is speedup / p.
+ * - **weak**: @c nx and @c ny both grow by sqrt(p), keeping the cells per
+ *   thread constant (dx, dt and the scene expressions are unchanged, so the
+ *   domain grows). The efficiency is T(1) / T(p). Pressure iterations grow
+ *   with the grid, so @c project/iter (time per sweep) is also reported.
+ *
+ * Times are per step and come from the Profiler phases (@c run, the whole
+ * Run(), is always measured). For each phase the Karp-Flatt serial
+ * fraction at the largest thread count is printed as well. The tables are
+ * also written to @c \<folder\>/scaling.csv. Serial builds only.
+ */
+class Scaling {
+public:
+  /**
+   * @param base    Parsed config; @c scaling, @c scaling_threads and
+   *                @c scaling_steps select the runs.
+   */
+  explicit Scaling(const Parameters &base);
+
+  /// @brief Run every mode and thread count, print the tables, write CSV.
+  /// @return @c true if every run completed.
+  bool Run();
+
+private:
+  /// One measured run.
+  struct Point {
+    int threads = 1;
+    int nx = 0, ny = 0;
+    std::map<std::string, double> seconds; ///< Per step, by phase.
+    std::string error;                     ///< Exception message, or empty.
+  };
+
+  const Parameters &base_;
+  std::vector<int> threads_;
+  int steps_;
+
+  /// @brief Run the config once on @p threads threads on an nx × ny grid.
+  Point measure(int threads, int nx, int ny) const;
+
+  /// @brief Print the time / speedup / efficiency tables of one mode.
+  void printTables(const std::string &mode,
+                   const std::vector<Point> &points) const;
+
+  /// @brief Append the rows of one mode to @p csv.
+  void writeRows(std::ostream &csv, const std::string &mode,
+                 const std::vector<Point> &points) const;
+};
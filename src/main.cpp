@@ -1,27 +1,107 @@
 #include "core/Parameters.hpp"
+#include "drivers/Convergence.hpp"
+#include "drivers/Ensemble.hpp"
+#include "drivers/Scaling.hpp"
 #include "solvers/SemiLagrangian/SemiLagrangian.hpp"
 #include <iostream>
 
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
 int main(int argc, char *argv[]) {
+  int rank = 0;
+#ifdef USE_MPI
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+
 #ifndef NDEBUG
-  std::cout << "Compiled with debug mode" << std::endl;
+  if (rank == 0)
+    std::cout << "Compiled with debug mode" << std::endl;
 #endif
 
   // Parse parameters from command line
   Parameters params;
   if (!params.parseCommandLine(argc, argv)) {
+#ifdef USE_MPI
+    MPI_Finalize();
+#endif
     return 1;
   }
 
 #ifndef NDEBUG
   // Display parameters
-  std::cout << params << std::endl;
+  if (rank == 0)
+    std::cout << params << std::endl;
 #endif
 
-  // Create and run solver
-  SemiLagrangian solver(params);
-  solver.Run();
+  // Parameter sweep: many solver instances in this process.
+  if (!params.ensemble.empty()) {
+#ifdef USE_MPI
+    if (rank == 0)
+      std::cerr << "--ensemble is not supported by PIC_MPI\n";
+    MPI_Finalize();
+    return 1;
+#else
+    try {
+      Ensemble ensemble(params.config_path, params.ensemble);
+      return ensemble.Run() ? 0 : 1;
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << '\n';
+      return 1;
+    }
+#endif
+  }
 
-  std::cout << "Simulation completed successfully!" << std::endl;
+  // Thread-scaling benchmark: the config at several thread counts.
+  if (!params.scaling.empty()) {
+#ifdef USE_MPI
+    if (rank == 0)
+      std::cerr << "--scaling is not supported by PIC_MPI\n";
+    MPI_Finalize();
+    return 1;
+#else
+    Scaling scaling(params);
+    return scaling.Run() ? 0 : 1;
+#endif
+  }
+
+  // Accuracy-versus-cost study against the analytic Taylor-Green vortex.
+  if (!params.convergence.empty()) {
+#ifdef USE_MPI
+    if (rank == 0)
+      std::cerr << "--convergence is not supported by PIC_MPI\n";
+    MPI_Finalize();
+    return 1;
+#else
+    try {
+      Convergence convergence(params);
+      return convergence.Run() ? 0 : 1;
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << '\n';
+      return 1;
+    }
+#endif
+  }
+
+  // Create and run solver. Scoped so that the solver (and its MPI
+  // communicator) is destroyed before MPI_Finalize.
+  try {
+    SemiLagrangian solver(params);
+    solver.Run();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+#ifdef USE_MPI
+    MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
+    return 1;
+  }
+
+  if (rank == 0)
+    std::cout << "Simulation completed successfully!" << std::endl;
+#ifdef USE_MPI
+  MPI_Finalize();
+#endif
   return 0;
 }
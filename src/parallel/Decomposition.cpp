@@ -0,0 +1,173 @@
+#include "Decomposition.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// MPI datatype matching the simulation precision.
+static MPI_Datatype mpiVarType() {
+#ifdef USE_FLOAT
+  return MPI_FLOAT;
+#else
+  return MPI_DOUBLE;
+#endif
+}
+
+// Split n cells into p contiguous parts; the first (n % p) parts get one
+// extra cell. Returns the start index of part k.
+static int blockStart(int n, int p, int k) {
+  return k * (n / p) + std::min(k, n % p);
+}
+
+Decomposition2D::Decomposition2D(int globalNx, int globalNy, int halo)
+    : globalNx(globalNx), globalNy(globalNy), halo(halo) {
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  // Let MPI pick a balanced process grid, then bias it so that the longer
+  // grid axis gets more blocks (keeps blocks close to square).
+  int dims[2] = {0, 0};
+  MPI_Dims_create(size, 2, dims);
+  if ((globalNx >= globalNy) != (dims[0] >= dims[1]))
+    std::swap(dims[0], dims[1]);
+
+  const int periods[2] = {0, 0};
+  MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 1, &cart_);
+  MPI_Comm_rank(cart_, &rank);
+
+  int coords[2];
+  MPI_Cart_coords(cart_, rank, 2, coords);
+  MPI_Cart_shift(cart_, 0, 1, &left_, &right_);
+  MPI_Cart_shift(cart_, 1, 1, &down_, &up_);
+
+  i0 = blockStart(globalNx, dims[0], coords[0]);
+  i1 = blockStart(globalNx, dims[0], coords[0] + 1);
+  j0 = blockStart(globalNy, dims[1], coords[1]);
+  j1 = blockStart(globalNy, dims[1], coords[1] + 1);
+
+  gl = (left_ != MPI_PROC_NULL) ? halo : 0;
+  gr = (right_ != MPI_PROC_NULL) ? halo : 0;
+  gb = (down_ != MPI_PROC_NULL) ? halo : 0;
+  gt = (up_ != MPI_PROC_NULL) ? halo : 0;
+
+  // A block must be at least as wide as the halo it sends to its neighbours.
+  if ((dims[0] > 1 && globalNx / dims[0] < halo) ||
+      (dims[1] > 1 && globalNy / dims[1] < halo)) {
+    if (rank == 0)
+      std::cerr << "[Decomposition2D] Blocks smaller than halo width " << halo
+                << " – use fewer ranks or a larger grid.\n";
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+  }
+}
+
+Decomposition2D::~Decomposition2D() {
+  if (cart_ != MPI_COMM_NULL)
+    MPI_Comm_free(&cart_);
+}
+
+std::array<int, 4> Decomposition2D::ownedRange(const Grid2D &g) const {
+  const int sx = g.nx - localNx();
+  const int sy = g.ny - localNy();
+  const int ie = gl + (i1 - i0) + (right_ == MPI_PROC_NULL ? sx : 0);
+  const int je = gb + (j1 - j0) + (up_ == MPI_PROC_NULL ? sy : 0);
+  return {gl, ie, gb, je};
+}
+
+// Ghost exchange
+//
+// For a grid with stagger s = g.nx - localNx() (u: +1, p: 0, smoke: -1) the
+// regions exchanged with each neighbour are:
+//
+//   send to left   : local cols [gl + max(s,0),  + H + min(s,0))
+//   recv from right: local cols [gl + own + max(s,0), + H + min(s,0))
+//   send to right  : local cols [gl + own - H, + H)
+//   recv from left : local cols [0, gl)
+//
+// A face shared by two blocks (s = +1) is owned by both, so it is never sent;
+// a cell-centred grid one column short (s = -1) simply has one fewer ghost
+// column on its right side.
+
+void Decomposition2D::exchangeX(Grid2D &g, int sx) const {
+  const int own = i1 - i0;
+  const int wLeft = halo + std::min(sx, 0); // width sent left / recv right
+  const int wRight = halo;                  // width sent right / recv left
+
+  MPI_Datatype colsL, colsR;
+  MPI_Type_vector(g.ny, std::max(wLeft, 1), g.nx, mpiVarType(), &colsL);
+  MPI_Type_vector(g.ny, std::max(wRight, 1), g.nx, mpiVarType(), &colsR);
+  MPI_Type_commit(&colsL);
+  MPI_Type_commit(&colsR);
+
+  varType *a = g.A.data();
+  const int sendL = gl + std::max(sx, 0);
+  const int recvR = gl + own + std::max(sx, 0);
+  const int sendR = gl + own - halo;
+
+  const int nL = (wLeft > 0) ? 1 : 0;
+  MPI_Sendrecv(a + sendL, left_ != MPI_PROC_NULL ? nL : 0, colsL, left_, 0,
+               a + recvR, right_ != MPI_PROC_NULL ? nL : 0, colsL, right_, 0,
+               cart_, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(a + std::max(sendR, 0), right_ != MPI_PROC_NULL ? 1 : 0, colsR,
+               right_, 1, a, left_ != MPI_PROC_NULL ? 1 : 0, colsR, left_, 1,
+               cart_, MPI_STATUS_IGNORE);
+
+  MPI_Type_free(&colsL);
+  MPI_Type_free(&colsR);
+}
+
+void Decomposition2D::exchangeY(Grid2D &g, int sy) const {
+  // Rows are contiguous in row-major storage: no derived datatype needed.
+  const int own = j1 - j0;
+  const int wDown = halo + std::min(sy, 0);
+  const int row = g.nx;
+
+  varType *a = g.A.data();
+  const int sendD = gb + std::max(sy, 0);
+  const int recvU = gb + own + std::max(sy, 0);
+  const int sendU = gb + own - halo;
+
+  MPI_Sendrecv(a + static_cast<std::size_t>(sendD) * row,
+               down_ != MPI_PROC_NULL ? wDown * row : 0, mpiVarType(), down_, 2,
+               a + static_cast<std::size_t>(recvU) * row,
+               up_ != MPI_PROC_NULL ? wDown * row : 0, mpiVarType(), up_, 2,
+               cart_, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(a + static_cast<std::size_t>(std::max(sendU, 0)) * row,
+               up_ != MPI_PROC_NULL ? halo * row : 0, mpiVarType(), up_, 3, a,
+               down_ != MPI_PROC_NULL ? halo * row : 0, mpiVarType(), down_, 3,
+               cart_, MPI_STATUS_IGNORE);
+}
+
+void Decomposition2D::exchange(Grid2D &g) const {
+  if (size == 1)
+    return;
+  exchangeX(g, g.nx - localNx());
+  exchangeY(g, g.ny - localNy());
+}
+
+// Reductions
+
+double Decomposition2D::allreduceSum(double v) const {
+  double out = 0.0;
+  MPI_Allreduce(&v, &out, 1, MPI_DOUBLE, MPI_SUM, cart_);
+  return out;
+}
+
+long long Decomposition2D::allreduceSum(long long v) const {
+  long long out = 0;
+  MPI_Allreduce(&v, &out, 1, MPI_LONG_LONG, MPI_SUM, cart_);
+  return out;
+}
+
+double Decomposition2D::allreduceMax(double v) const {
+  double out = 0.0;
+  MPI_Allreduce(&v, &out, 1, MPI_DOUBLE, MPI_MAX, cart_);
+  return out;
+}
+
+std::vector<std::array<int, 4>>
+Decomposition2D::gatherPieceExtents(const Grid2D &g) const {
+  const auto [ib, ie, jb, je] = ownedRange(g);
+  const std::array<int, 4> mine = {ib + originI(), ie + originI(),
+                                   jb + originJ(), je + originJ()};
+  std::vector<std::array<int, 4>> all(size);
+  MPI_Allgather(mine.data(), 4, MPI_INT, all.data(), 4, MPI_INT, cart_);
+  return all;
+}
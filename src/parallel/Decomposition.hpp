@@ -0,0 +1,109 @@
+#pragma once
+#include "../core/Grid2D.hpp"
+#include "../core/Precision.hpp"
+#include <mpi.h>
+#include <array>
+#include <vector>
+
+/**
+ * @file Decomposition.hpp
+ * @brief 2D block decomposition of the global grid over MPI ranks.
+ */
+
+/**
+ * @brief Splits the global nx × ny cell grid into a 2D Cartesian array of
+ *        blocks, one per MPI rank, and exchanges ghost layers between them.
+ *
+ * ### Local layout
+ * Each rank stores its owned block plus @c halo ghost cells on every side
+ * that touches another rank (physical domain boundaries get no ghosts):
+ * ```
+ *   local i :  0 .. gl-1 | gl .. gl+ownNx-1 | gl+ownNx .. gl+ownNx+gr-1
+ *              ghosts    |  owned cells     |  ghosts
+ * ```
+ * Local cell (i, j) maps to global cell (i + originI, j + originJ), so the
+ * local Fields2D can be treated as a small stand-alone domain by the solver.
+ *
+ * Staggered grids (u: nx+1 columns, smoke: nx-1 columns, ...) are handled by
+ * @c exchange(), which deduces the stagger from the grid size.
+ */
+class Decomposition2D {
+public:
+  /**
+   * @brief Build the Cartesian communicator and the local block extents.
+   * @param globalNx Global number of cells in x.
+   * @param globalNy Global number of cells in y.
+   * @param halo     Ghost-layer width in cells (must cover the RK2 departure
+   *                 distance plus the 2-point interpolation stencil).
+   */
+  Decomposition2D(int globalNx, int globalNy, int halo);
+  ~Decomposition2D();
+
+  Decomposition2D(const Decomposition2D &) = delete;
+  Decomposition2D &operator=(const Decomposition2D &) = delete;
+
+  int rank = 0; ///< Rank in the Cartesian communicator.
+  int size = 1; ///< Number of ranks.
+
+  int globalNx; ///< Global cells in x.
+  int globalNy; ///< Global cells in y.
+  int halo;     ///< Ghost-layer width between neighbouring blocks.
+
+  int i0, i1; ///< Owned global cell range in x: [i0, i1).
+  int j0, j1; ///< Owned global cell range in y: [j0, j1).
+  int gl, gr; ///< Ghost widths left / right (0 on a physical boundary).
+  int gb, gt; ///< Ghost widths bottom / top (0 on a physical boundary).
+
+  /// @return Local array width in cells (owned + ghosts).
+  [[nodiscard]] int localNx() const { return gl + (i1 - i0) + gr; }
+  /// @return Local array height in cells (owned + ghosts).
+  [[nodiscard]] int localNy() const { return gb + (j1 - j0) + gt; }
+
+  /// @return Global x-index of local cell 0.
+  [[nodiscard]] int originI() const { return i0 - gl; }
+  /// @return Global y-index of local cell 0.
+  [[nodiscard]] int originJ() const { return j0 - gb; }
+
+  /// @return @c true on rank 0 (the rank that prints and writes indices).
+  [[nodiscard]] bool isRoot() const { return rank == 0; }
+
+  /**
+   * @brief Local index range of the owned part of @p g, excluding ghosts.
+   *
+   * For staggered grids the rightmost / topmost rank owns the extra (or one
+   * fewer) face so that the pieces tile the global array exactly.
+   *
+   * @return {ib, ie, jb, je} as half-open local ranges.
+   */
+  [[nodiscard]] std::array<int, 4> ownedRange(const Grid2D &g) const;
+
+  /**
+   * @brief Fill the ghost layers of @p g with the neighbours' owned values.
+   *
+   * x-direction first, then y including the x-ghost columns, so corner
+   * ghosts are filled without diagonal messages.
+   */
+  void exchange(Grid2D &g) const;
+
+  /// @brief Global sum over all ranks.
+  [[nodiscard]] double allreduceSum(double v) const;
+  /// @brief Global sum over all ranks.
+  [[nodiscard]] long long allreduceSum(long long v) const;
+  /// @brief Global maximum over all ranks.
+  [[nodiscard]] double allreduceMax(double v) const;
+
+  /**
+   * @brief Gather every rank's owned range of @p g in global indices.
+   * @return On every rank: {gi0, gi1, gj0, gj1} per rank, ordered by rank.
+   */
+  [[nodiscard]] std::vector<std::array<int, 4>>
+  gatherPieceExtents(const Grid2D &g) const;
+
+private:
+  MPI_Comm cart_ = MPI_COMM_NULL;
+  int left_ = MPI_PROC_NULL, right_ = MPI_PROC_NULL;
+  int down_ = MPI_PROC_NULL, up_ = MPI_PROC_NULL;
+
+  void exchangeX(Grid2D &g, int sx) const;
+  void exchangeY(Grid2D &g, int sy) const;
+};
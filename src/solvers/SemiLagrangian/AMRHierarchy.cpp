@@ -0,0 +1,839 @@
+#include "AMRHierarchy.hpp"
+#include "SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+// Patch
+
+struct AMRHierarchy::Patch {
+  int level = 1;           ///< Refinement level (>= 1).
+  Patch *parent = nullptr; ///< Parent patch, nullptr for the base grid.
+  int bi0 = 0, bj0 = 0;    ///< Box origin in the parent's local cells.
+  int bnx = 0, bny = 0;    ///< Box size in parent cells.
+  int nxi = 0, nyi = 0;    ///< Interior size in fine cells.
+  int gi0 = 0, gj0 = 0;    ///< Level index of the first interior cell.
+  double dx = 0.0, dy = 0.0, dt = 0.0;
+
+  Parameters params; ///< Patch-local parameters (referenced by solver).
+  std::unique_ptr<SemiLagrangian> solver;
+
+  /// State before the current sub-step, for the time interpolation of the
+  /// children's rings (only kept while there is a finer level).
+  std::unique_ptr<Snapshot> old;
+
+  /// Sums of the fine faces on the box boundary over the sub-steps of one
+  /// parent step, one entry per parent face: west / east u faces (bny
+  /// each), south / north v faces (bnx each).
+  std::vector<double> fluxW, fluxE, fluxS, fluxN;
+
+  [[nodiscard]] Fields2D &F() const { return solver->GetFields(); }
+};
+
+struct AMRHierarchy::Snapshot {
+  Grid2D u, v, p, smoke;
+};
+
+// Helpers
+
+namespace {
+
+/// Physical placement of a level grid: lower-left corner of local cell
+/// (0, 0) and cell size.
+struct Geometry {
+  double x0, y0, dx, dy;
+};
+
+/// Bilinear sample of @p g at continuous index (fi, fj), clamped to the grid.
+varType sampleIndex(const Grid2D &g, double fi, double fj) {
+  fi = std::clamp(fi, 0.0, static_cast<double>(g.nx - 1));
+  fj = std::clamp(fj, 0.0, static_cast<double>(g.ny - 1));
+  const int i0 = std::min(static_cast<int>(fi), g.nx - 2);
+  const int j0 = std::min(static_cast<int>(fj), g.ny - 2);
+  const double fx = fi - i0;
+  const double fy = fj - j0;
+  return static_cast<varType>(
+      (1.0 - fy) * ((1.0 - fx) * g.Get(i0, j0) + fx * g.Get(i0 + 1, j0)) +
+      fy * ((1.0 - fx) * g.Get(i0, j0 + 1) + fx * g.Get(i0 + 1, j0 + 1)));
+}
+
+/// Does block [i0, i1) × [j0, j1) of @p f meet any refinement criterion?
+bool blockFlagged(const Fields2D &f, int i0, int i1, int j0, int j1,
+                  const AMRConfig &cfg) {
+  bool anyFluid = false;
+  for (int j = j0; j < j1 && !anyFluid; ++j)
+    for (int i = i0; i < i1; ++i)
+      if (f.Label(i, j) != Fields2D::SOLID) {
+        anyFluid = true;
+        break;
+      }
+  if (!anyFluid)
+    return false;
+
+  if (cfg.solidDistance > 0) {
+    const int d = cfg.solidDistance;
+    for (int j = std::max(j0 - d, 0); j < std::min(j1 + d, f.ny); ++j)
+      for (int i = std::max(i0 - d, 0); i < std::min(i1 + d, f.nx); ++i)
+        if (f.Label(i, j) == Fields2D::SOLID)
+          return true;
+  }
+
+  if (cfg.vorticity > 0.0) {
+    // Vorticity at cell corner (i·dx, j·dy) from the surrounding faces.
+    for (int j = std::max(j0, 1); j < j1; ++j)
+      for (int i = std::max(i0, 1); i < i1; ++i) {
+        const double w = (f.v.Get(i, j) - f.v.Get(i - 1, j)) / f.dx -
+                         (f.u.Get(i, j) - f.u.Get(i, j - 1)) / f.dy;
+        if (std::abs(w) > cfg.vorticity)
+          return true;
+      }
+  }
+
+  if (cfg.smokeGradient > 0.0) {
+    const Grid2D &s = f.smokeMap;
+    for (int j = j0; j < std::min(j1, s.ny - 1); ++j)
+      for (int i = i0; i < std::min(i1, s.nx - 1); ++i) {
+        const double jump = std::abs(s.Get(i + 1, j) - s.Get(i, j)) +
+                            std::abs(s.Get(i, j + 1) - s.Get(i, j));
+        if (jump > cfg.smokeGradient)
+          return true;
+      }
+  }
+  return false;
+}
+
+/**
+ * @brief Red-black Gauss-Seidel for the sync correction @p e of @p f:
+ *        the pressure stencil of SemiLagrangian::getUpdate() with right-hand
+ *        side @p rhs, on FLUID cells only (everything else stays 0).
+ * @return Number of sweeps.
+ */
+int solveCorrection(const Fields2D &f, const Grid2D &rhs, Grid2D &e,
+                    int maxIters, double tol) {
+  const int nx = f.nx, ny = f.ny;
+  auto neighbours = [&](int i, int j, double &sum) {
+    int nb = 0;
+    sum = 0.0;
+    if (i + 1 < nx) { sum += e.Get(i + 1, j); ++nb; }
+    if (i - 1 >= 0) { sum += e.Get(i - 1, j); ++nb; }
+    if (j + 1 < ny) { sum += e.Get(i, j + 1); ++nb; }
+    if (j - 1 >= 0) { sum += e.Get(i, j - 1); ++nb; }
+    return nb;
+  };
+
+  double res0 = 0.0;
+  for (int it = 0; it < maxIters; ++it) {
+    for (int color = 0; color < 2; ++color) {
+#pragma omp parallel for schedule(static)
+      for (int j = 0; j < ny; ++j)
+        for (int i = (j + color) & 1; i < nx; i += 2) {
+          if (f.Label(i, j) != Fields2D::FLUID)
+            continue;
+          double sum;
+          const int nb = neighbours(i, j, sum);
+          e.Set(i, j, static_cast<varType>((rhs.Get(i, j) + sum) / nb));
+        }
+    }
+
+    double sumSq = 0.0;
+#pragma omp parallel for reduction(+ : sumSq) schedule(static)
+    for (int j = 0; j < ny; ++j)
+      for (int i = 0; i < nx; ++i) {
+        if (f.Label(i, j) != Fields2D::FLUID)
+          continue;
+        double sum;
+        const int nb = neighbours(i, j, sum);
+        const double r = rhs.Get(i, j) - (nb * e.Get(i, j) - sum);
+        sumSq += r * r;
+      }
+    const double res = std::sqrt(sumSq);
+    if (it == 0)
+      res0 = res;
+    if (res0 < 1e-30 || res / res0 < tol)
+      return it + 1;
+  }
+  return maxIters;
+}
+
+} // namespace
+
+// Construction
+
+AMRHierarchy::AMRHierarchy(const Parameters &params, Fields2D &base,
+                           const SceneSources *sources)
+    : params(params), cfg(params.amr), base(base) {
+
+  // In source mode the scene is re-applied to the base grid every step;
+  // impose the same values on the patches covering it.
+  if (sources)
+    for (int field = 0; field < SceneSources::NUM_FIELDS; ++field)
+      for (const SceneSources::Span &s :
+           sources->spans(static_cast<SceneSources::Field>(field)))
+        for (int i = s.i0; i < s.i1; ++i)
+          sources_.push_back(
+              {field, i, s.j, sources->values()[s.first + (i - s.i0)]});
+
+  // Level snapshots are .vthb collections; the series container only
+  // holds whole grids, so AMR output always goes to .vti files.
+  WriterOptions options = params.output.writer;
+  options.series = false;
+  if (params.write_p)
+    pWriter = std::make_unique<OutputWriter>(
+        params.folder, "p_amr", options);
+  if (params.write_div)
+    divWriter = std::make_unique<OutputWriter>(
+        params.folder, "div_amr", options);
+  if (params.write_norm_velocity)
+    normVelocityWriter =
+        std::make_unique<OutputWriter>(params.folder, "normVelocity_amr",
+                                       options);
+  if (params.write_smoke)
+    smokeWriter = std::make_unique<OutputWriter>(
+        params.folder, "smoke_amr", options);
+
+  regrid();
+}
+
+AMRHierarchy::~AMRHierarchy() = default;
+
+Fields2D &AMRHierarchy::parentFields(const Patch &p) const {
+  return p.parent ? p.parent->F() : base;
+}
+
+// Regridding
+
+void AMRHierarchy::regrid() {
+  auto old = std::move(levels_);
+  levels_.clear();
+
+  for (int level = 1; level <= cfg.maxLevel; ++level) {
+    const auto *oldLevel =
+        (level <= static_cast<int>(old.size())) ? &old[level - 1] : nullptr;
+
+    std::vector<std::unique_ptr<Patch>> next;
+    if (level == 1)
+      createPatches(nullptr, level, next, oldLevel);
+    else
+      for (auto &parent : levels_[level - 2])
+        createPatches(parent.get(), level, next, oldLevel);
+
+    if (next.empty())
+      break;
+    levels_.push_back(std::move(next));
+  }
+}
+
+std::unique_ptr<AMRHierarchy::Patch>
+AMRHierarchy::makePatch(Patch *parent, int level, int bi0, int bj0, int bnx,
+                        int bny) {
+  const int g = cfg.ghost;
+  const int r = cfg.ratio;
+  auto p = std::make_unique<Patch>();
+  p->level = level;
+  p->parent = parent;
+  p->bi0 = bi0;
+  p->bj0 = bj0;
+  p->bnx = bnx;
+  p->bny = bny;
+  p->nxi = p->bnx * r;
+  p->nyi = p->bny * r;
+  p->gi0 = ((parent ? parent->gi0 - g : 0) + p->bi0) * r;
+  p->gj0 = ((parent ? parent->gj0 - g : 0) + p->bj0) * r;
+  p->dx = (parent ? parent->dx : params.dx) / r;
+  p->dy = (parent ? parent->dy : params.dy) / r;
+  p->dt = (parent ? parent->dt : params.dt) / r;
+
+  Parameters &pp = p->params;
+  pp.nx = p->nxi + 2 * g;
+  pp.ny = p->nyi + 2 * g;
+  pp.dx = p->dx;
+  pp.dy = p->dy;
+  pp.dt = p->dt;
+  pp.density = params.density;
+  pp.solver = params.solver;
+  pp.solver.log = false; // only the base grid writes the pressure log
+  pp.write_u = pp.write_v = pp.write_p = false;
+  pp.write_div = pp.write_norm_velocity = pp.write_smoke = false;
+  pp.quiet = true;
+  p->solver = std::make_unique<SemiLagrangian>(pp);
+  p->fluxW.assign(p->bny, 0.0);
+  p->fluxE.assign(p->bny, 0.0);
+  p->fluxS.assign(p->bnx, 0.0);
+  p->fluxN.assign(p->bnx, 0.0);
+
+  // A patch made while the levels advance joins them at the start of the
+  // parent step, like the old patches it replaces.
+  fillFromParent(*p, false, 0.0);
+  return p;
+}
+
+void AMRHierarchy::createPatches(
+    Patch *parent, int level, std::vector<std::unique_ptr<Patch>> &out,
+    const std::vector<std::unique_ptr<Patch>> *old) {
+  const Fields2D &pf = parent ? parent->F() : base;
+  const int g = cfg.ghost;
+  const int B = cfg.blockSize;
+
+  // Refinable region of the parent: its interior (never its ghost ring).
+  const int ib = parent ? g : 0;
+  const int jb = parent ? g : 0;
+  const int ie = parent ? g + parent->nxi : pf.nx;
+  const int je = parent ? g + parent->nyi : pf.ny;
+
+  const int nbx = (ie - ib + B - 1) / B;
+  const int nby = (je - jb + B - 1) / B;
+  std::vector<uint8_t> flag(static_cast<std::size_t>(nbx) * nby, 0);
+
+#pragma omp parallel for collapse(2) schedule(dynamic)
+  for (int bj = 0; bj < nby; ++bj)
+    for (int bi = 0; bi < nbx; ++bi)
+      flag[nbx * bj + bi] = blockFlagged(
+          pf, ib + bi * B, std::min(ib + (bi + 1) * B, ie), jb + bj * B,
+          std::min(jb + (bj + 1) * B, je), cfg);
+
+  // Merge runs of flagged blocks along each block row into one patch.
+  for (int bj = 0; bj < nby; ++bj) {
+    int bi = 0;
+    while (bi < nbx) {
+      if (!flag[nbx * bj + bi]) {
+        ++bi;
+        continue;
+      }
+      const int start = bi;
+      while (bi < nbx && flag[nbx * bj + bi])
+        ++bi;
+
+      const int i0 = ib + start * B;
+      const int j0 = jb + bj * B;
+      auto p = makePatch(parent, level, i0, j0, std::min(ib + bi * B, ie) - i0,
+                         std::min(jb + (bj + 1) * B, je) - j0);
+      if (old)
+        for (const auto &q : *old)
+          copyOverlap(*p, *q);
+      applySources(*p);
+
+      out.push_back(std::move(p));
+    }
+  }
+}
+
+// Coarse ↔ fine transfer
+
+template <class F>
+void AMRHierarchy::mapToParent(const Patch &p, int nx, int ny, double sx,
+                               double sy, double ox, double oy, F &&f) const {
+  const int g = cfg.ghost;
+  const Geometry pg =
+      p.parent ? Geometry{(p.parent->gi0 - g) * p.parent->dx,
+                          (p.parent->gj0 - g) * p.parent->dy, p.parent->dx,
+                          p.parent->dy}
+               : Geometry{0.0, 0.0, params.dx, params.dy};
+  const double x0 = (p.gi0 - g) * p.dx;
+  const double y0 = (p.gj0 - g) * p.dy;
+
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int j = 0; j < ny; ++j)
+    for (int i = 0; i < nx; ++i) {
+      const double x = x0 + (i + sx) * p.dx;
+      const double y = y0 + (j + sy) * p.dy;
+      f(i, j, (x - pg.x0) / pg.dx - ox, (y - pg.y0) / pg.dy - oy);
+    }
+}
+
+void AMRHierarchy::fillFromParent(Patch &p, bool ringOnly,
+                                  double alpha) const {
+  Fields2D &f = p.F();
+  const Fields2D &pf = parentFields(p);
+  const Snapshot *old = p.parent ? p.parent->old.get() : baseOld_.get();
+  if (alpha >= 1.0)
+    old = nullptr;
+  const int g = cfg.ghost;
+
+  // Interior test; staggered grids own one extra face on the far side.
+  auto interior = [&](int i, int j, int sx, int sy) {
+    return i >= g && i < g + p.nxi + sx && j >= g && j < g + p.nyi + sy;
+  };
+
+  // (ox, oy) = 0.5 where the parent samples sit at half-cell positions.
+  auto fill = [&](Grid2D &dst, const Grid2D &src, const Grid2D *src0,
+                  double sx, double sy, double ox, double oy, int extraX,
+                  int extraY) {
+    mapToParent(p, dst.nx, dst.ny, sx, sy, ox, oy,
+                [&](int i, int j, double fi, double fj) {
+                  if (ringOnly && interior(i, j, extraX, extraY))
+                    return;
+                  double val = sampleIndex(src, fi, fj);
+                  if (src0)
+                    val = alpha * val +
+                          (1.0 - alpha) * sampleIndex(*src0, fi, fj);
+                  dst.Set(i, j, static_cast<varType>(val));
+                });
+  };
+
+  fill(f.u, pf.u, old ? &old->u : nullptr, 0.0, 0.5, 0.0, 0.5, 1, 0);
+  fill(f.v, pf.v, old ? &old->v : nullptr, 0.5, 0.0, 0.5, 0.0, 0, 1);
+  fill(f.p, pf.p, old ? &old->p : nullptr, 0.5, 0.5, 0.5, 0.5, 0, 0);
+  fill(f.smokeMap, pf.smokeMap, old ? &old->smoke : nullptr, 0.5, 0.5, 0.5,
+       0.5, 0, 0);
+
+  if (ringOnly)
+    return;
+
+  // Labels: inject the parent cell containing each fine cell centre. Ring
+  // cells that are not solid become FIXED (Dirichlet pressure).
+  mapToParent(p, f.nx, f.ny, 0.5, 0.5, 0.0, 0.0,
+              [&](int i, int j, double fi, double fj) {
+                const int I = std::clamp(static_cast<int>(std::floor(fi)), 0,
+                                         pf.nx - 1);
+                const int J = std::clamp(static_cast<int>(std::floor(fj)), 0,
+                                         pf.ny - 1);
+                if (pf.Label(I, J) == Fields2D::SOLID)
+                  f.SetLabel(i, j, Fields2D::SOLID);
+                else
+                  f.SetLabel(i, j, interior(i, j, 0, 0) ? Fields2D::FLUID
+                                                        : Fields2D::FIXED);
+              });
+}
+
+void AMRHierarchy::snapshot(std::unique_ptr<Snapshot> &s, const Fields2D &f) {
+  if (!s) {
+    s = std::make_unique<Snapshot>(Snapshot{f.u, f.v, f.p, f.smokeMap});
+    return;
+  }
+  s->u = f.u;
+  s->v = f.v;
+  s->p = f.p;
+  s->smoke = f.smokeMap;
+}
+
+void AMRHierarchy::copyOverlap(Patch &dst, const Patch &src) {
+  // Fine grids of one level are globally aligned, so overlapping interiors
+  // map cell-to-cell through the level index.
+  const int i0 = std::max(dst.gi0, src.gi0);
+  const int i1 = std::min(dst.gi0 + dst.nxi, src.gi0 + src.nxi);
+  const int j0 = std::max(dst.gj0, src.gj0);
+  const int j1 = std::min(dst.gj0 + dst.nyi, src.gj0 + src.nyi);
+  if (i0 >= i1 || j0 >= j1)
+    return;
+
+  Fields2D &d = dst.F();
+  const Fields2D &s = src.F();
+  const int g = (dst.params.nx - dst.nxi) / 2; // same ghost width for both
+  const int di = g - dst.gi0, dj = g - dst.gj0;
+  const int si = g - src.gi0, sj = g - src.gj0;
+
+  auto copy = [&](Grid2D &dg, const Grid2D &sg, int ex, int ey) {
+    for (int j = j0; j < j1 + ey; ++j)
+      for (int i = i0; i < i1 + ex; ++i)
+        if (dg.InBounds(i + di, j + dj) && sg.InBounds(i + si, j + sj))
+          dg.Set(i + di, j + dj, sg.Get(i + si, j + sj));
+  };
+  copy(d.u, s.u, 1, 0);
+  copy(d.v, s.v, 0, 1);
+  copy(d.p, s.p, 0, 0);
+  copy(d.smokeMap, s.smokeMap, 0, 0);
+}
+
+void AMRHierarchy::restrictToParent(Patch &p) {
+  const Fields2D &f = p.F();
+  Fields2D &pf = parentFields(p);
+  const int g = cfg.ghost;
+  const int r = cfg.ratio;
+  const double inv2 = 1.0 / (r * r);
+  const double inv1 = 1.0 / r;
+
+  // Cells: average the r × r fine cells.
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int J = p.bj0; J < p.bj0 + p.bny; ++J)
+    for (int I = p.bi0; I < p.bi0 + p.bnx; ++I) {
+      if (pf.Label(I, J) == Fields2D::SOLID)
+        continue;
+      const int fi = g + (I - p.bi0) * r;
+      const int fj = g + (J - p.bj0) * r;
+      double sp = 0.0, ss = 0.0;
+      for (int b = 0; b < r; ++b)
+        for (int a = 0; a < r; ++a) {
+          sp += f.p.Get(fi + a, fj + b);
+          if (f.smokeMap.InBounds(fi + a, fj + b))
+            ss += f.smokeMap.Get(fi + a, fj + b);
+        }
+      pf.p.Set(I, J, static_cast<varType>(sp * inv2));
+      if (pf.smokeMap.InBounds(I, J))
+        pf.smokeMap.Set(I, J, static_cast<varType>(ss * inv2));
+    }
+
+  // Faces strictly inside the box: average the r fine faces on each one.
+  // Faces on the box boundary stay with the parent.
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int J = p.bj0; J < p.bj0 + p.bny; ++J)
+    for (int I = p.bi0 + 1; I < p.bi0 + p.bnx; ++I) {
+      const int fi = g + (I - p.bi0) * r;
+      const int fj = g + (J - p.bj0) * r;
+      double su = 0.0;
+      for (int b = 0; b < r; ++b)
+        su += f.u.Get(fi, fj + b);
+      pf.u.Set(I, J, static_cast<varType>(su * inv1));
+    }
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int J = p.bj0 + 1; J < p.bj0 + p.bny; ++J)
+    for (int I = p.bi0; I < p.bi0 + p.bnx; ++I) {
+      const int fi = g + (I - p.bi0) * r;
+      const int fj = g + (J - p.bj0) * r;
+      double sv = 0.0;
+      for (int a = 0; a < r; ++a)
+        sv += f.v.Get(fi + a, fj);
+      pf.v.Set(I, J, static_cast<varType>(sv * inv1));
+    }
+}
+
+// Synchronisation
+
+void AMRHierarchy::accumulateFlux(Patch &p) const {
+  const Fields2D &f = p.F();
+  const int g = cfg.ghost;
+  const int r = cfg.ratio;
+  for (int J = 0; J < p.bny; ++J)
+    for (int b = 0; b < r; ++b) {
+      p.fluxW[J] += f.u.Get(g, g + J * r + b);
+      p.fluxE[J] += f.u.Get(g + p.nxi, g + J * r + b);
+    }
+  for (int I = 0; I < p.bnx; ++I)
+    for (int a = 0; a < r; ++a) {
+      p.fluxS[I] += f.v.Get(g + I * r + a, g);
+      p.fluxN[I] += f.v.Get(g + I * r + a, g + p.nyi);
+    }
+}
+
+void AMRHierarchy::synchronise(int level) {
+  std::vector<Patch *> parents{nullptr};
+  if (level > 1) {
+    parents.clear();
+    for (const auto &q : levels_[level - 2])
+      parents.push_back(q.get());
+  }
+  for (Patch *parent : parents) {
+    std::vector<Patch *> children;
+    for (const auto &p : levels_[level - 1])
+      if (p->parent == parent)
+        children.push_back(p.get());
+    if (!children.empty())
+      synchroniseParent(parent, children);
+  }
+}
+
+void AMRHierarchy::synchroniseParent(Patch *parent,
+                                     const std::vector<Patch *> &children) {
+  Fields2D &pf = parent ? parent->F() : base;
+  const double dx = parent ? parent->dx : params.dx;
+  const double dy = parent ? parent->dy : params.dy;
+  const double dt = parent ? parent->dt : params.dt;
+  const int r = cfg.ratio;
+  const double inv = 1.0 / (r * r); // r fine faces × r sub-steps
+
+  // 1. Reflux: parent faces on a box boundary take the fine mean. Faces
+  //    shared by two patches get the mean of both; domain-edge and SOLID
+  //    faces are left alone, as in updateVelocities().
+  Grid2D du(pf.u.nx, pf.u.ny), dv(pf.v.nx, pf.v.ny);
+  Grid2D nu(pf.u.nx, pf.u.ny), nv(pf.v.nx, pf.v.ny);
+  auto solid = [&](int i, int j) {
+    return pf.Label(i, j) == Fields2D::SOLID;
+  };
+  for (const Patch *c : children) {
+    for (int J = 0; J < c->bny; ++J) {
+      const int j = c->bj0 + J;
+      for (const auto &[i, flux] : {std::pair{c->bi0, c->fluxW[J]},
+                                   std::pair{c->bi0 + c->bnx, c->fluxE[J]}}) {
+        if (i < 1 || i > pf.nx - 1 || solid(i - 1, j) || solid(i, j))
+          continue;
+        du.Set(i, j, du.Get(i, j) + static_cast<varType>(flux * inv) -
+                         pf.u.Get(i, j));
+        nu.Set(i, j, nu.Get(i, j) + 1);
+      }
+    }
+    for (int I = 0; I < c->bnx; ++I) {
+      const int i = c->bi0 + I;
+      for (const auto &[j, flux] : {std::pair{c->bj0, c->fluxS[I]},
+                                   std::pair{c->bj0 + c->bny, c->fluxN[I]}}) {
+        if (j < 1 || j > pf.ny - 1 || solid(i, j - 1) || solid(i, j))
+          continue;
+        dv.Set(i, j, dv.Get(i, j) + static_cast<varType>(flux * inv) -
+                         pf.v.Get(i, j));
+        nv.Set(i, j, nv.Get(i, j) + 1);
+      }
+    }
+  }
+  bool changed = false;
+  for (auto [d, n, g] : {std::tuple{&du, &nu, &pf.u}, {&dv, &nv, &pf.v}})
+    for (std::size_t k = 0; k < d->A.size(); ++k)
+      if (n->A[k] > 0) {
+        d->A[k] /= n->A[k];
+        g->A[k] += d->A[k];
+        changed |= d->A[k] != 0;
+      }
+  if (!changed)
+    return;
+
+  // 2. Sync projection of the divergence the refluxing put in, with the
+  //    scaling of SemiLagrangian::iteratePressure() / updateVelocities().
+  const double coef = params.density * dx * dx / dt;
+  Grid2D rhs(pf.nx, pf.ny), e(pf.nx, pf.ny);
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int j = 0; j < pf.ny; ++j)
+    for (int i = 0; i < pf.nx; ++i) {
+      const double div = (du.Get(i + 1, j) - du.Get(i, j)) / dx +
+                         (dv.Get(i, j + 1) - dv.Get(i, j)) / dy;
+      rhs.Set(i, j, static_cast<varType>(-coef * div));
+    }
+  solveCorrection(pf, rhs, e, params.solver.maxIters, params.solver.tolerance);
+
+  // 3. Correct the parent faces and pressure; keep the face corrections in
+  //    du / dv for the patches.
+  const double k = dt / (params.density * dx);
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int j = 0; j < pf.u.ny; ++j)
+    for (int i = 0; i < pf.u.nx; ++i) {
+      varType c = 0;
+      if (i >= 1 && i < pf.u.nx - 1 && !solid(i - 1, j) && !solid(i, j))
+        c = static_cast<varType>(-k * (e.Get(i, j) - e.Get(i - 1, j)));
+      pf.u.Set(i, j, pf.u.Get(i, j) + c);
+      du.Set(i, j, c);
+    }
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int j = 0; j < pf.v.ny; ++j)
+    for (int i = 0; i < pf.v.nx; ++i) {
+      varType c = 0;
+      if (j >= 1 && j < pf.v.ny - 1 && !solid(i, j - 1) && !solid(i, j))
+        c = static_cast<varType>(-k * (e.Get(i, j) - e.Get(i, j - 1)));
+      pf.v.Set(i, j, pf.v.Get(i, j) + c);
+      dv.Set(i, j, c);
+    }
+  for (std::size_t n = 0; n < pf.p.A.size(); ++n)
+    pf.p.A[n] += e.A[n];
+
+  // 4. The same correction on the fine faces that are not next to SOLID.
+  for (Patch *c : children) {
+    Fields2D &f = c->F();
+    mapToParent(*c, f.u.nx, f.u.ny, 0.0, 0.5, 0.0, 0.5,
+                [&](int i, int j, double fi, double fj) {
+                  if ((i > 0 && f.Label(i - 1, j) == Fields2D::SOLID) ||
+                      (i < f.nx && f.Label(i, j) == Fields2D::SOLID))
+                    return;
+                  f.u.Set(i, j, f.u.Get(i, j) + sampleIndex(du, fi, fj));
+                });
+    mapToParent(*c, f.v.nx, f.v.ny, 0.5, 0.0, 0.5, 0.0,
+                [&](int i, int j, double fi, double fj) {
+                  if ((j > 0 && f.Label(i, j - 1) == Fields2D::SOLID) ||
+                      (j < f.ny && f.Label(i, j) == Fields2D::SOLID))
+                    return;
+                  f.v.Set(i, j, f.v.Get(i, j) + sampleIndex(dv, fi, fj));
+                });
+  }
+}
+
+void AMRHierarchy::applySources(Patch &p) const {
+  if (sources_.empty())
+    return;
+
+  Fields2D &f = p.F();
+  const int g = cfg.ghost;
+  int R = 1; // refinement factor between the base grid and this level
+  for (int l = 0; l < p.level; ++l)
+    R *= cfg.ratio;
+  const int oi = g - p.gi0, oj = g - p.gj0;
+
+  for (const SourceEntry &s : sources_) {
+    // Fine indices covered by the base face / cell.
+    Grid2D &dst = (s.field == 0) ? f.u : (s.field == 1) ? f.v : f.smokeMap;
+    const varType val =
+        s.field == 2 ? s.val : static_cast<varType>(sourceScale_ * s.val);
+    const int ni = (s.field == 0) ? 1 : R;
+    const int nj = (s.field == 1) ? 1 : R;
+    for (int b = 0; b < nj; ++b)
+      for (int a = 0; a < ni; ++a) {
+        const int i = s.i * R + a + oi;
+        const int j = s.j * R + b + oj;
+        if (dst.InBounds(i, j))
+          dst.Set(i, j, val);
+      }
+  }
+}
+
+// Time stepping
+
+void AMRHierarchy::advanceLevel(int level) {
+  auto &patches = levels_[level - 1];
+  const bool finer = level < numLevels();
+  for (auto &p : patches)
+    for (auto *flux : {&p->fluxW, &p->fluxE, &p->fluxS, &p->fluxN})
+      std::fill(flux->begin(), flux->end(), 0.0);
+
+  for (int sub = 0; sub < cfg.ratio; ++sub) {
+    // Ring data at the start time of this sub-step.
+    const double alpha = static_cast<double>(sub) / cfg.ratio;
+    for (auto &p : patches) {
+      fillFromParent(*p, true, alpha);
+      applySources(*p);
+      if (finer)
+        snapshot(p->old, p->F());
+      p->solver->Step();
+      accumulateFlux(*p);
+    }
+    if (finer)
+      advanceLevel(level + 1);
+  }
+  for (auto &p : patches)
+    restrictToParent(*p);
+  synchronise(level);
+}
+
+void AMRHierarchy::BeginStep() { snapshot(baseOld_, base); }
+
+void AMRHierarchy::Advance(double sourceScale) {
+  sourceScale_ = sourceScale;
+  if (++steps_ % cfg.regridEvery == 0)
+    regrid();
+  if (!levels_.empty())
+    advanceLevel(1);
+}
+
+// Output
+
+void AMRHierarchy::WriteOutput() {
+  const int g = cfg.ghost;
+
+  // shrink = 1 for the (nx-1) × (ny-1) diagnostic grids.
+  auto write = [&](OutputWriter *writer, Grid2D Fields2D::*member,
+                   const std::string &id, int shrink) {
+    if (!writer)
+      return;
+    std::vector<OutputWriter::AMRBlock> blocks;
+    const Grid2D &bg = base.*member;
+    blocks.push_back({&bg, {0, bg.nx, 0, bg.ny}, 0,
+                      {0, base.nx - shrink, 0, base.ny - shrink},
+                      {params.dx, params.dy}});
+    for (const auto &level : levels_)
+      for (const auto &p : level) {
+        const Grid2D &pg = p->F().*member;
+        blocks.push_back({&pg,
+                          {g, g + p->nxi, g, g + p->nyi},
+                          p->level,
+                          {p->gi0, p->gi0 + p->nxi, p->gj0, p->gj0 + p->nyi},
+                          {p->dx, p->dy}});
+      }
+    writer->writeAMR(blocks, id);
+  };
+
+  write(pWriter.get(), &Fields2D::p, "p", 0);
+  write(divWriter.get(), &Fields2D::div, "div", 0);
+  write(normVelocityWriter.get(), &Fields2D::normVelocity, "normVelocity", 1);
+  write(smokeWriter.get(), &Fields2D::smokeMap, "smoke", 1);
+}
+
+std::vector<OutputWriter *> AMRHierarchy::writers() const {
+  std::vector<OutputWriter *> out;
+  for (const auto *w :
+       {&pWriter, &divWriter, &normVelocityWriter, &smokeWriter})
+    if (*w)
+      out.push_back(w->get());
+  return out;
+}
+
+// Checkpoints
+
+void AMRHierarchy::Save(Checkpoint::Info &info) const {
+  nlohmann::json &st = info.state["amr"];
+  st = {{"steps", steps_}, {"ratio", cfg.ratio}, {"ghost", cfg.ghost}};
+
+  // One row per patch: level, index of the parent in the level above (-1
+  // for the base grid) and the box in parent cells. Parents come first.
+  nlohmann::json patches = nlohmann::json::array();
+  std::vector<double> &data = info.arrays["amr"];
+  data.clear();
+  for (std::size_t l = 0; l < levels_.size(); ++l)
+    for (const auto &p : levels_[l]) {
+      int parent = -1;
+      if (l > 0)
+        for (std::size_t k = 0; k < levels_[l - 1].size(); ++k)
+          if (levels_[l - 1][k].get() == p->parent)
+            parent = static_cast<int>(k);
+      patches.push_back({p->level, parent, p->bi0, p->bj0, p->bnx, p->bny});
+
+      const Fields2D &f = p->F();
+      for (const Grid2D *g : {&f.u, &f.v, &f.p, &f.smokeMap})
+        data.insert(data.end(), g->A.begin(), g->A.end());
+    }
+  st["patches"] = std::move(patches);
+
+  for (const OutputWriter *w : writers()) {
+    const OutputWriter::State ws = w->state();
+    st["writers"][w->name()] = {
+        {"step", ws.step}, {"entries", ws.entries}, {"bytes", ws.bytes}};
+  }
+}
+
+void AMRHierarchy::Restore(const Checkpoint::Info &info) {
+  const auto array = info.arrays.find("amr");
+  if (!info.state.contains("amr") || array == info.arrays.end()) {
+    std::cerr << "[AMRHierarchy] Warning: the checkpoint holds no AMR "
+                 "patches, regridding from the restored base grid.\n";
+    regrid();
+    return;
+  }
+  const nlohmann::json &st = info.state["amr"];
+  if (st.value("ratio", 0) != cfg.ratio || st.value("ghost", 0) != cfg.ghost) {
+    std::cerr << "[AMRHierarchy] Warning: the checkpoint was written with "
+                 "another AMR ratio or ghost width, regridding from the "
+                 "restored base grid.\n";
+    regrid();
+    return;
+  }
+
+  levels_.clear();
+  const std::vector<double> &data = array->second;
+  std::size_t pos = 0;
+  for (const auto &row : st.value("patches", nlohmann::json::array())) {
+    const int level = row.at(0).get<int>();
+    const int parent = row.at(1).get<int>();
+    if (level < 1 || level > static_cast<int>(levels_.size()) + 1 ||
+        (level > 1 &&
+         (parent < 0 ||
+          parent >= static_cast<int>(levels_[level - 2].size()))))
+      throw std::runtime_error("[AMRHierarchy] Corrupt patch list in the "
+                               "checkpoint");
+    if (level > static_cast<int>(levels_.size()))
+      levels_.emplace_back();
+    Patch *par = level > 1 ? levels_[level - 2][parent].get() : nullptr;
+    auto p = makePatch(par, level, row.at(2).get<int>(), row.at(3).get<int>(),
+                       row.at(4).get<int>(), row.at(5).get<int>());
+
+    Fields2D &f = p->F();
+    for (Grid2D *g : {&f.u, &f.v, &f.p, &f.smokeMap}) {
+      if (data.size() - pos < g->A.size())
+        throw std::runtime_error("[AMRHierarchy] The checkpoint's AMR "
+                                 "array is too short");
+      std::transform(data.begin() + pos, data.begin() + pos + g->A.size(),
+                     g->A.begin(),
+                     [](double x) { return static_cast<varType>(x); });
+      pos += g->A.size();
+    }
+    levels_[level - 1].push_back(std::move(p));
+  }
+  if (pos != data.size())
+    throw std::runtime_error("[AMRHierarchy] The checkpoint's AMR array does "
+                             "not match its patch list");
+  steps_ = st.value("steps", 0);
+
+  const nlohmann::json saved = st.value("writers", nlohmann::json::object());
+  for (OutputWriter *w : writers()) {
+    if (!saved.contains(w->name()))
+      continue;
+    OutputWriter::State ws;
+    ws.step = saved[w->name()].value("step", 0);
+    ws.entries = saved[w->name()].value("entries", std::vector<std::string>());
+    ws.bytes = saved[w->name()].value("bytes", std::uint64_t(0));
+    w->restore(ws);
+  }
+}
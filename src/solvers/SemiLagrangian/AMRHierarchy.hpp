@@ -0,0 +1,213 @@
+#pragma once
+#include "../../core/Checkpoint.hpp"
+#include "../../core/Fields.hpp"
+#include "../../core/OutputWriter.hpp"
+#include "../../core/Parameters.hpp"
+#include "../../core/SceneSources.hpp"
+#include <memory>
+#include <vector>
+
+/**
+ * @file AMRHierarchy.hpp
+ * @brief Block-structured adaptive mesh refinement on top of the base grid.
+ */
+
+/**
+ * @brief Hierarchy of refined patches, each a uniform grid advanced by its
+ *        own SemiLagrangian solver.
+ *
+ * ### Structure
+ * Level 0 is the base grid owned by the calling solver. A level-@e l patch
+ * covers a box of its parent (level @e l-1) at @c ratio times the
+ * resolution, plus a ghost ring of @c ghost fine cells:
+ * ```
+ *   +-----------------------+   ghost ring: u, v, p, smoke interpolated
+ *   |  +-----------------+  |   from the parent every sub-step, in space
+ *   |  |                 |  |   and in time; labels are
+ *   |  |    interior     |  |   SOLID (parent solid) or FIXED, so the ring
+ *   |  |  (owned cells)  |  |   acts as a Dirichlet pressure boundary.
+ *   |  +-----------------+  |
+ *   +-----------------------+
+ * ```
+ * Departure points that leave the interior are interpolated from the ring,
+ * i.e. from parent data — this is the advection across level boundaries.
+ *
+ * ### Time stepping (Berger–Oliger)
+ * After the base step, each level takes @c ratio sub-steps of dt/ratio per
+ * parent step (recursively), then its interior is averaged back onto the
+ * parent (p, smoke, u and v faces). Sub-step @e s fills the ring from the
+ * parent state at its own start time, interpolated linearly between the
+ * parent before its step (BeginStep() for the base grid, a snapshot for a
+ * patch) and after it, with weight @e s / @c ratio.
+ *
+ * ### Synchronisation (refluxing + sync projection)
+ * Each fine pressure solve sees the parent only through its Dirichlet
+ * ring, so after the sub-steps the two levels disagree on the faces of the
+ * patch boundary. Once a level has been restricted, every parent
+ * - refluxes: each parent face on a patch boundary takes the mean of the
+ *   fine faces covering it, over the @c ratio sub-steps;
+ * - solves a correction Poisson equation for the divergence that the
+ *   refluxing put into the neighbouring parent cells (red-black
+ *   Gauss-Seidel, @c solver.max_iterations / @c solver.tolerance);
+ * - subtracts the correction gradient from its faces, adds the correction
+ *   to its pressure, and adds the interpolated face correction to the fine
+ *   faces of its patches, so both levels keep the same composite velocity.
+ *
+ * ### Regridding
+ * Every @c regrid_every steps, parent cells are flagged by vorticity,
+ * distance to SOLID and smoke jump; flagged @c block_size blocks are merged
+ * row-wise into patches. New patches are filled from the parent and then
+ * from any overlapping old patch of the same level.
+ *
+ * ### Output
+ * Cell-centred fields (p, div, normVelocity, smoke) are written as VTK
+ * overlapping-AMR snapshots (@c .vthb) through OutputWriter::writeAMR().
+ *
+ * ### Checkpoints
+ * Save() adds the patch boxes, the regrid counter and the output series to
+ * a checkpoint, and the patch fields as one @c "amr" array. Restore()
+ * rebuilds the same patches from it, so a restart continues exactly.
+ */
+class AMRHierarchy {
+public:
+  /**
+   * @brief Build the initial hierarchy over @p base.
+   * @param params Base simulation parameters (must outlive this object).
+   * @param base   Base-grid fields, already initialised from the scene.
+   * @param sources Compiled base-grid sources re-imposed on the patches,
+   *                or nullptr outside source mode.
+   */
+  AMRHierarchy(const Parameters &params, Fields2D &base,
+               const SceneSources *sources);
+  ~AMRHierarchy();
+
+  AMRHierarchy(const AMRHierarchy &) = delete;
+  AMRHierarchy &operator=(const AMRHierarchy &) = delete;
+
+  /// @brief Snapshot the base grid before it steps; the first level's ring
+  ///        data is interpolated in time between it and the stepped grid.
+  void BeginStep();
+
+  /// @brief Advance all refined levels by one base step (call after the base
+  ///        grid has stepped), regridding when due.
+  /// @param sourceScale Velocity source factor of this step.
+  void Advance(double sourceScale = 1.0);
+
+  /// @brief Write one .vthb snapshot per enabled cell-centred field.
+  void WriteOutput();
+
+  /// @brief Add the hierarchy to checkpoint @p info (state @c "amr",
+  ///        array @c "amr").
+  void Save(Checkpoint::Info &info) const;
+
+  /**
+   * @brief Replace the hierarchy by the one saved in @p info.
+   *
+   * Call after the base grid has been restored. A checkpoint without AMR
+   * data, or with another ratio / ghost width, is warned about and the
+   * hierarchy is regridded from the restored base grid instead.
+   */
+  void Restore(const Checkpoint::Info &info);
+
+  /// @return Number of refined levels currently present.
+  [[nodiscard]] int numLevels() const {
+    return static_cast<int>(levels_.size());
+  }
+
+  /// @return Number of patches on refined level @p level (1-based).
+  [[nodiscard]] int numPatches(int level) const {
+    return static_cast<int>(levels_[level - 1].size());
+  }
+
+private:
+  struct Patch;
+  struct Snapshot;
+
+  /// A scene value re-imposed every step in source mode.
+  struct SourceEntry {
+    int field; ///< 0 = u, 1 = v, 2 = smoke.
+    int i, j;  ///< Base-grid index.
+    varType val;
+  };
+
+  const Parameters &params;
+  const AMRConfig &cfg;
+  Fields2D &base;
+
+  /// levels_[l - 1] holds the patches of refined level l.
+  std::vector<std::vector<std::unique_ptr<Patch>>> levels_;
+  std::vector<SourceEntry> sources_;
+  std::unique_ptr<Snapshot> baseOld_; ///< Base grid at the start of the step.
+  double sourceScale_ = 1.0; ///< Velocity factor of the current step.
+  int steps_ = 0;
+
+  std::unique_ptr<OutputWriter> pWriter;
+  std::unique_ptr<OutputWriter> divWriter;
+  std::unique_ptr<OutputWriter> normVelocityWriter;
+  std::unique_ptr<OutputWriter> smokeWriter;
+
+  /// @brief Rebuild every refined level from the current criteria.
+  void regrid();
+
+  /// @brief Patch over box (@p bi0, @p bj0, @p bnx, @p bny) of @p parent
+  ///        (nullptr = base), filled from the parent.
+  std::unique_ptr<Patch> makePatch(Patch *parent, int level, int bi0,
+                                   int bj0, int bnx, int bny);
+
+  /// @brief Flag blocks of @p parent (nullptr = base) and append new
+  ///        level-@p level patches to @p out.
+  void createPatches(Patch *parent, int level,
+                     std::vector<std::unique_ptr<Patch>> &out,
+                     const std::vector<std::unique_ptr<Patch>> *old);
+
+  /// @brief @c ratio sub-steps of level @p level, recursing into finer
+  ///        levels, then restriction onto the parents.
+  void advanceLevel(int level);
+
+  /**
+   * @brief Call @p f(i, j, fi, fj) for every entry (i, j) of an @p nx ×
+   *        @p ny grid of @p p sampled at offset (@p sx, @p sy) in the
+   *        cell, where (fi, fj) is the continuous index of the same point
+   *        in a parent grid sampled at offset (@p ox, @p oy).
+   */
+  template <class F>
+  void mapToParent(const Patch &p, int nx, int ny, double sx, double sy,
+                   double ox, double oy, F &&f) const;
+
+  /**
+   * @brief Interpolate parent data into @p p (ring only, or everything).
+   * @param alpha Time weight of the parent's current state against its
+   *              snapshot from before its step (1 = current state only;
+   *              also used when there is no snapshot).
+   */
+  void fillFromParent(Patch &p, bool ringOnly, double alpha = 1.0) const;
+
+  /// @brief Copy u, v, p and smoke of @p f into @p s (allocated on first use).
+  static void snapshot(std::unique_ptr<Snapshot> &s, const Fields2D &f);
+
+  /// @brief Add the fine faces on the box boundary of @p p to its flux sums
+  ///        (after each sub-step).
+  void accumulateFlux(Patch &p) const;
+
+  /// @brief Reflux and sync-project the parents of level @p level (see
+  ///        the class description), after its restriction.
+  void synchronise(int level);
+
+  /// @brief synchronise() for one parent (nullptr = base) and its patches.
+  void synchroniseParent(Patch *parent, const std::vector<Patch *> &children);
+
+  /// @brief Copy interior values shared with an old patch of the same level.
+  static void copyOverlap(Patch &dst, const Patch &src);
+
+  /// @brief Average the interior of @p p onto its parent.
+  void restrictToParent(Patch &p);
+
+  /// @brief Re-impose the scene sources on @p p (source mode only).
+  void applySources(Patch &p) const;
+
+  /// @brief Parent fields of @p p (the base grid for level 1).
+  [[nodiscard]] Fields2D &parentFields(const Patch &p) const;
+
+  /// @return The output writers that exist.
+  [[nodiscard]] std::vector<OutputWriter *> writers() const;
+};
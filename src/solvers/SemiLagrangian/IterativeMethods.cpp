@@ -1,7 +1,16 @@
 #include "SemiLagrangian.hpp"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
+namespace {
+
+/// Nominal flops of getUpdate() (four neighbour adds, scale, add, divide),
+/// for the profiler's roofline numbers.
+constexpr double kUpdateFlops = 7.0;
+
+} // namespace
+
 // Cell update
 double SemiLagrangian::getUpdate(const int i, const int j,
                                  const varType coef) const {
@@ -31,31 +40,42 @@ double SemiLagrangian::computeResidualNorm(const varType coef) const {
   // RMS of the discrete Poisson residual over all FLUID cells:
   //   r_{ij} = rhs_{ij} - (A·p)_{ij}
   //          = -coef·div_{ij}  -  (nb·p_{ij} - Σ p_nb)
+  // Every non-SOLID tile contributes (quiescent ones too: the pressure is
+  // global), owned cells only, so ghost layers are not double-counted
+  // across MPI ranks.
   double sumSq = 0.0;
-  int count = 0;
-
-#pragma omp parallel for collapse(2) reduction(+ : sumSq) reduction(+ : count)
-  for (int j = 0; j < ny; ++j) {
-    for (int i = 0; i < nx; ++i) {
-      if (fields->Label(i, j) != Fields2D::FLUID)
-        continue;
-
-      double sumP = 0.0;
-      int nb = 0;
-
-      if (i + 1 < nx) { sumP += fields->p.Get(i + 1, j); ++nb; }
-      if (i - 1 >= 0) { sumP += fields->p.Get(i - 1, j); ++nb; }
-      if (j + 1 < ny) { sumP += fields->p.Get(i, j + 1); ++nb; }
-      if (j - 1 >= 0) { sumP += fields->p.Get(i, j - 1); ++nb; }
-
-      const double r =
-          (-coef * fields->div.Get(i, j)) - (nb * fields->p.Get(i, j) - sumP);
-      sumSq += r * r;
-      ++count;
+  long long count = 0;
+
+#pragma omp parallel for schedule(dynamic) reduction(+ : sumSq) reduction(+ : count)
+  for (int t = 0; t < tiles->numFluid(); ++t) {
+    const TileMap::Range rt = tiles->fluidRange(t, nx, ny);
+    for (int j = std::max(rt.j0, jBegin); j < std::min(rt.j1, jEnd); ++j) {
+      for (int i = std::max(rt.i0, iBegin); i < std::min(rt.i1, iEnd); ++i) {
+        if (fields->Label(i, j) != Fields2D::FLUID)
+          continue;
+
+        double sumP = 0.0;
+        int nb = 0;
+
+        if (i + 1 < nx) { sumP += fields->p.Get(i + 1, j); ++nb; }
+        if (i - 1 >= 0) { sumP += fields->p.Get(i - 1, j); ++nb; }
+        if (j + 1 < ny) { sumP += fields->p.Get(i, j + 1); ++nb; }
+        if (j - 1 >= 0) { sumP += fields->p.Get(i, j - 1); ++nb; }
+
+        const double r = (-coef * fields->div.Get(i, j)) -
+                         (nb * fields->p.Get(i, j) - sumP);
+        sumSq += r * r;
+        ++count;
+      }
     }
   }
 
-  return (count > 0) ? std::sqrt(sumSq / count) : 0.0;
+#ifdef USE_MPI
+  sumSq = decomp->allreduceSum(sumSq);
+  count = decomp->allreduceSum(count);
+#endif
+
+  return (count > 0) ? std::sqrt(sumSq / static_cast<double>(count)) : 0.0;
 }
 
 // Convergence check
@@ -72,113 +92,149 @@ static bool checkConvergence(const double res, double &res0, const int it,
   return (res / res0) < tol;
 }
 
-// Jacobi
-
-void SemiLagrangian::SolveJacobi(int maxIters, double tol) {
-  const varType coef = density * dx * dx / dt;
-  fields->Div();
-
-  // Jacobi requires a separate buffer because all reads must use the
-  // previous-iteration values.
-  Grid2D pNew(nx, ny);
-  double res0 = 1.0;
-
-  for (int it = 0; it < maxIters; ++it) {
-
-#pragma omp parallel for collapse(2)
-    for (int j = 0; j < ny; ++j)
-      for (int i = 0; i < nx; ++i)
-        pNew.Set(i, j, getUpdate(i, j, coef));
+// Sweeps
+
+void SemiLagrangian::sweepJacobi(const varType coef, Grid2D &pNew) {
+#pragma omp parallel
+  {
+    PIC_PROFILE_THREAD(profiler, PROJECT);
+#pragma omp for schedule(dynamic) nowait
+    for (int t = 0; t < tiles->numFluid(); ++t) {
+      const TileMap::Range r = tiles->fluidRange(t, nx, ny);
+      for (int j = r.j0; j < r.j1; ++j)
+        for (int i = r.i0; i < r.i1; ++i)
+          pNew.Set(i, j, getUpdate(i, j, coef));
+    }
+  }
 
-#pragma omp parallel for collapse(2)
-    for (int j = 0; j < ny; ++j)
-      for (int i = 0; i < nx; ++i)
+#pragma omp parallel for schedule(dynamic)
+  for (int t = 0; t < tiles->numFluid(); ++t) {
+    const TileMap::Range r = tiles->fluidRange(t, nx, ny);
+    for (int j = r.j0; j < r.j1; ++j)
+      for (int i = r.i0; i < r.i1; ++i)
         if (fields->Label(i, j) == Fields2D::FLUID)
           fields->p.Set(i, j, pNew.Get(i, j));
-
-    const double res = computeResidualNorm(coef);
-    if (checkConvergence(res, res0, it, tol)) {
-#ifndef NDEBUG
-      std::cout << "  Jacobi converged in " << it + 1
-                << " iters, rel.res = " << res / res0 << '\n';
-#endif
-      return;
-    }
   }
-
-#ifndef NDEBUG
-  std::cout << "  Jacobi: reached maxIters = " << maxIters << '\n';
-#endif
+  exchangeGhosts(fields->p);
 }
 
-// Gauss-Seidel
-
-void SemiLagrangian::SolveGaussSeidel(int maxIters, double tol) {
-  const varType coef = density * dx * dx / dt;
-  fields->Div();
-
-  double res0 = 1.0;
-
-  for (int it = 0; it < maxIters; ++it) {
-    // Sequential sweep — each cell sees the latest neighbour values.
-    for (int j = 0; j < ny; ++j)
-      for (int i = 0; i < nx; ++i) {
+void SemiLagrangian::sweepGaussSeidel(const varType coef) {
+  // Sequential sweep — each cell sees the latest neighbour values. Rows
+  // are walked in order and SOLID tiles are skipped span by span, so the
+  // update order is unchanged when there are none.
+  PIC_PROFILE_THREAD(profiler, PROJECT);
+  for (int j = 0; j < ny; ++j) {
+    const int tj = j / tiles->tileSize;
+    for (int ti = 0; ti < tiles->ntx; ++ti) {
+      if (!tiles->isFluid(ti, tj))
+        continue;
+      const TileMap::Range r = tiles->tileRange(ti, tj, nx, ny);
+      for (int i = r.i0; i < r.i1; ++i) {
         const double newVal = getUpdate(i, j, coef);
         if (!std::isnan(newVal))
           fields->p.Set(i, j, newVal);
       }
-
-    const double res = computeResidualNorm(coef);
-    if (checkConvergence(res, res0, it, tol)) {
-#ifndef NDEBUG
-      std::cout << "  GaussSeidel converged in " << it + 1
-                << " iters, rel.res = " << res / res0 << '\n';
-#endif
-      return;
     }
   }
+  // Under MPI this becomes block Gauss-Seidel: blocks sweep independently
+  // and see their neighbours' values from the previous sweep.
+  exchangeGhosts(fields->p);
+}
 
-#ifndef NDEBUG
-  std::cout << "  GaussSeidel: reached maxIters = " << maxIters << '\n';
-#endif
+void SemiLagrangian::sweepRedBlack(const varType coef) {
+  // Two-colour decomposition: "red" cells (i+j even) and "black" cells
+  // (i+j odd). Each colour's cells are independent of one another, so
+  // the inner loop can be parallelised without data races. Colours use the
+  // global index parity so MPI blocks agree on which cells are red.
+  for (int color = 0; color < 2; ++color) {
+#pragma omp parallel
+    {
+      PIC_PROFILE_THREAD(profiler, PROJECT);
+#pragma omp for schedule(dynamic) nowait
+      for (int t = 0; t < tiles->numFluid(); ++t) {
+        const TileMap::Range r = tiles->fluidRange(t, nx, ny);
+        for (int j = r.j0; j < r.j1; ++j) {
+          // First i of this row with the current colour.
+          const int iStart = r.i0 + ((r.i0 + j + parity + color) & 1);
+          for (int i = iStart; i < r.i1; i += 2) {
+            const double newVal = getUpdate(i, j, coef);
+            if (!std::isnan(newVal))
+              fields->p.Set(i, j, newVal);
+          }
+        }
+      }
+    }
+    exchangeGhosts(fields->p);
+  }
 }
 
-// Red-Black Gauss-Seidel
+// Iteration driver
 
-void SemiLagrangian::SolveRedBlackGaussSeidel(int maxIters, double tol) {
+void SemiLagrangian::iteratePressure(
+    const char *name, int maxIters, double tol,
+    const std::function<void(varType)> &sweep) {
   const varType coef = density * dx * dx / dt;
-  fields->Div();
-
+  const double start = GET_TIME();
+  // The right-hand side on every tile the sweeps visit.
+#pragma omp parallel for schedule(dynamic)
+  for (int t = 0; t < tiles->numFluid(); ++t)
+    fields->Div(tiles->fluidRange(t, nx, ny));
+
+  SolverTelemetry::Solve &solve = lastSolve;
+  solve = SolverTelemetry::Solve();
   double res0 = 1.0;
+  double res = 0.0;
+  bool converged = false;
+
+  for (int it = 0; it < maxIters && !converged; ++it) {
+    sweep(coef);
+    PIC_PROFILE_FLOPS(profiler, PROJECT,
+                      kUpdateFlops * tiles->fluidFraction() * nx * ny);
+
+    res = computeResidualNorm(coef);
+    if (recordHistory)
+      solve.history.push_back(res);
+    converged = checkConvergence(res, res0, it, tol);
+    solve.iterations = it + 1;
+  }
 
-  for (int it = 0; it < maxIters; ++it) {
-    // Two-colour decomposition: "red" cells (i+j even) and "black" cells
-    // (i+j odd). Each colour's cells are independent of one another, so
-    // the inner loop can be parallelised without data races.
-    for (int color = 0; color < 2; ++color) {
-#pragma omp parallel for collapse(2)
-      for (int j = 0; j < ny; ++j) {
-        for (int i = 0; i < nx; ++i) {
-          if ((i + j) % 2 != color)
-            continue;
-          const double newVal = getUpdate(i, j, coef);
-          if (!std::isnan(newVal))
-            fields->p.Set(i, j, newVal);
-        }
-      }
-    }
+  solve.initialResidual = solve.iterations > 0 ? res0 : 0.0;
+  solve.finalResidual = res;
+  solve.hitMax = !converged;
+  solve.seconds = GET_TIME() - start;
+  PIC_PROFILE_ITERATIONS(profiler, solve.iterations);
 
-    const double res = computeResidualNorm(coef);
-    if (checkConvergence(res, res0, it, tol)) {
 #ifndef NDEBUG
-      std::cout << "  RedBlackGS converged in " << it + 1
-                << " iters, rel.res = " << res / res0 << '\n';
+  if (converged)
+    std::cout << "  " << name << " converged in " << solve.iterations
+              << " iters, rel.res = " << res / res0 << '\n';
+  else
+    std::cout << "  " << name << ": reached maxIters = " << maxIters << '\n';
+#else
+  (void)name;
 #endif
-      return;
-    }
-  }
+}
 
-#ifndef NDEBUG
-  std::cout << "  RedBlackGS: reached maxIters = " << maxIters << '\n';
-#endif
+// Jacobi
+
+void SemiLagrangian::SolveJacobi(int maxIters, double tol) {
+  // Jacobi requires a separate buffer because all reads must use the
+  // previous-iteration values.
+  Grid2D pNew(nx, ny);
+  iteratePressure("Jacobi", maxIters, tol,
+                  [&](varType coef) { sweepJacobi(coef, pNew); });
+}
+
+// Gauss-Seidel
+
+void SemiLagrangian::SolveGaussSeidel(int maxIters, double tol) {
+  iteratePressure("GaussSeidel", maxIters, tol,
+                  [&](varType coef) { sweepGaussSeidel(coef); });
+}
+
+// Red-Black Gauss-Seidel
+
+void SemiLagrangian::SolveRedBlackGaussSeidel(int maxIters, double tol) {
+  iteratePressure("RedBlackGS", maxIters, tol,
+                  [&](varType coef) { sweepRedBlack(coef); });
 }
@@ -0,0 +1,144 @@
+#include "SemiLagrangian.hpp"
+#include "../../core/Helpers.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+// Monitor setup
+
+void SemiLagrangian::InitializeMonitors() {
+  const MonitorConfig &cfg = params.monitors;
+#ifdef USE_MPI
+  if (isRoot())
+    std::cerr << "[SemiLagrangian] Warning: monitors are not supported in "
+                 "MPI builds, ignoring.\n";
+  (void)cfg;
+  return;
+#else
+  // Pressure force on the SOLID cells of the region: every SOLID / FLUID
+  // face contributes -p n A, with p taken in the adjacent fluid cell and n
+  // the outward normal of the solid. Faces of one fluid cell are merged.
+  if (cfg.forces) {
+    const auto [i0, i1, j0, j1] = cellRect(cfg.fx1, cfg.fy1, cfg.fx2, cfg.fy2);
+    std::map<std::pair<int, int>, std::pair<varType, varType>> faces;
+    int jLow = ny, jHigh = -1;
+    for (int j = j0; j <= j1; ++j)
+      for (int i = i0; i <= i1; ++i) {
+        if (fields->Label(i, j) != Fields2D::SOLID)
+          continue;
+        jLow = std::min(jLow, j);
+        jHigh = std::max(jHigh, j);
+        const int di[] = {1, -1, 0, 0};
+        const int dj[] = {0, 0, 1, -1};
+        for (int k = 0; k < 4; ++k) {
+          const int fi = i + di[k], fj = j + dj[k];
+          if (fi < 0 || fi >= nx || fj < 0 || fj >= ny ||
+              fields->Label(fi, fj) == Fields2D::SOLID)
+            continue;
+          auto &[ax, ay] = faces[{fj, fi}];
+          ax -= static_cast<varType>(di[k]) * dy;
+          ay -= static_cast<varType>(dj[k]) * dx;
+        }
+      }
+    forceFaces.clear();
+    for (const auto &[cell, area] : faces)
+      forceFaces.push_back({cell.second, cell.first, area.first, area.second});
+    forceLength = cfg.length > 0.0 ? cfg.length
+                                   : std::max(0, jHigh - jLow + 1) * params.dy;
+    if (forceFaces.empty())
+      std::cerr << "[SemiLagrangian] Warning: no SOLID cell in the force "
+                   "region, forces will be 0.\n";
+  }
+
+  const std::string path =
+      cfg.file.empty() ? params.folder + "/monitors.csv" : cfg.file;
+  if (const auto dir = std::filesystem::path(path).parent_path();
+      !dir.empty())
+    std::filesystem::create_directories(dir);
+
+  // A restarted run keeps the rows up to its checkpoint and appends.
+  if (startStep > 1) {
+    monitorFile = openCsvForRestart(path, startStep);
+  } else {
+    monitorFile.open(path, std::ios::trunc);
+  }
+  if (!monitorFile.is_open()) {
+    std::cerr << "[SemiLagrangian] Warning: cannot open '" << path
+              << "', monitors disabled.\n";
+    return;
+  }
+  monitorFile << std::setprecision(10);
+  if (startStep > 1)
+    return;
+
+  monitorFile << "step,time";
+  for (const MonitorConfig::Probe &probe : cfg.probes)
+    for (const std::string &f : probe.fields)
+      monitorFile << ',' << probe.name << '_' << f;
+  for (const MonitorConfig::Average &avg : cfg.averages)
+    for (const std::string &f : avg.fields)
+      monitorFile << ',' << avg.name << '_' << f;
+  if (cfg.forces)
+    monitorFile << ",Fx,Fy,Cd,Cl";
+  monitorFile << '\n';
+#endif
+}
+
+// Monitor rows
+
+void SemiLagrangian::WriteMonitors(int step) {
+  const MonitorConfig &cfg = params.monitors;
+  monitorFile << step << ',' << step * params.dt;
+
+  for (const MonitorConfig::Probe &probe : cfg.probes) {
+    const varType x = static_cast<varType>((probe.x + 0.5) * params.dx);
+    const varType y = static_cast<varType>((probe.y + 0.5) * params.dy);
+    for (const std::string &f : probe.fields) {
+      double val = 0.0;
+      if (f == "u")
+        val = interpolateU(x, y);
+      else if (f == "v")
+        val = interpolateV(x, y);
+      else if (f == "p")
+        val = interpolateP(x, y);
+      else if (f == "smoke")
+        val = interpolateSmoke(x, y);
+      monitorFile << ',' << val;
+    }
+  }
+
+  for (const MonitorConfig::Average &avg : cfg.averages) {
+    const auto [i0, i1, j0, j1] = cellRect(avg.x1, avg.y1, avg.x2, avg.y2);
+    for (const std::string &f : avg.fields) {
+      const Grid2D *src = fieldByName(f);
+      double sum = 0.0;
+      long long count = 0;
+      if (src) {
+#pragma omp parallel for reduction(+ : sum, count) schedule(static)
+        for (int j = j0; j <= j1; ++j)
+          for (int i = i0; i <= i1; ++i)
+            if (fields->Label(i, j) != Fields2D::SOLID) {
+              sum += cellValue(*src, i, j);
+              ++count;
+            }
+      }
+      monitorFile << ',' << (count > 0 ? sum / count : 0.0);
+    }
+  }
+
+  if (cfg.forces) {
+    double fx = 0.0, fy = 0.0;
+    for (const ForceFace &face : forceFaces) {
+      const double p = fields->p.Get(face.i, face.j);
+      fx += face.ax * p;
+      fy += face.ay * p;
+    }
+    const double q =
+        0.5 * params.density * cfg.uRef * cfg.uRef * forceLength;
+    monitorFile << ',' << fx << ',' << fy << ',' << (q > 0.0 ? fx / q : 0.0)
+                << ',' << (q > 0.0 ? fy / q : 0.0);
+  }
+  monitorFile << '\n';
+}
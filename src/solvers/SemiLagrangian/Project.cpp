@@ -35,7 +35,7 @@ void SemiLagrangian::updateVelocities() {
   // u-faces: i is the fast (inner) index — contiguous in row-major storage.
 #pragma omp parallel for collapse(2) schedule(static)
   for (int j = 0; j < fields->u.ny; ++j) {
-    for (int i = 1; i < fields->u.nx; ++i) {
+    for (int i = 1; i < fields->u.nx - 1; ++i) {
       if (fields->Label(i - 1, j) == Fields2D::SOLID ||
           fields->Label(i,     j) == Fields2D::SOLID) {
         fields->u.Set(i, j, fields->usolid);
@@ -49,7 +49,7 @@ void SemiLagrangian::updateVelocities() {
 
   // v-faces: i is the fast (inner) index.
 #pragma omp parallel for collapse(2) schedule(static)
-  for (int j = 1; j < fields->v.ny; ++j) {
+  for (int j = 1; j < fields->v.ny - 1; ++j) {
     for (int i = 0; i < fields->v.nx; ++i) {
       if (fields->Label(i, j - 1) == Fields2D::SOLID ||
           fields->Label(i, j    ) == Fields2D::SOLID) {
@@ -63,7 +63,30 @@ void SemiLagrangian::updateVelocities() {
   }
 }
 
+void SemiLagrangian::applyWalls() {
+  // Only the faces on the global boundary: under MPI the local u / v grids
+  // of an interior block end in ghost faces.
+  const bool left = fields->originI == 0;
+  const bool right = fields->originI + nx == params.nx;
+  const bool bottom = fields->originJ == 0;
+  const bool top = fields->originJ + ny == params.ny;
+
+  for (int j = 0; j < fields->u.ny; ++j) {
+    if (left)
+      fields->u.Set(0, j, REAL_LITERAL(0.0));
+    if (right)
+      fields->u.Set(fields->u.nx - 1, j, REAL_LITERAL(0.0));
+  }
+  for (int i = 0; i < fields->v.nx; ++i) {
+    if (bottom)
+      fields->v.Set(i, 0, REAL_LITERAL(0.0));
+    if (top)
+      fields->v.Set(i, fields->v.ny - 1, REAL_LITERAL(0.0));
+  }
+}
+
 void SemiLagrangian::MakeIncompressible() {
+  PIC_PROFILE_SCOPE(profiler, PROJECT);
   solvePressure(params.solver.maxIters, params.solver.tolerance);
   updateVelocities();
 }
@@ -1,115 +1,872 @@
 #include "SemiLagrangian.hpp"
+#include "AMRHierarchy.hpp"
+#include "../../core/Checkpoint.hpp"
 #include <algorithm>
+#include <deque>
+#include <filesystem>
 #include <iostream>
+#include <limits>
 
 SemiLagrangian::SemiLagrangian(const Parameters &params)
-    : params(params), nx(params.nx), ny(params.ny),
+    : params(params),
+#ifdef USE_MPI
+      decomp(std::make_unique<Decomposition2D>(params.nx, params.ny,
+                                               params.mpi_halo)),
+      nx(decomp->localNx()), ny(decomp->localNy()),
+#else
+      nx(params.nx), ny(params.ny),
+#endif
       dx(static_cast<varType>(params.dx)), dy(static_cast<varType>(params.dy)),
       dt(static_cast<varType>(params.dt)),
       density(static_cast<varType>(params.density)),
       fields(new Fields2D(nx, ny, density, dt, dx, dy)) {
 
+  iEnd = nx;
+  jEnd = ny;
+#ifdef USE_MPI
+  fields->originI = decomp->originI();
+  fields->originJ = decomp->originJ();
+  const auto owned = decomp->ownedRange(fields->p);
+  iBegin = owned[0];
+  iEnd = owned[1];
+  jBegin = owned[2];
+  jEnd = owned[3];
+  if (isRoot())
+    std::cout << "[SemiLagrangian] " << decomp->size << " MPI ranks, halo = "
+              << decomp->halo << '\n';
+#endif
+  parity = (fields->originI + fields->originJ) & 1;
+
 #ifndef NDEBUG
-  std::cout << "Grid dimensions:\n"
-            << "  p  (nx,   ny  ): " << fields->p.nx << " x " << fields->p.ny
-            << '\n'
-            << "  u  (nx+1, ny  ): " << fields->u.nx << " x " << fields->u.ny
-            << '\n'
-            << "  v  (nx,   ny+1): " << fields->v.nx << " x " << fields->v.ny
-            << '\n';
+  if (isRoot() && !params.quiet)
+    std::cout << "Grid dimensions:\n"
+              << "  p  (nx,   ny  ): " << fields->p.nx << " x " << fields->p.ny
+              << '\n'
+              << "  u  (nx+1, ny  ): " << fields->u.nx << " x " << fields->u.ny
+              << '\n'
+              << "  v  (nx,   ny+1): " << fields->v.nx << " x " << fields->v.ny
+              << '\n';
 #endif
 
   // Apply initial conditions from the JSON config (velocity patches, solid
   // geometry). SceneObject instances are created and destroyed inside here.
   params.applyToFields(*fields);
+  if (params.source.enabled)
+    sources = std::make_unique<SceneSources>(params, *fields);
 
+  if (params.statistics.enabled)
+    statistics = std::make_unique<RunningStatistics>(
+        nx, ny, params.statistics.fields);
   InitializeOutputWriters();
+  // Before the restore, which replaces the patches by the saved ones.
+  if (params.amr.enabled) {
+#ifdef USE_MPI
+    if (isRoot())
+      std::cerr << "[SemiLagrangian] Warning: AMR is not supported in MPI "
+                   "builds, ignoring.\n";
+#else
+    amr = std::make_unique<AMRHierarchy>(params, *fields, sources.get());
+#endif
+  }
+  if (!params.restart.empty())
+    RestoreCheckpoint();
+  if (params.monitors.enabled)
+    InitializeMonitors();
+  if (params.solver.log && isRoot()) {
+    const std::string path = params.solver.logFile.empty()
+                                 ? params.folder + "/pressure.csv"
+                                 : params.solver.logFile;
+    if (!pressureTelemetry.open(path, params.solver.historySteps,
+                                params.solver.historyEvery, startStep))
+      std::cerr << "[SemiLagrangian] Warning: cannot open '" << path
+                << "', pressure log disabled.\n";
+  }
+#ifdef PIC_PROFILE
+  if (params.profile.enabled && params.profile.counters &&
+      !profiler.enableCounters() && isRoot())
+    std::cerr << "[SemiLagrangian] Warning: hardware counters unavailable ("
+              << profiler.countersUnavailable() << "), timings only.\n";
+#endif
+
+  tiles = std::make_unique<TileMap>(nx, ny, params.tiling.tileSize);
+  if (params.tiling.enabled) {
+    tiles->classifySolid(*fields);
+    if (sources)
+      for (int field = 0; field < SceneSources::NUM_FIELDS; ++field)
+        for (const SceneSources::Span &span :
+             sources->spans(static_cast<SceneSources::Field>(field)))
+          tiles->keepActive(span.i0, span.i1, span.j, span.j + 1);
+    tiles->update(*fields, static_cast<varType>(params.tiling.threshold),
+                  true);
+  }
 
 #ifndef NDEBUG
-  std::cout << "SemiLagrangian initialised: " << nx << " x " << ny << " grid, "
-            << params.nt << " time steps.\n";
+  if (isRoot() && !params.quiet)
+    std::cout << "SemiLagrangian initialised: " << nx << " x " << ny
+              << " grid, " << params.nt << " time steps.\n";
 #endif
 }
 
-SemiLagrangian::~SemiLagrangian() { delete fields; }
+SemiLagrangian::~SemiLagrangian() {
+  amr.reset(); // patches reference *fields
+  delete fields;
+}
 
 void SemiLagrangian::InitializeOutputWriters() {
+  if (params.output.async)
+    asyncWriter = std::make_unique<AsyncWriter>(params.output.queueDepth);
+  WriterOptions options = params.output.writer;
+#ifdef USE_MPI
+  // Pieces are always .vti + .pvti; see WriterOptions::series.
+  if (options.series && isRoot())
+    std::cerr << "[SemiLagrangian] Warning: series output is not supported "
+                 "in MPI builds, writing .vti files.\n";
+  options.series = false;
+  if (!params.output.views.empty() && isRoot())
+    std::cerr << "[SemiLagrangian] Warning: output views are not supported "
+                 "in MPI builds, ignoring.\n";
+  if (!params.render.empty() && isRoot())
+    std::cerr << "[SemiLagrangian] Warning: in-situ rendering is not "
+                 "supported in MPI builds, ignoring.\n";
+#else
+  // One container for every field, view and statistic of the run.
+  if (options.series)
+    options.seriesFile = std::make_shared<SeriesFile>("series.bin");
+  for (const ViewConfig &view : params.output.views)
+    viewWriters.push_back(
+        std::make_unique<OutputWriter>(params.folder, view.name, options));
+  for (const RenderConfig &cfg : params.render)
+    renderers.push_back(std::make_unique<Renderer>(
+        params.folder, cfg, params.output.writer.compressionLevel));
+#endif
+  if (statistics)
+    statisticsWriter =
+        std::make_unique<OutputWriter>(params.folder, "statistics", options);
+  if (params.output.combined) {
+    fieldsWriter =
+        std::make_unique<OutputWriter>(params.folder, "fields", options);
+    return;
+  }
+
   if (params.write_u)
-    uWriter = std::make_unique<OutputWriter>(params.folder, "u");
+    uWriter = std::make_unique<OutputWriter>(params.folder, "u", options);
   if (params.write_v)
-    vWriter = std::make_unique<OutputWriter>(params.folder, "v");
+    vWriter = std::make_unique<OutputWriter>(params.folder, "v", options);
   if (params.write_p)
-    pWriter = std::make_unique<OutputWriter>(params.folder, "p");
+    pWriter = std::make_unique<OutputWriter>(params.folder, "p", options);
   if (params.write_div)
-    divWriter = std::make_unique<OutputWriter>(params.folder, "div");
+    divWriter = std::make_unique<OutputWriter>(params.folder, "div", options);
   if (params.write_norm_velocity)
     normVelocityWriter =
-        std::make_unique<OutputWriter>(params.folder, "normVelocity");
+        std::make_unique<OutputWriter>(params.folder, "normVelocity", options);
   if (params.write_smoke)
-    smokeWriter = std::make_unique<OutputWriter>(params.folder, "smoke");
+    smokeWriter = std::make_unique<OutputWriter>(
+        params.folder, "smoke", options);
+}
+
+std::vector<OutputWriter *> SemiLagrangian::outputWriters() const {
+  std::vector<OutputWriter *> out;
+  for (const auto *w : {&uWriter, &vWriter, &pWriter, &divWriter,
+                        &normVelocityWriter, &smokeWriter, &fieldsWriter,
+                        &statisticsWriter})
+    if (*w)
+      out.push_back(w->get());
+  for (const auto &w : viewWriters)
+    out.push_back(w.get());
+  return out;
+}
+
+std::string SemiLagrangian::checkpointFile(const std::string &base) const {
+#ifdef USE_MPI
+  return base + "." + std::to_string(decomp->rank);
+#else
+  return base;
+#endif
+}
+
+void SemiLagrangian::SaveCheckpoint(int step) const {
+  // The writer thread owns the writers' series until it has drained.
+  if (asyncWriter)
+    asyncWriter->flush();
+
+  Checkpoint::Info info;
+  info.step = step;
+  info.time = static_cast<double>(step) * params.dt;
+  info.state["writers"] = nlohmann::json::object();
+  for (const OutputWriter *w : outputWriters()) {
+    const OutputWriter::State st = w->state();
+    info.state["writers"][w->name()] = {
+        {"step", st.step}, {"entries", st.entries}, {"bytes", st.bytes}};
+  }
+
+  for (const auto &r : renderers)
+    info.state["images"][r->config().name] = r->frame();
+  if (amr)
+    amr->Save(info);
+  if (statistics) {
+    info.state["statistics"] = {{"samples", statistics->samples()},
+                                {"fields", statistics->fields()}};
+    for (std::size_t k = 0; k < statistics->fields().size(); ++k)
+      info.arrays["stats" + std::to_string(k)] = statistics->data(k);
+  }
+
+  const std::string base = params.checkpoint.path.empty()
+                               ? params.folder + "/checkpoint.pic"
+                               : params.checkpoint.path;
+  const double start = GET_TIME();
+  if (!Checkpoint::save(checkpointFile(base), *fields, info))
+    std::cerr << "[SemiLagrangian] Warning: checkpoint at step " << step
+              << " failed\n";
+#ifndef NDEBUG
+  else if (isRoot() && !params.quiet)
+    std::cout << "\nCheckpoint at step " << step << " ("
+              << (GET_TIME() - start) << " s)\n";
+#else
+  (void)start;
+#endif
+}
+
+void SemiLagrangian::RestoreCheckpoint() {
+  const double start = GET_TIME();
+  Checkpoint::Info info;
+  Checkpoint::load(checkpointFile(params.restart), *fields, info);
+
+  const nlohmann::json &saved =
+      info.state.contains("writers") ? info.state["writers"]
+                                     : nlohmann::json::object();
+  for (OutputWriter *w : outputWriters()) {
+    if (!saved.contains(w->name()))
+      continue; // field not written by the checkpointed run
+    OutputWriter::State st;
+    st.step = saved[w->name()].value("step", 0);
+    st.entries = saved[w->name()].value("entries", std::vector<std::string>());
+    st.bytes = saved[w->name()].value("bytes", std::uint64_t(0));
+    w->restore(st);
+  }
+  for (const auto &r : renderers)
+    if (info.state.contains("images"))
+      r->setFrame(info.state["images"].value(r->config().name, 0));
+  if (statistics) {
+    const nlohmann::json st = info.state.value("statistics",
+                                               nlohmann::json::object());
+    std::vector<std::vector<double>> acc;
+    for (std::size_t k = 0; k < statistics->fields().size(); ++k) {
+      const auto it = info.arrays.find("stats" + std::to_string(k));
+      if (it != info.arrays.end())
+        acc.push_back(std::move(it->second));
+    }
+    if (st.value("fields", std::vector<std::string>()) !=
+            statistics->fields() ||
+        !statistics->restore(st.value("samples", std::int64_t(0)), acc))
+      std::cerr << "[SemiLagrangian] Warning: checkpoint holds no matching "
+                   "statistics, accumulating from the restart step.\n";
+  }
+  if (amr)
+    amr->Restore(info);
+  startStep = static_cast<int>(info.step) + 1;
+  currentStep = startStep - 1;
+
+  if (isRoot() && !params.quiet)
+    std::cout << "[SemiLagrangian] Restarted from '" << params.restart
+              << "' at step " << info.step << " (" << (GET_TIME() - start)
+              << " s)\n";
+}
+
+bool SemiLagrangian::writeField(OutputWriter &writer, const Grid2D &grid,
+                                const std::string &id) const {
+#ifdef USE_MPI
+  return writer.writePiece(grid, id, decomp->ownedRange(grid),
+                           decomp->gatherPieceExtents(grid), decomp->rank,
+                           gridGeometry(grid));
+#else
+  return writer.writeGrid2D(grid, id, gridGeometry(grid));
+#endif
+}
+
+bool SemiLagrangian::writeFields(
+    OutputWriter &writer,
+    const std::vector<OutputWriter::NamedGrid> &arrays) const {
+#ifdef USE_MPI
+  return writer.writePieces(arrays, decomp->ownedRange(fields->p),
+                            decomp->gatherPieceExtents(fields->p),
+                            decomp->rank, gridGeometry(fields->p));
+#else
+  return writer.writeGrids(arrays, gridGeometry(fields->p));
+#endif
+}
+
+void SemiLagrangian::toCells(const Grid2D &src, Grid2D &out) const {
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int j = 0; j < ny; ++j)
+    for (int i = 0; i < nx; ++i)
+      out.Set(i, j, cellValue(src, i, j));
+}
+
+std::vector<OutputWriter::NamedGrid>
+SemiLagrangian::cellArrays(const std::function<Grid2D &()> &nextSlot) const {
+  std::vector<OutputWriter::NamedGrid> arrays;
+  auto add = [&](bool enabled, const Grid2D &grid, const char *id) {
+    if (!enabled)
+      return;
+    Grid2D &cells = nextSlot();
+    toCells(grid, cells);
+    arrays.push_back({id, &cells});
+  };
+  add(params.write_p, fields->p, "p");
+  add(params.write_u, fields->u, "u");
+  add(params.write_v, fields->v, "v");
+  add(params.write_div, fields->div, "div");
+  add(params.write_norm_velocity, fields->normVelocity, "normVelocity");
+  add(params.write_smoke, fields->smokeMap, "smoke");
+  return arrays;
+}
+
+std::array<int, 4> SemiLagrangian::cellRect(int x1, int y1, int x2,
+                                             int y2) const {
+  auto resolve = [](int value, int n) { return value < 0 ? n + value : value; };
+  return {std::max(resolve(x1, nx), 0), std::min(resolve(x2, nx), nx - 1),
+          std::max(resolve(y1, ny), 0), std::min(resolve(y2, ny), ny - 1)};
+}
+
+std::array<int, 4> SemiLagrangian::viewRange(const ViewConfig &view) const {
+  const auto [i0, i1, j0, j1] = cellRect(view.x1, view.y1, view.x2, view.y2);
+  const int ib = std::min(i0, nx - 1);
+  const int jb = std::min(j0, ny - 1);
+  return {ib, std::max(i1, ib) + 1, jb, std::max(j1, jb) + 1};
+}
+
+OutputWriter::Geometry
+SemiLagrangian::gridGeometry(const Grid2D &grid) const {
+  // Local sizes: u is (nx+1) × ny and v is nx × (ny+1) on every rank.
+  OutputWriter::Geometry geom;
+  geom.origin = {grid.nx == nx + 1 ? -0.5 * dx : 0.0,
+                 grid.ny == ny + 1 ? -0.5 * dy : 0.0};
+  geom.spacing = {dx, dy};
+  return geom;
+}
+
+OutputWriter::Geometry
+SemiLagrangian::viewGeometry(const ViewConfig &view) const {
+  const auto [ib, ie, jb, je] = viewRange(view);
+  const double s = view.stride;
+  // An averaged block spans its stride × stride cells; a sampled one is
+  // centred on the cell it was taken from.
+  const double shift = view.average ? 0.0 : 0.5 * (1.0 - s);
+  OutputWriter::Geometry geom;
+  geom.origin = {(ib + shift) * dx, (jb + shift) * dy};
+  geom.spacing = {s * dx, s * dy};
+  return geom;
+}
+
+void SemiLagrangian::toView(const Grid2D &src, const ViewConfig &view,
+                            Grid2D &out) const {
+  const auto [ib, ie, jb, je] = viewRange(view);
+  const int s = view.stride;
+
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int J = 0; J < out.ny; ++J) {
+    for (int I = 0; I < out.nx; ++I) {
+      const int i0 = ib + I * s;
+      const int j0 = jb + J * s;
+      if (!view.average) {
+        out.Set(I, J, cellValue(src, i0, j0));
+        continue;
+      }
+      // Blocks on the upper edges may be cut short by the rectangle.
+      const int i1 = std::min(i0 + s, ie);
+      const int j1 = std::min(j0 + s, je);
+      varType sum = REAL_LITERAL(0.0);
+      for (int j = j0; j < j1; ++j)
+        for (int i = i0; i < i1; ++i)
+          sum += cellValue(src, i, j);
+      out.Set(I, J, sum / static_cast<varType>((i1 - i0) * (j1 - j0)));
+    }
+  }
+}
+
+void SemiLagrangian::writeViews(int step, OutputBatch &batch) const {
+  const std::pair<const char *, const Grid2D *> all[] = {
+      {"p", &fields->p},
+      {"u", &fields->u},
+      {"v", &fields->v},
+      {"div", &fields->div},
+      {"normVelocity", &fields->normVelocity},
+      {"smoke", &fields->smokeMap}};
+  const bool enabled[] = {params.write_p,   params.write_u,
+                          params.write_v,   params.write_div,
+                          params.write_norm_velocity,
+                          params.write_smoke};
+
+  for (std::size_t k = 0; k < viewWriters.size(); ++k) {
+    const ViewConfig &view = params.output.views[k];
+    if (!isDue(view.samplingRate, step))
+      continue;
+    const auto [ib, ie, jb, je] = viewRange(view);
+    const int w = (ie - ib + view.stride - 1) / view.stride;
+    const int h = (je - jb + view.stride - 1) / view.stride;
+
+    std::vector<OutputWriter::NamedGrid> arrays;
+    for (std::size_t f = 0; f < std::size(all); ++f) {
+      const bool wanted =
+          view.fields.empty()
+              ? enabled[f]
+              : std::find(view.fields.begin(), view.fields.end(),
+                          all[f].first) != view.fields.end();
+      if (!wanted)
+        continue;
+      Grid2D &out = batch.next(w, h);
+      toView(*all[f].second, view, out);
+      arrays.push_back({all[f].first, &out});
+    }
+    if (arrays.empty())
+      continue;
+
+    // Time in base output frames, so every series shares one time axis.
+    OutputWriter *writer = viewWriters[k].get();
+    const OutputWriter::Geometry geom = viewGeometry(view);
+    const double time = static_cast<double>(step) / params.sampling_rate;
+    batch.run([writer, arrays, geom, time] {
+      return writer->writeGrids(arrays, geom, time);
+    });
+  }
+}
+
+void SemiLagrangian::renderField(const RenderConfig &cfg, Grid2D &out) const {
+  using Field = RenderConfig::Field;
+  const Grid2D &u = fields->u;
+  const Grid2D &v = fields->v;
+
+#pragma omp parallel for collapse(2) schedule(static)
+  for (int j = 0; j < ny; ++j) {
+    for (int i = 0; i < nx; ++i) {
+      if (cfg.maskSolid && fields->Label(i, j) == Fields2D::SOLID) {
+        out.Set(i, j, std::numeric_limits<varType>::quiet_NaN());
+        continue;
+      }
+      varType val = REAL_LITERAL(0.0);
+      switch (cfg.field) {
+      case Field::SMOKE:
+        val = cellValue(fields->smokeMap, i, j);
+        break;
+      case Field::PRESSURE:
+        val = fields->p.Get(i, j);
+        break;
+      case Field::VELOCITY: {
+        const varType uc = cellValue(u, i, j);
+        const varType vc = cellValue(v, i, j);
+        val = std::sqrt(uc * uc + vc * vc);
+        break;
+      }
+      case Field::VORTICITY: {
+        // Central differences of the cell-centred velocity (one-sided at
+        // the domain edge).
+        const int il = std::max(i - 1, 0), ir = std::min(i + 1, nx - 1);
+        const int jl = std::max(j - 1, 0), jr = std::min(j + 1, ny - 1);
+        val = (cellValue(v, ir, j) - cellValue(v, il, j)) /
+                  (static_cast<varType>(ir - il) * dx) -
+              (cellValue(u, i, jr) - cellValue(u, i, jl)) /
+                  (static_cast<varType>(jr - jl) * dy);
+        break;
+      }
+      }
+      out.Set(i, j, val);
+    }
+  }
+}
+
+void SemiLagrangian::renderImages(int step, OutputBatch &batch) const {
+  for (const auto &r : renderers) {
+    if (!isDue(r->config().every, step))
+      continue;
+    Grid2D &values = batch.next(nx, ny);
+    renderField(r->config(), values);
+    batch.run([renderer = r.get(), &values] { return renderer->write(values); });
+  }
 }
 
 void SemiLagrangian::WriteOutput(int step) const {
-  if (step % params.sampling_rate != 0)
+  // Views and images have their own sampling rates.
+  const bool fieldsDue = step % params.sampling_rate == 0;
+  bool extrasDue = false;
+  for (std::size_t k = 0; k < viewWriters.size(); ++k)
+    extrasDue |= isDue(params.output.views[k].samplingRate, step);
+  for (const auto &r : renderers)
+    extrasDue |= isDue(r->config().every, step);
+  if (!fieldsDue && !extrasDue)
     return;
 
-  bool ok = true;
-  if (params.write_u && uWriter)
-    ok &= uWriter->writeGrid2D(fields->u, "u");
-  if (params.write_v && vWriter)
-    ok &= vWriter->writeGrid2D(fields->v, "v");
-  if (params.write_p && pWriter)
-    ok &= pWriter->writeGrid2D(fields->p, "p");
-  if (params.write_div && divWriter)
-    ok &= divWriter->writeGrid2D(fields->div, "div");
-  if (params.write_norm_velocity && normVelocityWriter)
-    ok &= normVelocityWriter->writeGrid2D(fields->normVelocity, "normVelocity");
-  if (params.write_smoke && smokeWriter)
-    ok &= smokeWriter->writeGrid2D(fields->smokeMap, "smoke");
-  if (!ok)
+  if (fieldsDue && amr)
+    amr->WriteOutput();
+
+  // One staging frame per step carries everything written at that step.
+  OutputBatch batch;
+  if (asyncWriter) {
+    batch.frame = &asyncWriter->acquire(step);
+    if (asyncWriter->lastStall() > 0.0 && !params.quiet && isRoot())
+      std::cerr << "\n[SemiLagrangian] Step " << step << ": waited "
+                << asyncWriter->lastStall() * 1e3
+                << " ms for the output writer\n";
+  }
+  writeViews(step, batch);
+  renderImages(step, batch);
+
+  if (fieldsDue && batch.frame) {
+    queueOutput(batch);
+  } else if (fieldsDue) {
+    if (fieldsWriter) {
+      const auto arrays =
+          cellArrays([&]() -> Grid2D & { return batch.next(nx, ny); });
+      batch.ok &= arrays.empty() || writeFields(*fieldsWriter, arrays);
+    }
+    bool &ok = batch.ok;
+    if (params.write_u && uWriter)
+      ok &= writeField(*uWriter, fields->u, "u");
+    if (params.write_v && vWriter)
+      ok &= writeField(*vWriter, fields->v, "v");
+    if (params.write_p && pWriter)
+      ok &= writeField(*pWriter, fields->p, "p");
+    if (params.write_div && divWriter)
+      ok &= writeField(*divWriter, fields->div, "div");
+    if (params.write_norm_velocity && normVelocityWriter)
+      ok &= writeField(*normVelocityWriter, fields->normVelocity,
+                       "normVelocity");
+    if (params.write_smoke && smokeWriter)
+      ok &= writeField(*smokeWriter, fields->smokeMap, "smoke");
+  }
+
+  if (batch.frame)
+    asyncWriter->submit(*batch.frame);
+  else if (!batch.ok)
     std::cerr << "[SemiLagrangian] Warning: failed to write output at step "
               << step << '\n';
 }
 
-void SemiLagrangian::Step() {
+void SemiLagrangian::queueOutput(OutputBatch &batch) const {
+  // The jobs only see the staged copies, so the solver can keep updating
+  // the live fields while they run.
+  AsyncWriter::Frame &frame = *batch.frame;
+  std::size_t &slot = batch.slot;
+  if (fieldsWriter) {
+    const auto arrays =
+        cellArrays([&]() -> Grid2D & { return batch.next(nx, ny); });
+    OutputWriter *writer = fieldsWriter.get();
+#ifdef USE_MPI
+    frame.jobs.push_back([writer, arrays,
+                          range = decomp->ownedRange(fields->p),
+                          extents = decomp->gatherPieceExtents(fields->p),
+                          rank = decomp->rank,
+                          geom = gridGeometry(fields->p)] {
+      return arrays.empty() ||
+             writer->writePieces(arrays, range, extents, rank, geom);
+    });
+#else
+    frame.jobs.push_back([writer, arrays, geom = gridGeometry(fields->p)] {
+      return arrays.empty() || writer->writeGrids(arrays, geom);
+    });
+#endif
+  }
+
+  auto queue = [&](OutputWriter *writer, const Grid2D &grid, const char *id) {
+    if (!writer)
+      return;
+    const Grid2D &copy = frame.stage(slot++, grid);
+#ifdef USE_MPI
+    frame.jobs.push_back([writer, &copy, id, range = decomp->ownedRange(grid),
+                          extents = decomp->gatherPieceExtents(grid),
+                          rank = decomp->rank, geom = gridGeometry(grid)] {
+      return writer->writePiece(copy, id, range, extents, rank, geom);
+    });
+#else
+    frame.jobs.push_back([writer, &copy, id, geom = gridGeometry(grid)] {
+      return writer->writeGrid2D(copy, id, geom);
+    });
+#endif
+  };
+
+  queue(uWriter.get(), fields->u, "u");
+  queue(vWriter.get(), fields->v, "v");
+  queue(pWriter.get(), fields->p, "p");
+  queue(divWriter.get(), fields->div, "div");
+  queue(normVelocityWriter.get(), fields->normVelocity, "normVelocity");
+  queue(smokeWriter.get(), fields->smokeMap, "smoke");
+}
+
+const Grid2D *SemiLagrangian::fieldByName(const std::string &name) const {
+  if (name == "u")
+    return &fields->u;
+  if (name == "v")
+    return &fields->v;
+  if (name == "p")
+    return &fields->p;
+  if (name == "div")
+    return &fields->div;
+  if (name == "normVelocity")
+    return &fields->normVelocity;
+  if (name == "smoke")
+    return &fields->smokeMap;
+  return nullptr;
+}
+
+std::vector<const Grid2D *> SemiLagrangian::statisticsSources() const {
+  std::vector<const Grid2D *> src;
+  for (const std::string &name : statistics->fields())
+    src.push_back(fieldByName(name)); // names are validated by the config
+  return src;
+}
+
+void SemiLagrangian::UpdateDiagnostics(bool sample) {
+  if (!sample) {
+    fields->Div(*tiles);
+    fields->VelocityNormCenterGrid(*tiles);
+    return;
+  }
+  const std::vector<const Grid2D *> src = statisticsSources();
+  const Grid2D &norm = fields->normVelocity;
+  auto cell = [this, &src](std::size_t k, int i, int j) {
+    return cellValue(*src[k], i, j);
+  };
+  auto visit = [&](int ti, int tj) {
+    if (tiles->isActive(ti, tj)) {
+      fields->Div(tiles->tileRange(ti, tj, nx, ny));
+      fields->VelocityNormCenterGrid(
+          tiles->tileRange(ti, tj, norm.nx, norm.ny));
+    }
+    const TileMap::Range r = tiles->tileRange(ti, tj, nx, ny);
+    statistics->accumulate(r.i0, r.i1, r.j0, r.j1, cell);
+  };
+  // Cells of the last column / row sample the clamped (nx-1) × (ny-1)
+  // normVelocity. A tile only one cell wide there owns none of it and
+  // reads its neighbour's, so it waits until the parallel sweep is done.
+  auto borrows = [&](int ti, int tj) {
+    return ti * tiles->tileSize >= norm.nx || tj * tiles->tileSize >= norm.ny;
+  };
+  const int count = tiles->ntx * tiles->nty;
+  statistics->beginSample();
+#pragma omp parallel for schedule(dynamic)
+  for (int t = 0; t < count; ++t)
+    if (!borrows(t % tiles->ntx, t / tiles->ntx))
+      visit(t % tiles->ntx, t / tiles->ntx);
+  for (int t = 0; t < count; ++t)
+    if (borrows(t % tiles->ntx, t / tiles->ntx))
+      visit(t % tiles->ntx, t / tiles->ntx);
+}
+
+void SemiLagrangian::WriteStatistics(int step) const {
+  std::deque<Grid2D> storage;
+  if (!writeFields(*statisticsWriter, statistics->arrays(storage)))
+    std::cerr << "[SemiLagrangian] Warning: statistics at step " << step
+              << " could not be written\n";
+#ifndef NDEBUG
+  else if (isRoot() && !params.quiet)
+    std::cout << "\nStatistics at step " << step << " ("
+              << statistics->samples() << " samples)\n";
+#endif
+}
 
-  if (params.source == true) {
-    params.applyToFields(*fields); // TODO: améliorer, fait vite fait pour 
-                                            // avoir une source
+void SemiLagrangian::Step() {
+  ++currentStep;
+  // Source schedule at the start of this step.
+  const double sourceScale =
+      params.source.scale((currentStep - 1) * params.dt);
+  if (sources) {
+    PIC_PROFILE_SCOPE(profiler, SOURCES);
+    sources->apply(*fields, sourceScale);
   }
+  if (amr)
+    amr->BeginStep(); // start state for the patches' ring interpolation
 
   MakeIncompressible(); // 1. Pressure projection: enforce div u = 0.
+  {
+    PIC_PROFILE_SCOPE(profiler, EXCHANGE);
+    exchangeGhosts(fields->u);
+    exchangeGhosts(fields->v);
+    checkHaloDisplacement();
+  }
   Advect();             // 2. Semi-Lagrangian transport of velocity.
+  if (params.walls)
+    applyWalls();
+  {
+    PIC_PROFILE_SCOPE(profiler, EXCHANGE);
+    exchangeGhosts(fields->u);
+    exchangeGhosts(fields->v);
+    exchangeGhosts(fields->smokeMap);
+  }
   AdvectSmoke();
-  fields->Div();        // } Update diagnostics used for
-  fields->VelocityNormCenterGrid(); // } output and progress reporting.
+  if (amr) {
+    PIC_PROFILE_SCOPE(profiler, AMR);
+    amr->Advance(sourceScale); // 3. Sub-cycle the refined levels.
+  }
+  {
+    PIC_PROFILE_SCOPE(profiler, DIAGNOSTICS);
+    // Diagnostics used for output and progress reporting, once AMR has
+    // restricted, refluxed and sync-projected onto the base fields.
+    UpdateDiagnostics(sampleStatistics);
+
+    if (params.tiling.enabled)
+      tiles->update(*fields, static_cast<varType>(params.tiling.threshold));
+  }
 }
 
 void SemiLagrangian::Run() {
-  // Compute initial diagnostics and write the t=0 snapshot.
-  fields->Div();
-  fields->VelocityNormCenterGrid();
-  WriteOutput(0);
+  // Compute initial diagnostics and write the t=0 snapshot (a restarted run
+  // already wrote it, together with everything up to startStep - 1).
+  const StatisticsConfig &stats = params.statistics;
+  auto statisticsDue = [&](int t) {
+    return statistics && t >= stats.start &&
+           (t - stats.start) % stats.every == 0;
+  };
+  UpdateDiagnostics(startStep == 1 && statisticsDue(0));
+  if (startStep == 1) {
+    WriteOutput(0);
+    if (monitorFile.is_open())
+      WriteMonitors(0);
+  }
 
   const double start = GET_TIME();
   const int reportEvery = std::max(1, params.nt / 10);
 
-  for (int t = 1; t <= params.nt; ++t) {
+  for (int t = startStep; t <= params.nt; ++t) {
     // Overwrite progress line in place (~every 10 %).
-    if (t % reportEvery == 0) {
+    if (!params.quiet && t % reportEvery == 0) {
       varType maxDiv = REAL_LITERAL(0.0);
-      for (int j = 0; j < ny; ++j)
-        for (int i = 0; i < nx; ++i)
-          maxDiv = std::max(maxDiv, std::abs(fields->div.Get(i, j)));
+#pragma omp parallel for schedule(dynamic) reduction(max : maxDiv)
+      for (int k = 0; k < tiles->numActive(); ++k) {
+        const TileMap::Range r = tiles->activeRange(k, nx, ny);
+        for (int j = std::max(r.j0, jBegin); j < std::min(r.j1, jEnd); ++j)
+          for (int i = std::max(r.i0, iBegin); i < std::min(r.i1, iEnd); ++i)
+            maxDiv = std::max(maxDiv, std::abs(fields->div.Get(i, j)));
+      }
+#ifdef USE_MPI
+      maxDiv = static_cast<varType>(decomp->allreduceMax(maxDiv));
+#endif
 
-      std::cout << "\rStep " << t << " / " << params.nt << " ("
-                << (100 * t / params.nt) << "%) "
-                << "max |div| = " << maxDiv << std::flush;
+      if (isRoot())
+        std::cout << "\rStep " << t << " / " << params.nt << " ("
+                  << (100 * t / params.nt) << "%) "
+                  << "max |div| = " << maxDiv << std::flush;
     }
 
-    Step();
-    WriteOutput(t);
+    {
+      PIC_PROFILE_SCOPE(profiler, STEP);
+      recordHistory = pressureTelemetry.wantsHistory(t);
+      sampleStatistics = statisticsDue(t);
+      Step();
+      pressureTelemetry.record(t, std::move(lastSolve));
+      {
+        PIC_PROFILE_SCOPE(profiler, DIAGNOSTICS);
+        if (monitorFile.is_open() && t % params.monitors.every == 0)
+          WriteMonitors(t);
+      }
+      {
+        PIC_PROFILE_SCOPE(profiler, OUTPUT);
+        WriteOutput(t);
+      }
+      if (params.checkpoint.every > 0 && t % params.checkpoint.every == 0) {
+        PIC_PROFILE_SCOPE(profiler, CHECKPOINT);
+        if (statistics)
+          WriteStatistics(t);
+        if (monitorFile.is_open())
+          monitorFile.flush(); // rows up to t survive a crash after the save
+        SaveCheckpoint(t);
+      }
+    }
+    profiler.nextStep();
+  }
+  const bool lastWasCheckpoint =
+      params.checkpoint.every > 0 && params.nt % params.checkpoint.every == 0;
+  {
+    PIC_PROFILE_SCOPE(profiler, CHECKPOINT);
+    if (statistics && !lastWasCheckpoint)
+      WriteStatistics(params.nt);
+  }
+  {
+    PIC_PROFILE_SCOPE(profiler, OUTPUT); // drain of the background writer
+    if (asyncWriter)
+      asyncWriter->flush();
+  }
+
+  if (isRoot() && !params.quiet) {
+    std::cout << "\nDone: " << (GET_TIME() - start) << " s\n";
+    if (params.tiling.enabled)
+      std::cout << "Active tiles at end: " << tiles->numActive() << " / "
+                << tiles->ntx * tiles->nty << '\n';
+    if (pressureTelemetry.solves() > 0) {
+      const nlohmann::json sum = pressureTelemetry.summary();
+      std::cout << "Pressure: " << sum["iterations"]["mean"].get<double>()
+                << " iterations/step (max "
+                << sum["iterations"]["max"].get<int>() << "), "
+                << sum["hit_max"]["count"].get<long long>() << " / "
+                << pressureTelemetry.solves()
+                << " step(s) hit max_iterations\n";
+    }
+    if (asyncWriter)
+      std::cout << "Output stalls: " << asyncWriter->stalledSteps()
+                << " step(s), " << asyncWriter->totalStall() << " s\n";
+    if (amr)
+      for (int l = 1; l <= amr->numLevels(); ++l)
+        std::cout << "AMR level " << l << ": " << amr->numPatches(l)
+                  << " patches\n";
   }
+  pressureTelemetry.writeSummary();
+  if (params.profile.enabled)
+    WriteProfile();
+}
 
-  std::cout << "\nDone: " << (GET_TIME() - start) << " s\n";
+void SemiLagrangian::WriteProfile() const {
+#ifdef PIC_PROFILE
+  // Cells and bytes are totals over all ranks; times are the root's (the
+  // ranks advance in lockstep).
+  long long cells = static_cast<long long>(iEnd - iBegin) * (jEnd - jBegin);
+  double bytes = 0.0;
+  for (const OutputWriter *w : outputWriters())
+    bytes += static_cast<double>(w->bytesWritten());
+#ifdef USE_MPI
+  cells = decomp->allreduceSum(cells);
+  bytes = decomp->allreduceSum(bytes);
+#endif
+  if (!isRoot())
+    return;
+
+  nlohmann::json report =
+      profiler.report(cells, static_cast<std::uint64_t>(bytes));
+  report["solver"] = params.solver.typeName();
+  const std::string path = params.profile.file.empty()
+                               ? params.folder + "/profile.json"
+                               : params.profile.file;
+  std::error_code ec; // a failure shows up as the open below failing
+  if (const auto dir = std::filesystem::path(path).parent_path(); !dir.empty())
+    std::filesystem::create_directories(dir, ec);
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    std::cerr << "[SemiLagrangian] Warning: cannot write profile '" << path
+              << "'\n";
+    return;
+  }
+  out << report.dump(2) << '\n';
+
+  if (!params.quiet) {
+    const nlohmann::json &phases = report["phases"];
+    std::cout << "Profile: " << path << "  ("
+              << report["throughput"]["cell_updates_per_s"].get<double>() /
+                     1e6
+              << " Mcell-updates/s";
+    for (const char *name : {"project", "advect", "output"})
+      if (phases.contains(name))
+        std::cout << ", " << name << ' '
+                  << 100.0 * phases[name]["fraction"].get<double>() << '%';
+    std::cout << ")\n";
+    for (const auto &[name, phase] : phases.items())
+      if (phase.contains("counters"))
+        std::cout << "  " << name << ": IPC "
+                  << phase["counters"]["ipc"].get<double>() << ", "
+                  << phase["counters"]["arithmetic_intensity"].get<double>()
+                  << " flop/byte, "
+                  << phase["counters"]["gflops"].get<double>()
+                  << " GFLOP/s\n";
+  }
+#else
+  if (isRoot())
+    std::cerr << "[SemiLagrangian] Warning: \"profile\" requested but the "
+                 "profiler is compiled out (PIC_ENABLE_PROFILER=OFF).\n";
+#endif
 }
@@ -1,9 +1,24 @@
 #pragma once
+#include "../../core/AsyncWriter.hpp"
 #include "../../core/Fields.hpp"
 #include "../../core/OutputWriter.hpp"
 #include "../../core/Parameters.hpp"
+#include "../../core/Profiler.hpp"
+#include "../../core/Renderer.hpp"
+#include "../../core/RunningStatistics.hpp"
+#include "../../core/SceneSources.hpp"
+#include "../../core/SolverTelemetry.hpp"
+#include <deque>
+#include <fstream>
+#include <functional>
 #include <memory>
 
+#ifdef USE_MPI
+#include "../../parallel/Decomposition.hpp"
+#endif
+
+class AMRHierarchy;
+
 /**
  * @file SemiLagrangian.hpp
  * @brief Semi-Lagrangian incompressible Navier-Stokes solver on a MAC grid.
@@ -17,7 +32,42 @@
  * 1. **Project** (+MakeIncompressible): solve the pressure Poisson equation
  *    and correct velocities so that \f$\nabla \cdot \mathbf{u} \approx 0 \f$.
  * 2. **Advect**: trace departure points backward in time (RK2) and
- *    interpolate the velocity field at those points.
+ *    interpolate the velocity field at those points. With @c walls set,
+ *    the edge faces are then reset to zero normal velocity.
+ *
+ * ### Distributed runs (USE_MPI)
+ * In the @c PIC_MPI build each rank owns one block of the global grid plus
+ * @c mpi_halo ghost layers (see Decomposition2D). @c nx / @c ny are then the
+ * *local* sizes, ghosts are refreshed after every pressure sweep and before
+ * each advection, and reductions are taken over the owned cells only.
+ *
+ * ### Adaptive refinement
+ * With @c amr.enabled the solver owns an AMRHierarchy whose patches are
+ * themselves SemiLagrangian instances; they are advanced after every base
+ * step (serial builds only).
+ *
+ * ### Checkpoint / restart
+ * Every @c checkpoint.every steps the prognostic fields, labels, step
+ * counter and output-writer series are saved with Checkpoint::save(). With
+ * @c --restart the constructor maps that file back in place of the initial
+ * conditions; the restored pressure is the first solve's initial guess.
+ * AMR patches are saved and restored with them (AMRHierarchy::Save()).
+ *
+ * ### Running statistics
+ * With a @c statistics block, the selected fields are folded into a
+ * RunningStatistics after every sampled step, inside the sweep that
+ * updates the diagnostics (UpdateDiagnostics()). The results go to
+ * @c statistics_NNNN.vti at each checkpoint and at the end of the run; the
+ * accumulators themselves are saved in the checkpoint.
+ *
+ * ### Monitors
+ * With a @c monitors block, probe values, region averages and the pressure
+ * force on the SOLID cells are appended to a CSV file every
+ * @c monitors.every steps (serial builds only; see Monitors.cpp).
+ *
+ * ### Profiling
+ * Every phase of a step is timed by @c profiler (compiled out without
+ * @c PIC_PROFILE); with @c "profile" set, Run() writes the JSON report.
  */
 class SemiLagrangian {
 public:
@@ -34,6 +84,7 @@ public:
   SemiLagrangian &operator=(const SemiLagrangian &) = delete;
 
   /// @brief Run the full simulation loop (nt steps) and write output.
+  ///        After a restart the loop resumes at the checkpointed step.
   void Run();
 
   /// @brief Advance the simulation by one time step.
@@ -44,9 +95,24 @@ public:
     return *fields;
   } ///< Access fields (const).
 
+  /// @return Convergence record of the pressure solves so far.
+  [[nodiscard]] const SolverTelemetry &GetPressureTelemetry() const {
+    return pressureTelemetry;
+  }
+
+  /// @return Phase timers of this run (empty when compiled out).
+  [[nodiscard]] const Profiler &GetProfiler() const { return profiler; }
+
+  /// The pic_bench target times the private kernels one by one.
+  friend class KernelBench;
+
 private:
   const Parameters &params;
 
+#ifdef USE_MPI
+  std::unique_ptr<Decomposition2D> decomp; ///< Block layout + ghost exchange.
+#endif
+
   // Cached scalars from params to avoid pointer chasing in hot loops.
   int nx, ny;
   varType dx, dy, dt;
@@ -54,6 +120,53 @@ private:
 
   Fields2D *fields; ///< @todo Replace with std::unique_ptr<Fields2D>.
 
+  /// Tile-activity map. Every tile stays ACTIVE unless tiling is enabled,
+  /// in which case SOLID and quiescent tiles are skipped by the kernels.
+  std::unique_ptr<TileMap> tiles;
+
+  /// Refined patches over the base grid; null unless @c amr.enabled.
+  std::unique_ptr<AMRHierarchy> amr;
+
+  /// Scene sources re-imposed every step; null unless @c source.enabled.
+  std::unique_ptr<SceneSources> sources;
+
+  /// Owned cell range [iBegin, iEnd) × [jBegin, jEnd) used by reductions.
+  /// The whole grid in serial builds; excludes ghost layers under MPI.
+  int iBegin = 0, iEnd = 0, jBegin = 0, jEnd = 0;
+
+  /// Parity of the global index of local cell (0, 0), so red-black colouring
+  /// stays consistent across MPI blocks.
+  int parity = 0;
+
+  /// @brief Refresh the ghost layers of @p g (no-op in serial builds).
+  void exchangeGhosts(Grid2D &g) const {
+#ifdef USE_MPI
+    decomp->exchange(g);
+#else
+    (void)g;
+#endif
+  }
+
+  /**
+   * @brief Abort when a departure point could leave the ghost layer.
+   *
+   * The RK2 traces clamp to the local block, so under MPI a particle that
+   * moves further than @c halo - 2 cells in one step would silently sample
+   * the wrong values. Reduces max(|u| dt/dx, |v| dt/dy) over the active
+   * tiles of every rank and stops the run when it exceeds that bound.
+   * No-op in serial builds and on a single rank.
+   */
+  void checkHaloDisplacement() const;
+
+  /// @return @c true on the rank responsible for console output.
+  [[nodiscard]] bool isRoot() const {
+#ifdef USE_MPI
+    return decomp->isRoot();
+#else
+    return true;
+#endif
+  }
+
   // Output writers — null if the corresponding write_* flag is false.
   std::unique_ptr<OutputWriter> uWriter;
   std::unique_ptr<OutputWriter> vWriter;
@@ -62,16 +175,234 @@ private:
   std::unique_ptr<OutputWriter> normVelocityWriter;
   std::unique_ptr<OutputWriter> smokeWriter;
 
+  /// Single writer for all fields when @c output.combined is set (the
+  /// per-field writers above are then null).
+  std::unique_ptr<OutputWriter> fieldsWriter;
+
+  /// One writer per entry of @c output.views (empty under MPI).
+  std::vector<std::unique_ptr<OutputWriter>> viewWriters;
+
+  /// One image sequence per entry of @c render (empty under MPI).
+  std::vector<std::unique_ptr<Renderer>> renderers;
+
+  /// Per-cell mean / RMS / extrema; null unless @c statistics is set.
+  std::unique_ptr<RunningStatistics> statistics;
+  std::unique_ptr<OutputWriter> statisticsWriter; ///< Writes @c statistics.
+
+  /// Time series of @c monitors; closed when monitors are off.
+  std::ofstream monitorFile;
+
+  /// @brief A FLUID cell touching the force region's SOLID cells. Its
+  ///        pressure pushes on the solid with the signed face lengths
+  ///        @c ax (x faces) and @c ay (y faces).
+  struct ForceFace {
+    int i, j;
+    varType ax, ay;
+  };
+  std::vector<ForceFace> forceFaces; ///< Built once by InitializeMonitors().
+  double forceLength = 0.0;          ///< Reference length of Cd / Cl (m).
+
+  /// Background writer thread when @c output.async is set. Declared after
+  /// the writers so it is drained and joined before they are destroyed.
+  std::unique_ptr<AsyncWriter> asyncWriter;
+
+  /// First step run by Run(): 1, or one past the restored checkpoint.
+  int startStep = 1;
+
+  /// Step in progress (Step() advances it); times the source schedule.
+  int currentStep = 0;
+
+  /// Phase timers; mutable so the const kernels can report to it.
+  mutable Profiler profiler;
+
+  /// Convergence record of every pressure solve; writes the pressure log
+  /// when @c solver.log is set (root rank).
+  SolverTelemetry pressureTelemetry;
+  SolverTelemetry::Solve lastSolve; ///< Filled by iteratePressure().
+  bool recordHistory = false; ///< Keep the residual of every sweep.
+  bool sampleStatistics = false; ///< Step() adds a @c statistics sample.
+
   /// @brief Construct the OutputWriters requested in @c params.
   void InitializeOutputWriters();
 
+  /// @return Every non-null base-grid writer (their series are checkpointed).
+  [[nodiscard]] std::vector<OutputWriter *> outputWriters() const;
+
+  /// @return Checkpoint file for @p base — per rank under MPI.
+  [[nodiscard]] std::string checkpointFile(const std::string &base) const;
+
+  /**
+   * @brief Save fields, step and writer state to the checkpoint file.
+   * @param step Last completed time step.
+   */
+  void SaveCheckpoint(int step) const;
+
+  /// @brief Load @c params.restart into the fields and writers and set
+  ///        @c startStep (throws std::runtime_error on failure).
+  void RestoreCheckpoint();
+
+  /// @return The field called @p name ("u", "v", "p", "div",
+  ///         "normVelocity" or "smoke"), or null.
+  [[nodiscard]] const Grid2D *fieldByName(const std::string &name) const;
+
+  /// @return The grids of the @c statistics fields, in their order.
+  [[nodiscard]] std::vector<const Grid2D *> statisticsSources() const;
+
+  /**
+   * @brief Recompute @c div and @c normVelocity on the active tiles.
+   *
+   * With @p sample set, the same sweep visits every tile and adds the
+   * cells to @c statistics right after their diagnostics are computed,
+   * instead of a second pass over the grid.
+   */
+  void UpdateDiagnostics(bool sample);
+
+  /// @brief Write the statistics gathered up to @p step.
+  void WriteStatistics(int step) const;
+
   /**
-   * @brief Write all enabled fields at the current step if it falls on a
-   *        sampling interval.
+   * @brief Open the monitor CSV and collect the force faces. After a
+   *        restart, rows past the checkpointed step are dropped and new
+   *        rows are appended.
+   */
+  void InitializeMonitors();
+
+  /// @brief Append the monitor row of @p step.
+  void WriteMonitors(int step);
+
+  /// @brief Write the profiler report to @c profile.file (root rank) and
+  ///        print a one-line summary.
+  void WriteProfile() const;
+
+  /**
+   * @brief Staging for everything written at one step: grids go into a
+   *        frame of the background writer when one runs (jobs are queued),
+   *        otherwise into local storage (jobs run at once).
+   */
+  struct OutputBatch {
+    AsyncWriter::Frame *frame = nullptr; ///< Null = synchronous output.
+    std::deque<Grid2D> local;            ///< Staging without a frame.
+    std::size_t slot = 0;                ///< Next staging slot of @c frame.
+    bool ok = true;                      ///< All synchronous jobs succeeded.
+
+    /// @return A fresh @p w × @p h staging grid.
+    Grid2D &next(int w, int h) {
+      return frame ? frame->slot(slot++, w, h) : local.emplace_back(w, h);
+    }
+
+    /// @brief Queue @p job on the frame, or run it now.
+    void run(std::function<bool()> job) {
+      if (frame)
+        frame->jobs.push_back(std::move(job));
+      else
+        ok &= job();
+    }
+  };
+
+  /// @return @c true if output with sampling @p rate (0 = the global
+  ///         sampling_rate) is due at @p step.
+  [[nodiscard]] bool isDue(int rate, int step) const {
+    return step % (rate > 0 ? rate : params.sampling_rate) == 0;
+  }
+
+  /**
+   * @brief Write the enabled fields, views and images due at @p step.
    * @param step Current time-step index (0-based).
    */
   void WriteOutput(int step) const;
 
+  /**
+   * @brief Snapshot the enabled fields into the staging frame of @p batch
+   *        and queue their write jobs.
+   */
+  void queueOutput(OutputBatch &batch) const;
+
+  /**
+   * @brief Write one field through @p writer — the whole grid in serial
+   *        builds, this rank's owned piece plus a .pvti index under MPI.
+   */
+  bool writeField(OutputWriter &writer, const Grid2D &grid,
+                  const std::string &id) const;
+
+  /// @brief Multi-array variant of writeField() for combined output.
+  bool writeFields(OutputWriter &writer,
+                   const std::vector<OutputWriter::NamedGrid> &arrays) const;
+
+  /**
+   * @brief Value of @p src at the centre of cell (i, j): staggered u / v
+   *        are averaged over the two faces of the cell, the (nx-1) × (ny-1)
+   *        diagnostic grids are clamped to their last column / row.
+   */
+  [[nodiscard]] varType cellValue(const Grid2D &src, int i, int j) const {
+    if (src.nx == nx + 1)
+      return REAL_LITERAL(0.5) * (src.Get(i, j) + src.Get(i + 1, j));
+    if (src.ny == ny + 1)
+      return REAL_LITERAL(0.5) * (src.Get(i, j) + src.Get(i, j + 1));
+    return src.Get(std::min(i, src.nx - 1), std::min(j, src.ny - 1));
+  }
+
+  /**
+   * @brief Resample @p src onto the nx × ny cell centres.
+   *
+   * Staggered u / v are averaged over the two faces of each cell; the
+   * (nx-1) × (ny-1) diagnostic grids are copied with their last column / row
+   * repeated so every array shares the pressure extent.
+   */
+  void toCells(const Grid2D &src, Grid2D &out) const;
+
+  /**
+   * @brief Cell-centred copies of every enabled field, for combined output.
+   * @param nextSlot Returns a fresh nx × ny grid to fill (staging storage).
+   */
+  [[nodiscard]] std::vector<OutputWriter::NamedGrid>
+  cellArrays(const std::function<Grid2D &()> &nextSlot) const;
+
+  /**
+   * @brief Resolve a configured cell rectangle (views, monitor averages,
+   *        force region) to {i0, i1, j0, j1}, inclusive.
+   *
+   * Every region uses one convention: a negative coordinate counts from
+   * the end of its axis, -1 being the last cell (index @c nx + value).
+   * The result is clamped to the grid and is empty when @c i1 < @c i0 or
+   * @c j1 < @c j0.
+   */
+  [[nodiscard]] std::array<int, 4> cellRect(int x1, int y1, int x2,
+                                            int y2) const;
+
+  /// @return Cells covered by @p view, {ib, ie, jb, je} half-open, clamped
+  ///         to the grid (at least one cell).
+  [[nodiscard]] std::array<int, 4> viewRange(const ViewConfig &view) const;
+
+  /**
+   * @return Physical origin and spacing of @p grid written whole: cells of
+   *         dx × dy from (0, 0), shifted by half a cell along the staggered
+   *         direction of u / v so each value sits at its face.
+   */
+  [[nodiscard]] OutputWriter::Geometry gridGeometry(const Grid2D &grid) const;
+
+  /// @return Physical origin and spacing of the cells written for @p view.
+  [[nodiscard]] OutputWriter::Geometry
+  viewGeometry(const ViewConfig &view) const;
+
+  /**
+   * @brief Fill @p out with the cells of @p view taken from @p src: one
+   *        cell per stride × stride block, sampled at the block's first cell
+   *        or averaged over the block.
+   * @param out Grid of the view's output size.
+   */
+  void toView(const Grid2D &src, const ViewConfig &view, Grid2D &out) const;
+
+  /// @brief Stage and write every view due at @p step (its own sampling
+  ///        rate).
+  void writeViews(int step, OutputBatch &batch) const;
+
+  /// @brief Fill @p out (nx × ny) with the cell-centred scalar shown by
+  ///        @p cfg; masked SOLID cells are NaN.
+  void renderField(const RenderConfig &cfg, Grid2D &out) const;
+
+  /// @brief Stage and render every image sequence due at @p step.
+  void renderImages(int step, OutputBatch &batch) const;
+
   // Advection
 
   /**
@@ -138,6 +469,14 @@ private:
    */
   [[nodiscard]] varType interpolateSmoke(varType x, varType y) const;
 
+  /**
+   * @brief Bilinearly interpolate the pressure at physical position (x, y).
+   * @param x Physical x-coordinate (clamped to the domain).
+   * @param y Physical y-coordinate (clamped to the domain).
+   * @return  Interpolated pressure.
+   */
+  [[nodiscard]] varType interpolateP(varType x, varType y) const;
+
 
   /**
    * @brief Return both velocity components at physical position (x, y).
@@ -171,6 +510,15 @@ private:
    */
   void updateVelocities();
 
+  /**
+   * @brief Zero the normal velocity on the global domain edges
+   *        (@c params.walls).
+   *
+   * Advection extrapolates the outermost faces from the interior, which
+   * leaves the right and top edges open; this closes all four.
+   */
+  void applyWalls();
+
   /**
    * @brief Compute the RMS residual of the discrete Poisson equation.
    *
@@ -180,7 +528,8 @@ private:
    *              - N\,p_{ij} \f$
    *
    * @param coef  Scaling coefficient \f$\rho\,\Delta x^2 / \Delta t \f$.
-   * @return RMS residual over all FLUID cells (0 if none).
+   * @return RMS residual over all FLUID cells (0 if none), reduced over all
+   *         ranks in MPI builds.
    */
   [[nodiscard]] double computeResidualNorm(varType coef) const;
 
@@ -198,6 +547,25 @@ private:
    */
   [[nodiscard]] double getUpdate(int i, int j, varType coef) const;
 
+  /// @brief One Jacobi sweep into @p pNew, copied back to the FLUID cells
+  ///        of p.
+  void sweepJacobi(varType coef, Grid2D &pNew);
+
+  /// @brief One lexicographic Gauss-Seidel sweep over p (sequential).
+  void sweepGaussSeidel(varType coef);
+
+  /// @brief One red-black Gauss-Seidel sweep: both colours, in parallel.
+  void sweepRedBlack(varType coef);
+
+  /**
+   * @brief Run @p sweep until the relative residual drops below @p tol or
+   *        @p maxIters sweeps are done, and fill @c lastSolve.
+   * @param name  Solver name for debug output.
+   * @param sweep One smoother sweep, given the Poisson coefficient.
+   */
+  void iteratePressure(const char *name, int maxIters, double tol,
+                       const std::function<void(varType)> &sweep);
+
   /// @brief Jacobi pressure solver (fully parallel, slower convergence).
   void SolveJacobi(int maxIters, double tol);
 